@@ -0,0 +1,151 @@
+package spinal.lib.eda.yosys
+
+import java.io.File
+
+import org.apache.commons.io.FileUtils
+import org.yaml.snakeyaml.Yaml
+import spinal.core._
+import spinal.lib.eda.bench.{Report, Rtl, Target}
+import spinal.lib.eda.icestorm.IcestormFlow
+
+import scala.collection.mutable.ArrayBuffer
+import scala.collection.Seq
+
+//Synthesis and place and route report of the open source flow, with the resources split by kind
+trait YosysNextpnrReport extends Report{
+  def getLuts() : Int
+  def getFfs() : Int
+  def getBrams() : Int
+}
+
+//Yosys + nextpnr flow for the iCE40 and ECP5 families.
+//The resources are counted by yosys (stat -json) after the technology mapping and the Fmax is the slowest clock of
+//the nextpnr JSON report. The nextpnr seed is fixed to keep the results comparable between runs.
+object YosysNextpnrFlow {
+  //lutCells give the number of LUT used by each cell kind (ex. an ECP5 carry cell use two LUT)
+  case class Family(name : String, yosysSynth : String, nextpnr : String, lutCells : Map[String, Int], ffPrefixes : Seq[String], bramCells : Seq[String])
+
+  val ice40 = Family(
+    name = "ice40",
+    yosysSynth = "synth_ice40",
+    nextpnr = "nextpnr-ice40",
+    lutCells = Map("SB_LUT4" -> 1),
+    ffPrefixes = List("SB_DFF"),
+    bramCells = List("SB_RAM40_4K", "SB_SPRAM256KA")
+  )
+
+  val ecp5 = Family(
+    name = "ecp5",
+    yosysSynth = "synth_ecp5",
+    nextpnr = "nextpnr-ecp5",
+    lutCells = Map("LUT4" -> 1, "CCU2C" -> 2),
+    ffPrefixes = List("TRELLIS_FF"),
+    bramCells = List("DP16KD", "PDPW16KD")
+  )
+
+  def apply(workspacePath : String,
+            toplevelPath : String,
+            family : Family,
+            nextpnrArgs : Seq[String],
+            frequencyTarget : HertzNumber,
+            seed : Int = 1) : YosysNextpnrReport = {
+    val projectName = toplevelPath.split("/").last.split("[.]").head
+    val workspacePathFile = new File(workspacePath)
+    FileUtils.deleteDirectory(workspacePathFile)
+    workspacePathFile.mkdirs()
+    FileUtils.copyFileToDirectory(new File(toplevelPath), workspacePathFile)
+
+    IcestormFlow.doCmd(List("yosys", "-q", "-p", s"${family.yosysSynth} -top $projectName -json $projectName.json; tee -q -o stat.json stat -json", s"$projectName.v"), workspacePath)
+    IcestormFlow.doCmd(List(family.nextpnr) ++ nextpnrArgs ++ List(
+      "--json", s"$projectName.json",
+      "--freq", (frequencyTarget.toDouble / 1e6).toString,
+      "--seed", seed.toString,
+      "--timing-allow-fail",
+      "--report", "report.json"
+    ), workspacePath)
+
+    //Both files are JSON, which snakeyaml parses as YAML. Logs lines around the stat JSON are skipped
+    def load(file : String) : java.util.Map[String, Any] = {
+      try {
+        val text = FileUtils.readFileToString(new File(workspacePath, file))
+        new Yaml().load(text.substring(text.indexOf('{'), text.lastIndexOf('}') + 1)).asInstanceOf[java.util.Map[String, Any]]
+      } catch {
+        case e : Throwable => null
+      }
+    }
+    def child(map : java.util.Map[String, Any], key : String) : java.util.Map[String, Any] = {
+      if(map == null) null else map.get(key).asInstanceOf[java.util.Map[String, Any]]
+    }
+
+    val cells = child(child(load("stat.json"), "design"), "num_cells_by_type")
+    def count(weight : String => Int) : Int = {
+      if(cells == null) return -1
+      var sum = 0
+      val it = cells.entrySet().iterator()
+      while(it.hasNext){
+        val e = it.next()
+        sum += weight(e.getKey) * e.getValue.toString.toInt
+      }
+      sum
+    }
+
+    val fmax = {
+      val clocks = child(load("report.json"), "fmax")
+      if(clocks == null || clocks.isEmpty) -1.0 else {
+        var min = Double.MaxValue
+        val it = clocks.values().iterator()
+        while(it.hasNext){
+          val achieved = it.next().asInstanceOf[java.util.Map[String, Any]].get("achieved").toString.toDouble
+          min = Math.min(min, achieved)
+        }
+        min * 1e6
+      }
+    }
+
+    new YosysNextpnrReport {
+      val luts = count(family.lutCells.getOrElse(_, 0))
+      val ffs = count(name => if(family.ffPrefixes.exists(name.startsWith)) 1 else 0)
+      val brams = count(name => if(family.bramCells.contains(name)) 1 else 0)
+      override def getLuts() = luts
+      override def getFfs() = ffs
+      override def getBrams() = brams
+      override def getFMax() = fmax
+      override def getArea() = if(luts < 0) "error" else s"$luts LUT $ffs FF $brams BRAM"
+    }
+  }
+}
+
+//The iCE40 targets keep the IO on pins, the ECP5 ones are placed out of context, as the bigger CPUs have more IO than pins
+object YosysNextpnrStdTargets {
+  def apply(): Seq[Target] = {
+    val targets = ArrayBuffer[Target]()
+
+    targets += new Target {
+      override def getFamilyName(): String = "iCE40 hx8k"
+      override def synthesise(rtl: Rtl, workspace: String): Report = {
+        YosysNextpnrFlow(
+          workspacePath = workspace,
+          toplevelPath = rtl.getRtlPath(),
+          family = YosysNextpnrFlow.ice40,
+          nextpnrArgs = List("--hx8k", "--package", "ct256", "--pcf-allow-unconstrained"),
+          frequencyTarget = 100 MHz
+        )
+      }
+    }
+
+    targets += new Target {
+      override def getFamilyName(): String = "ECP5 25k"
+      override def synthesise(rtl: Rtl, workspace: String): Report = {
+        YosysNextpnrFlow(
+          workspacePath = workspace,
+          toplevelPath = rtl.getRtlPath(),
+          family = YosysNextpnrFlow.ecp5,
+          nextpnrArgs = List("--25k", "--package", "CABGA381", "--out-of-context"),
+          frequencyTarget = 200 MHz
+        )
+      }
+    }
+
+    targets
+  }
+}
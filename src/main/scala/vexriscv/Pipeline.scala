@@ -18,6 +18,7 @@ trait Pipeline {
 //  val services = ArrayBuffer[Any]()
 
   def stageBefore(stage : Stage) = stages(indexOf(stage)-1)
+  def stageAfter(stage : Stage) = stages(indexOf(stage)+1)
 
   def indexOf(stage : Stage) = stages.indexOf(stage)
 
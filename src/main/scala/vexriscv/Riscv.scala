@@ -121,6 +121,55 @@ object Riscv{
   def FENCE_I            = M"-----------------001-----0001111"
   def SFENCE_VMA         = M"0001001----------000000001110011"
 
+  def CBO_INVAL          = M"000000000000-----010000000001111"
+  def CBO_CLEAN          = M"000000000001-----010000000001111"
+  def CBO_FLUSH          = M"000000000010-----010000000001111"
+  def CBO_ZERO           = M"000000000100-----010000000001111"
+  def PREFETCH_I         = M"-------00000-----110000000010011"
+  def PREFETCH_R         = M"-------00001-----110000000010011"
+  def PREFETCH_W         = M"-------00011-----110000000010011"
+
+  //Vector, Zve32x subset, unmasked only
+  def VSETVLI            = M"0----------------111-----1010111"
+  def VSETIVLI           = M"11---------------111-----1010111"
+  def VSETVL             = M"1000000----------111-----1010111"
+  def VADD_VV            = M"0000001----------000-----1010111"
+  def VADD_VX            = M"0000001----------100-----1010111"
+  def VADD_VI            = M"0000001----------011-----1010111"
+  def VSUB_VV            = M"0000101----------000-----1010111"
+  def VSUB_VX            = M"0000101----------100-----1010111"
+  def VAND_VV            = M"0010011----------000-----1010111"
+  def VAND_VX            = M"0010011----------100-----1010111"
+  def VAND_VI            = M"0010011----------011-----1010111"
+  def VOR_VV             = M"0010101----------000-----1010111"
+  def VOR_VX             = M"0010101----------100-----1010111"
+  def VOR_VI             = M"0010101----------011-----1010111"
+  def VXOR_VV            = M"0010111----------000-----1010111"
+  def VXOR_VX            = M"0010111----------100-----1010111"
+  def VXOR_VI            = M"0010111----------011-----1010111"
+  def VMV_V_V            = M"010111100000-----000-----1010111"
+  def VMV_V_X            = M"010111100000-----100-----1010111"
+  def VMV_V_I            = M"010111100000-----011-----1010111"
+  def VMUL_VV            = M"1001011----------010-----1010111"
+  def VMUL_VX            = M"1001011----------110-----1010111"
+  def VMACC_VV           = M"1011011----------010-----1010111"
+  def VMACC_VX           = M"1011011----------110-----1010111"
+  def VREDSUM_VS         = M"0000001----------010-----1010111"
+  def VMV_X_S            = M"0100001-----00000010-----1010111"
+  def VMV_S_X            = M"010000100000-----110-----1010111"
+  def VLE8               = M"000000100000-----000-----0000111"
+  def VLE16              = M"000000100000-----101-----0000111"
+  def VLE32              = M"000000100000-----110-----0000111"
+  def VLSE8              = M"0000101----------000-----0000111"
+  def VLSE16             = M"0000101----------101-----0000111"
+  def VLSE32             = M"0000101----------110-----0000111"
+  def VSE8               = M"000000100000-----000-----0100111"
+  def VSE16              = M"000000100000-----101-----0100111"
+  def VSE32              = M"000000100000-----110-----0100111"
+  def VSSE8              = M"0000101----------000-----0100111"
+  def VSSE16             = M"0000101----------101-----0100111"
+  def VSSE32             = M"0000101----------110-----0100111"
+
   def FMV_W_X            = M"111100000000-----000-----1010011"
   def FADD_S             = M"0000000------------------1010011"
   def FSUB_S             = M"0000100------------------1010011"
@@ -22,6 +22,7 @@ trait VexRiscvRegressionArg{
 }
 case class VexRiscvConfig(){
   var withMemoryStage = true
+  var withMemoryDataStage = false //Split the memory stage in two, the data cache give its load result one stage before the write back
   var withWriteBackStage = true
   val plugins = ArrayBuffer[Plugin[VexRiscv]]()
 
@@ -137,7 +138,9 @@ class VexRiscv(val config : VexRiscvConfig) extends Component with Pipeline{
   val decode    = newStage()
   val execute   = newStage()
   val memory    = ifGen(config.withMemoryStage)    (newStage())
+  val memoryData = ifGen(config.withMemoryDataStage) (newStage())
   val writeBack = ifGen(config.withWriteBackStage) (newStage())
+  assert(!withMemoryDataStage || withMemoryStage && withWriteBackStage, "The memory data stage need both the memory and the write back stages")
 
   def stagesFromExecute = stages.dropWhile(_ != execute)
 
@@ -154,6 +157,9 @@ class VexRiscv(val config : VexRiscvConfig) extends Component with Pipeline{
   if(withMemoryStage){
     memory.arbitration.removeIt.noBackendCombMerge
   }
+  if(withMemoryDataStage){
+    memoryData.arbitration.removeIt.noBackendCombMerge
+  }
   execute.arbitration.flushNext.noBackendCombMerge
 }
 
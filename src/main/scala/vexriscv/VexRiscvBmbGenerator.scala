@@ -6,6 +6,7 @@ import spinal.lib.bus.misc.AddressMapping
 import spinal.lib.com.jtag.{Jtag, JtagTapInstructionCtrl}
 import spinal.lib.generator._
 import spinal.lib.{sexport, slave}
+import vexriscv.ip.{BmbSnoopFilter, BmbSnoopFilterCounters}
 import vexriscv.plugin._
 import spinal.core.fiber._
 import spinal.lib.cpu.riscv.debug.DebugHartBus
@@ -28,6 +29,8 @@ case class VexRiscvBmbGenerator()(implicit interconnectSmp: BmbInterconnectGener
   val debugReset = Handle[Bool]
   val debugAskReset = Handle[() => Unit]
   val hardwareBreakpointCount = Handle.sync(0)
+  val snoopFilterEntries = Handle.sync(0) //0 disable the data cache snoop filter
+  val snoopFilterCounters = Handle[BmbSnoopFilterCounters]
 
   val iBus, dBus = Handle[Bmb]
 
@@ -137,7 +140,14 @@ case class VexRiscvBmbGenerator()(implicit interconnectSmp: BmbInterconnectGener
         doExport(plugin.config.bytePerLine, "bytesPerLine")
       }
       case plugin: DBusCachedPlugin => {
-        dBus.load(plugin.dBus.toBmb())
+        if(snoopFilterEntries.get != 0 && plugin.config.withInvalidate) {
+          val snoopFilter = BmbSnoopFilter(plugin.config.getBmbParameter(), snoopFilterEntries.get, plugin.config.bytePerLine, trackWrites = plugin.config.withCacheBlockOps)
+          snoopFilter.io.input << plugin.dBus.toBmb()
+          dBus.load(snoopFilter.io.output)
+          snoopFilterCounters.load(snoopFilter.io.counters)
+        } else {
+          dBus.load(plugin.dBus.toBmb())
+        }
         doExport(plugin.config.wayCount, "dcacheWays")
         doExport(plugin.config.cacheSize, "dcacheSize")
         doExport(plugin.config.bytePerLine, "bytesPerLine")
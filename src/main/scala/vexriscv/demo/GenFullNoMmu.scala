@@ -9,7 +9,7 @@ import spinal.core._
  * Created by spinalvm on 15.06.17.
  */
 object GenFullNoMmu extends App{
-  def cpu() = new VexRiscv(
+  def cpu(victimLineCount : Int = 0) = new VexRiscv(
     config = VexRiscvConfig(
       plugins = List(
         new PcManagerSimplePlugin(
@@ -42,7 +42,8 @@ object GenFullNoMmu extends App{
             memDataWidth      = 32,
             catchAccessError  = true,
             catchIllegal      = true,
-            catchUnaligned    = true
+            catchUnaligned    = true,
+            victimLineCount   = victimLineCount
           )
         ),
         new StaticMemoryTranslatorPlugin(
@@ -35,10 +35,15 @@ import vexriscv.{VexRiscv, VexRiscvConfig, plugin}
  *
  * echo "Ready for Remote Connections"
  * ##############################################
+ *
+ * With the --dmi argument, the JTAG TAP is replaced by a direct Debug Module Interface port, which the regression drives
+ * in process (program download, register dumps) without any openocd :
+ * - sbt "runMain vexriscv.demo.GenFullWithOfficialRiscvDebug --dmi"
+ * - make IBUS=CACHED IBUS_DATA_WIDTH=32 COMPRESSED=no DBUS=CACHED DBUS_LOAD_DATA_WIDTH=32 DBUS_STORE_DATA_WIDTH=32 MUL=yes DIV=yes SUPERVISOR=no CSR=yes WITH_RISCV_REF=no DEBUG_PLUGIN=no VEXRISCV_JTAG=yes
  */
 
 object GenFullWithOfficialRiscvDebug extends App{
-  def config = VexRiscvConfig(
+  def config(withDmi : Boolean) = VexRiscvConfig(
     plugins = List(
       new IBusCachedPlugin(
         prediction = DYNAMIC,
@@ -112,7 +117,7 @@ object GenFullWithOfficialRiscvDebug extends App{
         ),
         debugCd = ClockDomain.current.copy(reset = Bool().setName("debugReset")),
         withTunneling = false,
-        withTap = true
+        withTap = !withDmi
       ),
       new BranchPlugin(
         earlyBranch = false,
@@ -122,7 +127,7 @@ object GenFullWithOfficialRiscvDebug extends App{
     )
   )
 
-  def cpu() = new VexRiscv(config)
+  def cpu(withDmi : Boolean = false) = new VexRiscv(config(withDmi))
 
-  SpinalVerilog(cpu())
+  SpinalVerilog(cpu(withDmi = args.contains("--dmi")))
 }
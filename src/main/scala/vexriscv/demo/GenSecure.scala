@@ -41,7 +41,8 @@ object GenSecure extends App {
         ),
         new PmpPlugin(
           regions = 16,
-          ioRange = _(31 downto 28) === 0xf
+          ioRange = _(31 downto 28) === 0xf,
+          pipelined = true
         ),
         new DecoderSimplePlugin(
           catchIllegalInstruction = true
@@ -0,0 +1,157 @@
+package vexriscv.demo
+
+import java.io.File
+import java.text.SimpleDateFormat
+import java.util.Date
+
+import org.apache.commons.io.FileUtils
+import org.yaml.snakeyaml.Yaml
+import spinal.core._
+import spinal.lib.eda.bench.Rtl
+import spinal.lib.eda.yosys.{YosysNextpnrReport, YosysNextpnrStdTargets}
+
+import scala.collection.mutable.ArrayBuffer
+import scala.sys.process._
+
+/**
+ * Synthesis bench of the demo CPUs with the open source flow (yosys + nextpnr), usable where the vendor toolchains of
+ * the VexRiscvSynthesisBench aren't available.
+ *
+ * Each run is appended to a JSON history with the LUT, FF, BRAM and Fmax of every CPU on every target, and compared to
+ * the last recorded result of the same CPU and target. An Fmax drop or an area growth over the tolerances is reported
+ * as a regression, and the bench then exits with an error code.
+ *
+ * Arguments :
+ * --history FILE        JSON history, default synthesisHistory.json
+ * --rtl NAME            Only bench the given CPU, can be repeated
+ * --target NAME         Only bench the given target (family name), can be repeated
+ * --fmax-tolerance R    Relative Fmax drop allowed, default 0.03
+ * --area-tolerance R    Relative LUT/FF growth allowed, default 0.02
+ * --workspace PATH      Synthesis workspace, default openSynthesisWorkspace
+ * --no-record           Compare without appending the run to the history
+ */
+object VexRiscvOpenSynthesisBench {
+  case class Result(rtl : String, target : String, luts : Int, ffs : Int, brams : Int, fmax : Double){
+    def isValid = luts >= 0 && fmax > 0
+    def fmaxMhz = BigDecimal(fmax / 1e6).setScale(2, BigDecimal.RoundingMode.HALF_UP)
+    def toJson = s"""{"rtl": "$rtl", "target": "$target", "luts": $luts, "ffs": $ffs, "brams": $brams, "fmax": $fmaxMhz}"""
+  }
+
+  case class Run(date : String, commit : String, results : Seq[Result]){
+    def toJson = s"""  {"date": "$date", "commit": "$commit", "results": [\n""" + results.map("    " + _.toJson).mkString(",\n") + "\n  ]}"
+  }
+
+  def rtl(name : String)(cpu : => Component) = name -> (() => new Rtl {
+    override def getName(): String = name
+    override def getRtlPath(): String = s"VexRiscvOpen_$name.v"
+    SpinalVerilog(cpu.setDefinitionName(getRtlPath().split("\\.").head))
+  })
+
+  val rtls = List(
+    rtl("smallest")(GenSmallest.cpu()),
+    rtl("smallAndProductive")(GenSmallAndProductive.cpu()),
+    rtl("smallAndProductiveICache")(GenSmallAndProductiveICache.cpu()),
+    rtl("fullNoMmuNoCache")(GenFullNoMmuNoCache.cpu()),
+    rtl("fullNoMmu")(GenFullNoMmu.cpu()),
+    rtl("fullNoMmuDeep")(GenFullNoMmuDeep.cpu()),
+    rtl("full")(GenFull.cpu()),
+    rtl("secure")(GenSecure.cpu())
+  )
+
+  def loadHistory(file : File) : ArrayBuffer[Run] = {
+    val runs = ArrayBuffer[Run]()
+    if(!file.exists()) return runs
+    val list = new Yaml().load(FileUtils.readFileToString(file)).asInstanceOf[java.util.List[java.util.Map[String, Any]]]
+    for(runId <- 0 until list.size()){
+      val run = list.get(runId)
+      val results = run.get("results").asInstanceOf[java.util.List[java.util.Map[String, Any]]]
+      runs += Run(
+        date = run.get("date").toString,
+        commit = run.get("commit").toString,
+        results = for(resultId <- 0 until results.size(); r = results.get(resultId)) yield Result(
+          rtl = r.get("rtl").toString,
+          target = r.get("target").toString,
+          luts = r.get("luts").toString.toInt,
+          ffs = r.get("ffs").toString.toInt,
+          brams = r.get("brams").toString.toInt,
+          fmax = r.get("fmax").toString.toDouble * 1e6
+        )
+      )
+    }
+    runs
+  }
+
+  def saveHistory(file : File, runs : Seq[Run]) : Unit = {
+    FileUtils.writeStringToFile(file, runs.map(_.toJson).mkString("[\n", ",\n", "\n]\n"))
+  }
+
+  //Give the regressions of the result against the given reference
+  def compare(result : Result, reference : Result, fmaxTolerance : Double, areaTolerance : Double) : Seq[String] = {
+    val issues = ArrayBuffer[String]()
+    def grown(value : Int, ref : Int) = value > ref * (1 + areaTolerance) && value > ref
+    if(!result.isValid) issues += "synthesis failed"
+    else {
+      if(result.fmax < reference.fmax * (1 - fmaxTolerance)) issues += s"Fmax ${reference.fmaxMhz} -> ${result.fmaxMhz} MHz"
+      if(grown(result.luts, reference.luts)) issues += s"LUT ${reference.luts} -> ${result.luts}"
+      if(grown(result.ffs, reference.ffs)) issues += s"FF ${reference.ffs} -> ${result.ffs}"
+      if(result.brams > reference.brams) issues += s"BRAM ${reference.brams} -> ${result.brams}"
+    }
+    issues.toList
+  }
+
+  def main(args: Array[String]) {
+    var historyPath = "synthesisHistory.json"
+    var workspace = "openSynthesisWorkspace"
+    var fmaxTolerance = 0.03
+    var areaTolerance = 0.02
+    var record = true
+    val rtlFilter, targetFilter = ArrayBuffer[String]()
+
+    def parse(list : List[String]) : Unit = list match {
+      case "--history" :: value :: tail => historyPath = value; parse(tail)
+      case "--workspace" :: value :: tail => workspace = value; parse(tail)
+      case "--rtl" :: value :: tail => rtlFilter += value; parse(tail)
+      case "--target" :: value :: tail => targetFilter += value; parse(tail)
+      case "--fmax-tolerance" :: value :: tail => fmaxTolerance = value.toDouble; parse(tail)
+      case "--area-tolerance" :: value :: tail => areaTolerance = value.toDouble; parse(tail)
+      case "--no-record" :: tail => record = false; parse(tail)
+      case Nil =>
+      case unknown :: _ => throw new Exception(s"Unknown argument $unknown")
+    }
+    parse(args.toList)
+
+    val historyFile = new File(historyPath)
+    val history = loadHistory(historyFile)
+    val targets = YosysNextpnrStdTargets().filter(t => targetFilter.isEmpty || targetFilter.contains(t.getFamilyName()))
+    val results = ArrayBuffer[Result]()
+
+    for((name, gen) <- rtls if rtlFilter.isEmpty || rtlFilter.contains(name)){
+      val rtl = gen()
+      for(target <- targets) {
+        val report = target.synthesise(rtl, s"$workspace/${name}_${target.getFamilyName().replace(' ', '_')}").asInstanceOf[YosysNextpnrReport]
+        results += Result(name, target.getFamilyName(), report.getLuts(), report.getFfs(), report.getBrams(), report.getFMax())
+      }
+    }
+
+    var regressions = 0
+    println(f"${"CPU"}%-26s ${"Target"}%-12s ${"LUT"}%7s ${"FF"}%7s ${"BRAM"}%5s ${"Fmax"}%8s")
+    for(result <- results){
+      val reference = history.reverseIterator.flatMap(_.results).find(r => r.rtl == result.rtl && r.target == result.target && r.isValid)
+      //A failed synthesis is a regression even without history for that target
+      val issues = if(!result.isValid) List("synthesis failed") else reference.map(compare(result, _, fmaxTolerance, areaTolerance)).getOrElse(Nil)
+      regressions += issues.size
+      println(f"${result.rtl}%-26s ${result.target}%-12s ${result.luts}%7d ${result.ffs}%7d ${result.brams}%5d ${result.fmaxMhz}%8s" + issues.map("  REGRESSION " + _).mkString)
+    }
+
+    if(record) {
+      val commit = try { "git rev-parse --short HEAD".!!.trim } catch { case e : Throwable => "unknown" }
+      history += Run(new SimpleDateFormat("yyyy-MM-dd HH:mm").format(new Date()), commit, results.toList)
+      saveHistory(historyFile, history)
+    }
+
+    if(regressions != 0) {
+      println(s"$regressions SYNTHESIS REGRESSION(S)")
+      System.exit(1)
+    }
+  }
+}
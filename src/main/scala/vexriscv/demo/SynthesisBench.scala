@@ -172,6 +172,12 @@ object VexRiscvSynthesisBench {
       SpinalVerilog(wrap(GenFullNoMmu.cpu()).setDefinitionName(getRtlPath().split("\\.").head))
     }
 
+    val fullNoMmuDeep = new Rtl {
+      override def getName(): String = "VexRiscv full no MMU deep pipeline"
+      override def getRtlPath(): String = "VexRiscvFullNoMmuDeep.v"
+      SpinalVerilog(wrap(GenFullNoMmuDeep.cpu()).setDefinitionName(getRtlPath().split("\\.").head))
+    }
+
     val noCacheNoMmuMaxPerf= new Rtl {
       override def getName(): String = "VexRiscv no cache no MMU max perf"
       override def getRtlPath(): String = "VexRiscvNoCacheNoMmuMaxPerf.v"
@@ -277,7 +283,7 @@ object VexRiscvSynthesisBench {
 //      linuxFpuSmp, linuxFpuSmpNoDecoder, linuxFpuSmpStupidDecoder
       twoStage, twoStageBarell, twoStageMulDiv, twoStageAll,
       threeStage, threeStageBarell, threeStageMulDiv, threeStageAll,
-      smallestNoCsr, smallest, smallAndProductive, smallAndProductiveWithICache, fullNoMmuNoCache, noCacheNoMmuMaxPerf, fullNoMmuMaxPerf, fullNoMmu, full, linuxBalanced, linuxBalancedSmp
+      smallestNoCsr, smallest, smallAndProductive, smallAndProductiveWithICache, fullNoMmuNoCache, noCacheNoMmuMaxPerf, fullNoMmuMaxPerf, fullNoMmu, fullNoMmuDeep, full, linuxBalanced, linuxBalancedSmp
     )
 //    val rtls = List(linuxBalanced, linuxBalancedSmp)
 //    val rtls = List(smallest)
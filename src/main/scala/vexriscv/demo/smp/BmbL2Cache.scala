@@ -0,0 +1,368 @@
+package vexriscv.demo.smp
+
+import spinal.core._
+import spinal.core.fiber._
+import spinal.lib._
+import spinal.lib.bus.bmb._
+import spinal.lib.bus.misc.AddressMapping
+import spinal.lib.fsm._
+
+
+case class BmbL2CacheParameter(cacheSize : Int,
+                               wayCount : Int,
+                               bankCount : Int,
+                               bytePerLine : Int = 64,
+                               orderQueueDepth : Int = 16){
+  assert(isPow2(cacheSize) && isPow2(wayCount) && isPow2(bankCount) && isPow2(bytePerLine))
+  def lineCount = cacheSize/bankCount/wayCount/bytePerLine //Per bank and per way
+  assert(lineCount >= 2)
+}
+
+case class BmbL2CacheCounters() extends Bundle{
+  val hits, misses, evictions = UInt(32 bits)
+}
+
+object BmbL2Cache{
+  def outputAccessParameter(p : BmbL2CacheParameter, input : BmbAccessParameter) = BmbAccessParameter(
+    addressWidth = input.addressWidth,
+    dataWidth = input.dataWidth
+  ).addSources(p.bankCount, BmbSourceParameter(
+    contextWidth = 0,
+    lengthWidth = log2Up(p.bytePerLine),
+    canWrite = true,
+    alignment = BmbParameter.BurstAlignement.LENGTH,
+    maximumPendingTransaction = 1
+  ))
+}
+
+//Shared write back cache, interleaved by line on independent banks. Each bank serve one access at the time, while the
+//responses are kept in the commands order. Every memory master has to go through it, as nothing keep the external memory
+//coherent with its content.
+case class BmbL2Cache(p : BmbL2CacheParameter, inputParameter : BmbParameter) extends Component{
+  import p._
+  val outputParameter = BmbL2Cache.outputAccessParameter(p, inputParameter.access).toBmbParameter()
+
+  val io = new Bundle {
+    val input = slave(Bmb(inputParameter))
+    val output = master(Bmb(outputParameter))
+    val counters = out(Vec(BmbL2CacheCounters(), bankCount))
+  }
+
+  val addressWidth = inputParameter.access.addressWidth
+  val wordBytes = inputParameter.access.dataWidth/8
+  val wordPerLine = bytePerLine/wordBytes
+  assert(inputParameter.access.lengthWidth <= log2Up(bytePerLine), "The L2 cache lines have to be at least as big as the accesses")
+  assert(inputParameter.access.alignment == BmbParameter.BurstAlignement.LENGTH, "The L2 cache wraps the bursts inside a line, they have to be aligned on their length")
+
+  val wordRange = log2Up(bytePerLine)-1 downto log2Up(wordBytes)
+  val bankRange = log2Up(bytePerLine) + log2Up(bankCount) - 1 downto log2Up(bytePerLine)
+  val lineRange = bankRange.high + log2Up(lineCount) downto bankRange.high + 1
+  val tagRange = addressWidth-1 downto lineRange.high+1
+
+  def bankOf(address : UInt) = if(bankCount == 1) U(0, 0 bits) else address(bankRange)
+
+  case class Tag() extends Bundle{
+    val valid, dirty = Bool()
+    val address = UInt(tagRange.length bits)
+  }
+
+  class Bank(bankId : Int) extends Area{
+    val cmd = Stream(Fragment(BmbCmd(inputParameter)))
+    val rsp = Stream(Fragment(BmbRsp(inputParameter)))
+    val memCmd = Stream(Fragment(BmbCmd(outputParameter)))
+    val memRsp = Stream(Fragment(BmbRsp(outputParameter)))
+
+    val tags = Seq.fill(wayCount)(Mem(Tag(), lineCount))
+    val data = Mem(Bits(inputParameter.access.dataWidth bits), wayCount*lineCount*wordPerLine)
+
+    val tagWrite = Flow(new Bundle{
+      val line = UInt(log2Up(lineCount) bits)
+      val ways = Bits(wayCount bits)
+      val data = Tag()
+    })
+    tagWrite.valid := False
+    tagWrite.payload.assignDontCare()
+    for((tag, wayId) <- tags.zipWithIndex) tag.write(tagWrite.line, tagWrite.data, tagWrite.valid && tagWrite.ways(wayId))
+
+    val dataWrite = Flow(new Bundle{
+      val address = UInt(log2Up(wayCount*lineCount*wordPerLine) bits)
+      val data = Bits(inputParameter.access.dataWidth bits)
+      val mask = Bits(wordBytes bits)
+    })
+    dataWrite.valid := False
+    dataWrite.payload.assignDontCare()
+    data.write(dataWrite.address, dataWrite.data, dataWrite.valid, dataWrite.mask)
+
+    val dataRead = Stream(UInt(log2Up(wayCount*lineCount*wordPerLine) bits))
+    dataRead.valid := False
+    dataRead.payload.assignDontCare()
+    val dataReadRsp = data.streamReadSync(dataRead)
+    dataReadRsp.ready := False
+
+    //Header of the access being served, as the write fragments are consumed before its response
+    val address = Reg(UInt(addressWidth bits))
+    val length = Reg(UInt(inputParameter.access.lengthWidth bits))
+    val source = Reg(UInt(inputParameter.access.sourceWidth bits))
+    val context = Reg(Bits(inputParameter.access.contextWidth bits))
+    val isWrite = Reg(Bool())
+    val way = Reg(UInt(log2Up(wayCount) bits))
+    val victim = Counter(wayCount)
+    val evictAddress = Reg(UInt(tagRange.length bits))
+    val failed = Reg(Bool())
+
+    def line = address(lineRange)
+    def wordAddress(word : UInt) = way @@ line @@ word.resize(log2Up(wordPerLine))
+    val firstWord = address(wordRange)
+    val beatsMinusOne = (((U"0" @@ length) + address(log2Up(wordBytes)-1 downto 0)) >> log2Up(wordBytes)).resize(log2Up(wordPerLine) + 1)
+    val readIssued = Reg(UInt(log2Up(wordPerLine) + 1 bits))
+    val beat = Reg(UInt(log2Up(wordPerLine) + 1 bits))
+
+    val tagsRead = Vec(tags.map(_.readSync(cmd.address(lineRange))))
+    val waysHits = B(tagsRead.map(t => t.valid && t.address === address(tagRange)))
+
+    val counters = new Area{
+      val hits, misses, evictions = Reg(UInt(32 bits)) init(0)
+      io.counters(bankId).hits := hits
+      io.counters(bankId).misses := misses
+      io.counters(bankId).evictions := evictions
+    }
+
+    cmd.ready := False
+    rsp.valid := False
+    rsp.last := True
+    rsp.source := source
+    rsp.context := context
+    rsp.setSuccess()
+    rsp.data := dataReadRsp.payload
+    when(failed){
+      rsp.setError()
+    }
+
+    memCmd.valid := False
+    memCmd.last := True
+    memCmd.source := bankId
+    memCmd.context := 0
+    memCmd.opcode := Bmb.Cmd.Opcode.READ
+    memCmd.address := address(tagRange.high downto log2Up(bytePerLine)) @@ U(0, log2Up(bytePerLine) bits)
+    memCmd.length := bytePerLine-1
+    memCmd.data := dataReadRsp.payload
+    memCmd.mask.setAll()
+    memRsp.ready := False
+
+    val fsm = new StateMachine{
+      val init = new State with EntryPoint
+      val idle, lookup, evict, evictRsp, refillCmd, refill, read, write, writeRsp = new State
+
+      val initCounter = Reg(UInt(log2Up(lineCount) + 1 bits)) init(0)
+      init.whenIsActive{
+        tagWrite.valid := True
+        tagWrite.line := initCounter.resized
+        tagWrite.ways.setAll()
+        tagWrite.data.valid := False
+        initCounter := initCounter + 1
+        when(initCounter === lineCount-1){
+          goto(idle)
+        }
+      }
+
+      idle.whenIsActive{
+        when(cmd.valid){
+          address := cmd.address
+          length := cmd.length
+          source := cmd.source
+          context := cmd.context
+          isWrite := cmd.isWrite
+          failed := False
+          goto(lookup)
+        }
+      }
+
+      lookup.onExit{
+        readIssued := 0
+        beat := 0
+      }
+      lookup.whenIsActive{
+        when(waysHits.orR){
+          counters.hits := counters.hits + 1
+          way := OHToUInt(waysHits)
+          goto(isWrite ? write | read)
+        } otherwise {
+          counters.misses := counters.misses + 1
+          way := victim
+          evictAddress := tagsRead(victim).address
+          victim.increment()
+          when(tagsRead(victim).valid && tagsRead(victim).dirty){
+            counters.evictions := counters.evictions + 1
+            goto(evict)
+          } otherwise {
+            goto(refillCmd)
+          }
+        }
+      }
+
+      evict.whenIsActive{
+        dataRead.valid := !readIssued.msb
+        dataRead.payload := wordAddress(readIssued)
+        when(dataRead.fire){
+          readIssued := readIssued + 1
+        }
+
+        memCmd.valid := dataReadRsp.valid
+        memCmd.opcode := Bmb.Cmd.Opcode.WRITE
+        memCmd.address := evictAddress @@ line @@ bankOf(address) @@ U(0, log2Up(bytePerLine) bits)
+        memCmd.last := beat === wordPerLine-1
+        dataReadRsp.ready := memCmd.ready
+        when(memCmd.fire){
+          beat := beat + 1
+          when(memCmd.last){
+            goto(evictRsp)
+          }
+        }
+      }
+
+      evictRsp.whenIsActive{
+        memRsp.ready := True
+        when(memRsp.valid){
+          goto(refillCmd)
+        }
+      }
+
+      refillCmd.onExit(beat := 0)
+      refillCmd.whenIsActive{
+        memCmd.valid := True
+        when(memCmd.ready){
+          goto(refill)
+        }
+      }
+
+      refill.onExit{
+        readIssued := 0
+        beat := 0
+      }
+      refill.whenIsActive{
+        memRsp.ready := True
+        when(memRsp.valid){
+          dataWrite.valid := True
+          dataWrite.address := wordAddress(beat)
+          dataWrite.data := memRsp.data
+          dataWrite.mask.setAll()
+          beat := beat + 1
+          failed setWhen(memRsp.opcode === Bmb.Rsp.Opcode.ERROR)
+          when(memRsp.last){
+            tagWrite.valid := True
+            tagWrite.line := line
+            tagWrite.ways := UIntToOh(way)
+            tagWrite.data.valid := !(failed || memRsp.opcode === Bmb.Rsp.Opcode.ERROR)
+            tagWrite.data.dirty := False
+            tagWrite.data.address := address(tagRange)
+            goto(isWrite ? write | read)
+          }
+        }
+      }
+
+      read.whenIsActive{
+        dataRead.valid := readIssued <= beatsMinusOne
+        dataRead.payload := wordAddress(firstWord + readIssued)
+        when(dataRead.fire){
+          readIssued := readIssued + 1
+        }
+
+        rsp.valid := dataReadRsp.valid
+        rsp.last := beat === beatsMinusOne
+        dataReadRsp.ready := rsp.ready
+        when(rsp.fire){
+          beat := beat + 1
+          when(rsp.last){
+            cmd.ready := True
+            goto(idle)
+          }
+        }
+      }
+
+      write.whenIsActive{
+        cmd.ready := True
+        when(cmd.valid){
+          dataWrite.valid := !failed
+          dataWrite.address := wordAddress(firstWord + beat)
+          dataWrite.data := cmd.data
+          dataWrite.mask := cmd.mask
+          beat := beat + 1
+          when(cmd.last){
+            goto(writeRsp)
+          }
+        }
+      }
+
+      writeRsp.whenIsActive{
+        tagWrite.valid := !failed
+        tagWrite.line := line
+        tagWrite.ways := UIntToOh(way)
+        tagWrite.data.valid := True
+        tagWrite.data.dirty := True
+        tagWrite.data.address := address(tagRange)
+
+        rsp.valid := True
+        when(rsp.ready){
+          goto(idle)
+        }
+      }
+    }
+  }
+
+  val banks = for(bankId <- 0 until bankCount) yield new Bank(bankId)
+
+  //Dispatch the commands packets on the banks, and remember the order to reorder the responses
+  val dispatch = new Area{
+    val selReg = Reg(UInt(log2Up(bankCount) bits))
+    val sel = io.input.cmd.isFirst ? bankOf(io.input.cmd.address) | selReg
+    when(io.input.cmd.fire){
+      selReg := sel
+    }
+
+    val order = StreamFifo(UInt(Math.max(1, log2Up(bankCount)) bits), orderQueueDepth)
+    order.io.push.valid := io.input.cmd.fire && io.input.cmd.isFirst
+    order.io.push.payload := sel.resized
+
+    val demuxed = StreamDemux(io.input.cmd.haltWhen(io.input.cmd.isFirst && !order.io.push.ready), sel, bankCount)
+    for((bank, cmd) <- (banks, demuxed).zipped) bank.cmd << cmd
+
+    val rspSel = order.io.pop.payload.resize(log2Up(bankCount))
+    io.input.rsp << StreamMux(rspSel, banks.map(_.rsp)).haltWhen(!order.io.pop.valid)
+    order.io.pop.ready := io.input.rsp.fire && io.input.rsp.last
+  }
+
+  //Share the memory bus between the banks, the source identify the bank
+  val memory = new Area{
+    io.output.cmd << StreamArbiterFactory.roundRobin.fragmentLock.on(banks.map(_.memCmd))
+    io.output.rsp.ready := Vec(banks.map(_.memRsp.ready))(io.output.rsp.source)
+    for((bank, bankId) <- banks.zipWithIndex){
+      bank.memRsp.valid := io.output.rsp.valid && io.output.rsp.source === bankId
+      bank.memRsp.payload := io.output.rsp.payload
+    }
+  }
+}
+
+case class BmbL2CacheGenerator(mapping : AddressMapping)(implicit interconnect : BmbInterconnectGenerator) extends Area{
+  val parameter = Handle[BmbL2CacheParameter]
+  val input = Handle(logic.io.input)
+  val output = Handle(logic.io.output)
+
+  val accessSource = Handle[BmbAccessCapabilities]
+  val accessRequirements = Handle[BmbAccessParameter]
+  interconnect.addSlave(
+    accessSource             = accessSource,
+    accessCapabilities       = accessSource,
+    accessRequirements       = accessRequirements,
+    bus                      = input,
+    mapping                  = mapping
+  )
+  interconnect.addMaster(
+    accessRequirements = Handle(BmbL2Cache.outputAccessParameter(parameter, accessRequirements)),
+    bus = output
+  )
+
+  val logic = Handle(BmbL2Cache(
+    p = parameter,
+    inputParameter = accessRequirements.toBmbParameter()
+  ))
+}
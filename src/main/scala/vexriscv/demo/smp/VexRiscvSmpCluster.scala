@@ -33,7 +33,9 @@ case class VexRiscvSmpClusterParameter(cpuConfigs : Seq[VexRiscvConfig],
                                        outOfOrderDecoder : Boolean = true,
                                        fpu : Boolean = false,
                                        privilegedDebug : Boolean = false,
-                                       hardwareBreakpoints : Int = 0)
+                                       hardwareBreakpoints : Int = 0,
+                                       snoopFilterEntries : Int = 0,
+                                       coherentDmaPort : BmbAccessParameter = null) //null disable the coherent I/O port
 
 class VexRiscvSmpClusterBase(p : VexRiscvSmpClusterParameter) extends Area with PostInitCallback{
   val cpuCount = p.cpuConfigs.size
@@ -79,6 +81,19 @@ class VexRiscvSmpClusterBase(p : VexRiscvSmpClusterParameter) extends Area with
     interconnect.addConnection(dBusCoherent.bmb, dBusNonCoherent.bmb)
   }
 
+  // Coherent I/O port, the DMA writes invalidate the lines held by the cpus data caches. Those caches being write through,
+  // the DMA reads always get the latest data, so no snoop is needed and the drivers can use coherent DMA mappings.
+  val coherentDma = p.coherentDmaPort != null generate new Area{
+    assert(p.withExclusiveAndInvalidation, "The coherent DMA port need the invalidation support")
+    val bus = Handle(slave(Bmb(p.coherentDmaPort.toBmbParameter())))
+    interconnect.addMaster(
+      accessRequirements = Handle(p.coherentDmaPort),
+      bus = bus
+    )
+    interconnect.addConnection(bus, dBusCoherent.bmb)
+    interconnect.setPipelining(bus)(cmdValid = true, cmdReady = true, rspValid = true)
+  }
+
   val cores = for(cpuId <- 0 until cpuCount) yield new Area{
     val cpu = VexRiscvBmbGenerator()
     cpu.config.load(p.cpuConfigs(cpuId))
@@ -87,6 +102,7 @@ class VexRiscvSmpClusterBase(p : VexRiscvSmpClusterParameter) extends Area with
     )
 
     cpu.hardwareBreakpointCount.load(p.hardwareBreakpoints)
+    cpu.snoopFilterEntries.load(p.snoopFilterEntries)
     if(!p.privilegedDebug) {
       cpu.enableDebugBmb(
         debugCd = debugCd.outputClockDomain,
@@ -258,7 +274,8 @@ object VexRiscvSmpClusterGen {
                      forceMisa : Boolean = false,
                      forceMscratch : Boolean = false,
                      privilegedDebug : Boolean = false,
-                     csrFull : Boolean = false
+                     csrFull : Boolean = false,
+                     cacheBlockOps : Boolean = false
                     ) = {
     assert(iCacheSize/iCacheWays <= 4096, "Instruction cache ways can't be bigger than 4096 bytes")
     assert(dCacheSize/dCacheWays <= 4096, "Data cache ways can't be bigger than 4096 bytes")
@@ -369,7 +386,8 @@ object VexRiscvSmpClusterGen {
             withAmo = atomic,
             withExclusive = coherency,
             withInvalidate = coherency,
-            withWriteAggregation = dBusWidth > 32
+            withWriteAggregation = dBusWidth > 32,
+            withCacheBlockOps = cacheBlockOps
           ),
           memoryTranslatorPortConfig = MmuPortConfig(
             portTlbSize = dTlbSize,
@@ -19,16 +19,41 @@ case class VexRiscvLitexSmpClusterParameter( cluster : VexRiscvSmpClusterParamet
                                              coherentDma : Boolean,
                                              wishboneMemory : Boolean,
                                              cpuPerFpu : Int,
-                                             exposeTime : Boolean)
+                                             exposeTime : Boolean,
+                                             l2CacheSize : Int = 0, //0 disable the shared L2 cache
+                                             l2CacheWays : Int = 4,
+                                             l2CacheBanks : Int = 1){
+  def withL2Cache = l2CacheSize != 0
+  def l2Cache = BmbL2CacheParameter(
+    cacheSize = l2CacheSize,
+    wayCount = l2CacheWays,
+    bankCount = l2CacheBanks
+  )
+}
 
 
 class VexRiscvLitexSmpCluster(p : VexRiscvLitexSmpClusterParameter) extends VexRiscvSmpClusterWithPeripherals(p.cluster) {
+  assert(!(p.withL2Cache && p.wishboneMemory), "The L2 cache require the LiteDram memory interface")
+  val withL2Cache = p.withL2Cache
+
   val iArbiter = BmbBridgeGenerator()
-  val iBridge = !p.wishboneMemory generate BmbToLiteDramGenerator(p.liteDramMapping)
+  val iBridge = !p.wishboneMemory && !withL2Cache generate BmbToLiteDramGenerator(p.liteDramMapping)
   val dBridge = !p.wishboneMemory generate BmbToLiteDramGenerator(p.liteDramMapping)
 
+  // Shared L2 cache, all the memory traffic go through it, including the coherent DMA one
+  val l2 = withL2Cache generate new Area{
+    val cache = BmbL2CacheGenerator(p.liteDramMapping)
+    cache.parameter.load(p.l2Cache)
+    interconnect.addConnection(
+      iArbiter.bmb        -> List(cache.input),
+      dBusNonCoherent.bmb -> List(cache.input),
+      cache.output        -> List(dBridge.bmb)
+    )
+    val counters = Handle(cache.logic.io.counters)
+  }
+
   for(core <- cores) interconnect.addConnection(core.cpu.iBus -> List(iArbiter.bmb))
-  !p.wishboneMemory generate interconnect.addConnection(
+  !p.wishboneMemory && !withL2Cache generate interconnect.addConnection(
     iArbiter.bmb        -> List(iBridge.bmb),
     dBusNonCoherent.bmb -> List(dBridge.bmb)
   )
@@ -69,7 +94,7 @@ class VexRiscvLitexSmpCluster(p : VexRiscvLitexSmpClusterParameter) extends VexR
 
   if(!p.wishboneMemory) {
     dBridge.liteDramParameter.load(p.liteDram)
-    iBridge.liteDramParameter.load(p.liteDram)
+    if(!withL2Cache) iBridge.liteDramParameter.load(p.liteDram)
   }
 
   // Coherent DMA interface
@@ -96,9 +121,10 @@ class VexRiscvLitexSmpCluster(p : VexRiscvLitexSmpClusterParameter) extends VexR
   interconnect.setPipelining(dBusNonCoherent.bmb)(cmdValid = true, cmdReady = true, rspValid = true)
   interconnect.setPipelining(peripheralBridge.bmb)(cmdHalfRate = !p.wishboneMemory, cmdValid = p.wishboneMemory, cmdReady = p.wishboneMemory, rspValid = true)
   if(!p.wishboneMemory) {
-    interconnect.setPipelining(iBridge.bmb)(cmdHalfRate = true)
+    if(!withL2Cache) interconnect.setPipelining(iBridge.bmb)(cmdHalfRate = true)
     interconnect.setPipelining(dBridge.bmb)(cmdReady = true)
   }
+  if(withL2Cache) interconnect.setPipelining(l2.cache.input)(cmdValid = true, cmdReady = true, rspValid = true)
 
   val clint_time = p.exposeTime generate hardFork(clint.logic.io.time.toIo)
 }
@@ -129,6 +155,10 @@ object VexRiscvLitexSmpClusterCmdGen extends App {
   var dTlbSize = 4
   var wishboneForce32b = false
   var exposeTime = false
+  var l2CacheSize = 0
+  var l2CacheWays = 4
+  var l2CacheBanks = 1
+  var snoopFilterEntries = 0
   assert(new scopt.OptionParser[Unit]("VexRiscvLitexSmpClusterCmdGen") {
     help("help").text("prints this usage text")
     opt[Unit]  ("coherent-dma") action { (v, c) => coherentDma = true }
@@ -154,6 +184,10 @@ object VexRiscvLitexSmpClusterCmdGen extends App {
     opt[String]("itlb-size") action { (v, c) => iTlbSize = v.toInt }
     opt[String]("dtlb-size") action { (v, c) => dTlbSize = v.toInt }
     opt[String]("expose-time") action { (v, c) => exposeTime = v.toBoolean }
+    opt[String]("l2-cache-size") action { (v, c) => l2CacheSize = v.toInt }
+    opt[String]("l2-cache-ways") action { (v, c) => l2CacheWays = v.toInt }
+    opt[String]("l2-cache-banks") action { (v, c) => l2CacheBanks = v.toInt }
+    opt[String]("snoop-filter-entries") action { (v, c) => snoopFilterEntries = v.toInt }
   }.parse(args, ()).nonEmpty)
 
   val coherency = coherentDma || cpuCount > 1
@@ -192,14 +226,18 @@ object VexRiscvLitexSmpClusterCmdGen extends App {
       fpu = fpu,
       jtagHeaderIgnoreWidth = 0,
       privilegedDebug = privilegedDebug,
-      hardwareBreakpoints = hardwareBreakpoints
+      hardwareBreakpoints = hardwareBreakpoints,
+      snoopFilterEntries = snoopFilterEntries
     ),
     liteDram = LiteDramNativeParameter(addressWidth = 32, dataWidth = liteDramWidth),
     liteDramMapping = SizeMapping(0x40000000l, 0x40000000l),
     coherentDma = coherentDma,
     wishboneMemory = wishboneMemory,
     cpuPerFpu = cpuPerFpu,
-    exposeTime = exposeTime
+    exposeTime = exposeTime,
+    l2CacheSize = l2CacheSize,
+    l2CacheWays = l2CacheWays,
+    l2CacheBanks = l2CacheBanks
   )
 
   def dutGen = {
@@ -258,6 +296,8 @@ object VexRiscvLitexSmpClusterOpenSbi extends App{
   simConfig.allOptimisation
 
   val cpuCount = 2
+  val l2CacheSize = sys.env.getOrElse("VEXRISCV_SMP_L2_SIZE", "0").toInt //Non zero to benchmark the linux boot with a L2 cache
+  val l2CacheBanks = sys.env.getOrElse("VEXRISCV_SMP_L2_BANKS", "1").toInt
 
   def parameter = VexRiscvLitexSmpClusterParameter(
     cluster = VexRiscvSmpClusterParameter(
@@ -276,7 +316,9 @@ object VexRiscvLitexSmpClusterOpenSbi extends App{
     coherentDma = false,
     wishboneMemory = false,
     cpuPerFpu = 4,
-    exposeTime = false
+    exposeTime = false,
+    l2CacheSize = l2CacheSize,
+    l2CacheBanks = l2CacheBanks
   )
 
   def dutGen = {
@@ -299,6 +341,8 @@ object VexRiscvLitexSmpClusterOpenSbi extends App{
       top.body.peripheral.DAT_MISO := top.body.clintWishbone.DAT_MISO
       top.body.peripheral.ACK := top.body.peripheral.CYC  && (!hit || top.body.clintWishbone.ACK)
       top.body.peripheral.ERR := False
+
+      if(top.body.withL2Cache) top.body.l2.counters.get.simPublic()
     }
     top
   }
@@ -313,15 +357,34 @@ object VexRiscvLitexSmpClusterOpenSbi extends App{
     ram.loadBin(0xC2000000l, "../buildroot/output/images/rootfs.cpio")
 
 
-    dut.body.iBridge.dram.simSlave(ram, dut.body.debugCd.inputClockDomain)
+    if(!dut.body.withL2Cache) dut.body.iBridge.dram.simSlave(ram, dut.body.debugCd.inputClockDomain)
     dut.body.dBridge.dram.simSlave(ram, dut.body.debugCd.inputClockDomain/*, dut.body.dMemBridge.unburstified*/)
 
     dut.body.interrupts #= 0
 
+    //Boot benchmark, report the cycles and the L2 hit rate when the login prompt show up
+    var cycles = 0l
+    var console = ""
+    def report(): Unit = {
+      println(f"\n[BENCH] linux boot : $cycles cycles, $cpuCount cpus, L2 $l2CacheSize bytes")
+      if(dut.body.withL2Cache) {
+        val hits = dut.body.l2.counters.map(_.hits.toLong).sum
+        val misses = dut.body.l2.counters.map(_.misses.toLong).sum
+        val evictions = dut.body.l2.counters.map(_.evictions.toLong).sum
+        println(f"[BENCH] L2 hits=$hits misses=$misses evictions=$evictions hit rate=${hits*100.0/(hits+misses max 1)}%.2f%%")
+      }
+    }
+
     dut.body.debugCd.inputClockDomain.get.onFallingEdges{
+      cycles += 1
       if(dut.body.peripheral.CYC.toBoolean){
         (dut.body.peripheral.ADR.toLong << 2) match {
-          case 0xF0000000l => print(dut.body.peripheral.DAT_MOSI.toLong.toChar)
+          case 0xF0000000l => {
+            val c = dut.body.peripheral.DAT_MOSI.toLong.toChar
+            print(c)
+            console = (console + c).takeRight(6)
+            if(console == "login:") report()
+          }
           case 0xF0000004l => dut.body.peripheral.DAT_MISO #= (if(System.in.available() != 0) System.in.read() else 0xFFFFFFFFl)
           case _ =>
         }
@@ -338,3 +401,273 @@ object VexRiscvLitexSmpClusterOpenSbi extends App{
     }
   }
 }
+
+//Run the smpBandwidth regression with 2, 4 and 8 cpus, with and without the data cache snoop filter, and report the
+//cycles spent in the benchmark and the invalidations given to / filtered from the cpus.
+object VexRiscvLitexSmpClusterSnoopFilterBench extends App{
+  import spinal.core.sim._
+
+  case class Result(cpuCount : Int, snoopFilterEntries : Int, cycles : Long, probesSent : Long, probesFiltered : Long)
+  val results = scala.collection.mutable.ArrayBuffer[Result]()
+
+  for(cpuCount <- List(2, 4, 8); snoopFilterEntries <- List(0, 256)) {
+    def parameter = VexRiscvLitexSmpClusterParameter(
+      cluster = VexRiscvSmpClusterParameter(
+        cpuConfigs = List.tabulate(cpuCount) { hartId =>
+          vexRiscvConfig(
+            hartId = hartId,
+            ioRange = address => address(31 downto 28) === 0xF,
+            resetVector = 0x80000000l
+          )
+        },
+        withExclusiveAndInvalidation = true,
+        jtagHeaderIgnoreWidth = 0,
+        snoopFilterEntries = snoopFilterEntries
+      ),
+      liteDram = LiteDramNativeParameter(addressWidth = 32, dataWidth = 128),
+      liteDramMapping = SizeMapping(0x80000000l, 0x70000000l),
+      coherentDma = false,
+      wishboneMemory = false,
+      cpuPerFpu = 4,
+      exposeTime = false
+    )
+
+    def dutGen = {
+      val top = new Component {
+        val body = new VexRiscvLitexSmpCluster(
+          p = parameter
+        )
+      }
+      top.rework{
+        top.body.peripheral.setAsDirectionLess.allowDirectionLessIo.simPublic()
+        top.body.peripheral.ACK := top.body.peripheral.CYC
+        top.body.peripheral.ERR := False
+        top.body.peripheral.DAT_MISO := 0
+        if(snoopFilterEntries != 0) for(core <- top.body.cores) core.cpu.snoopFilterCounters.get.simPublic()
+      }
+      top
+    }
+
+    SimConfig.allOptimisation.compile(dutGen).doSimUntilVoid(seed = 42){dut =>
+      val cd = dut.body.debugCd.inputClockDomain.get
+      cd.forkStimulus(10)
+      SimTimeout(10000000l*10)
+
+      val ram = SparseMemory()
+      ram.loadBin(0x80000000l, "src/test/cpp/raw/smpBandwidth/build/smpBandwidth.bin")
+      dut.body.iBridge.dram.simSlave(ram, cd)
+      dut.body.dBridge.dram.simSlave(ram, cd)
+      dut.body.interrupts #= 0
+
+      var cycles, benchStart, benchCycles = 0l
+      var started, ended, done = 0
+      cd.onFallingEdges{
+        cycles += 1
+        val bus = dut.body.peripheral
+        if(bus.CYC.toBoolean && bus.STB.toBoolean && bus.WE.toBoolean){
+          val address = bus.ADR.toLong << 2
+          val data = bus.DAT_MOSI.toLong
+          if((address & 0xFF000000l) == 0xF8000000l) (address & 0xFFFF) match {
+            case 0x04 => assert(data == cpuCount, s"Thread count $data")
+            case 0x18 => if(started == 0) benchStart = cycles; started += 1
+            case 0x1C => ended += 1; if(ended == cpuCount) benchCycles = cycles - benchStart
+            case 0x08 => {
+              assert(data == 0, s"Hart ${(address >> 16) & 0xFF} failed")
+              done += 1
+              if(done == cpuCount) {
+                val counters = if(snoopFilterEntries != 0) dut.body.cores.map(_.cpu.snoopFilterCounters.get) else Nil
+                results += Result(cpuCount, snoopFilterEntries, benchCycles, counters.map(_.probesSent.toLong).sum, counters.map(_.probesFiltered.toLong).sum)
+                simSuccess()
+              }
+            }
+            case _ =>
+          }
+        }
+      }
+    }
+  }
+
+  for(r <- results) {
+    println(f"${r.cpuCount} cpus, snoop filter ${r.snoopFilterEntries}%4d entries : ${r.cycles}%8d cycles, probes sent ${r.probesSent}%8d, filtered ${r.probesFiltered}%8d")
+  }
+}
+
+//Run the smpCboZero regression, where a hart zero with cbo.zero the lines written or read by an other one, with and
+//without the data cache snoop filter.
+object VexRiscvLitexSmpClusterCboZeroTest extends App{
+  import spinal.core.sim._
+
+  val cpuCount = 2
+  for(snoopFilterEntries <- List(0, 256)) {
+    def parameter = VexRiscvLitexSmpClusterParameter(
+      cluster = VexRiscvSmpClusterParameter(
+        cpuConfigs = List.tabulate(cpuCount) { hartId =>
+          vexRiscvConfig(
+            hartId = hartId,
+            ioRange = address => address(31 downto 28) === 0xF,
+            resetVector = 0x80000000l,
+            cacheBlockOps = true
+          )
+        },
+        withExclusiveAndInvalidation = true,
+        jtagHeaderIgnoreWidth = 0,
+        snoopFilterEntries = snoopFilterEntries
+      ),
+      liteDram = LiteDramNativeParameter(addressWidth = 32, dataWidth = 128),
+      liteDramMapping = SizeMapping(0x80000000l, 0x70000000l),
+      coherentDma = false,
+      wishboneMemory = false,
+      cpuPerFpu = 4,
+      exposeTime = false
+    )
+
+    def dutGen = {
+      val top = new Component {
+        val body = new VexRiscvLitexSmpCluster(
+          p = parameter
+        )
+      }
+      top.rework{
+        top.body.peripheral.setAsDirectionLess.allowDirectionLessIo.simPublic()
+        top.body.peripheral.ACK := top.body.peripheral.CYC
+        top.body.peripheral.ERR := False
+        top.body.peripheral.DAT_MISO := 0
+      }
+      top
+    }
+
+    SimConfig.allOptimisation.compile(dutGen).doSimUntilVoid(seed = 42){dut =>
+      val cd = dut.body.debugCd.inputClockDomain.get
+      cd.forkStimulus(10)
+      SimTimeout(1000000l*10)
+
+      val ram = SparseMemory()
+      ram.loadBin(0x80000000l, "src/test/cpp/raw/smpCboZero/build/smpCboZero.bin")
+      dut.body.iBridge.dram.simSlave(ram, cd)
+      dut.body.dBridge.dram.simSlave(ram, cd)
+      dut.body.interrupts #= 0
+
+      var done = 0
+      cd.onFallingEdges{
+        val bus = dut.body.peripheral
+        if(bus.CYC.toBoolean && bus.STB.toBoolean && bus.WE.toBoolean){
+          val address = bus.ADR.toLong << 2
+          val data = bus.DAT_MOSI.toLong
+          if((address & 0xFF000000l) == 0xF8000000l) (address & 0xFFFF) match {
+            case 0x08 => {
+              assert(data == 0, s"Hart ${(address >> 16) & 0xFF} failed the test $data with a snoop filter of $snoopFilterEntries entries")
+              done += 1
+              if(done == cpuCount) simSuccess()
+            }
+            case _ =>
+          }
+        }
+      }
+    }
+  }
+}
+
+//Run the smpCoherentDma regression, where the testbench DMA write through the cluster coherentDmaPort the lines cached
+//by the harts, which have to see the new data.
+object VexRiscvLitexSmpClusterCoherentDmaTest extends App{
+  import spinal.core.sim._
+
+  val cpuCount = 2
+  val dmaData = 0x22222222l
+  def parameter = VexRiscvLitexSmpClusterParameter(
+    cluster = VexRiscvSmpClusterParameter(
+      cpuConfigs = List.tabulate(cpuCount) { hartId =>
+        vexRiscvConfig(
+          hartId = hartId,
+          ioRange = address => address(31 downto 28) === 0xF,
+          resetVector = 0x80000000l
+        )
+      },
+      withExclusiveAndInvalidation = true,
+      jtagHeaderIgnoreWidth = 0,
+      coherentDmaPort = BmbAccessParameter(
+        addressWidth = 32,
+        dataWidth = 64
+      ).addSources(1, BmbSourceParameter(
+        contextWidth = 0,
+        lengthWidth = 3,
+        alignment = BmbParameter.BurstAlignement.LENGTH
+      ))
+    ),
+    liteDram = LiteDramNativeParameter(addressWidth = 32, dataWidth = 128),
+    liteDramMapping = SizeMapping(0x80000000l, 0x70000000l),
+    coherentDma = false,
+    wishboneMemory = false,
+    cpuPerFpu = 4,
+    exposeTime = false
+  )
+
+  def dutGen = {
+    val top = new Component {
+      val body = new VexRiscvLitexSmpCluster(
+        p = parameter
+      )
+    }
+    top.rework{
+      top.body.peripheral.setAsDirectionLess.allowDirectionLessIo.simPublic()
+      top.body.peripheral.ACK := top.body.peripheral.CYC
+      top.body.peripheral.ERR := False
+      top.body.peripheral.DAT_MISO := 0
+    }
+    top
+  }
+
+  SimConfig.allOptimisation.compile(dutGen).doSimUntilVoid(seed = 42){dut =>
+    val cd = dut.body.debugCd.inputClockDomain.get
+    cd.forkStimulus(10)
+    SimTimeout(1000000l*10)
+
+    val ram = SparseMemory()
+    ram.loadBin(0x80000000l, "src/test/cpp/raw/smpCoherentDma/build/smpCoherentDma.bin")
+    dut.body.iBridge.dram.simSlave(ram, cd)
+    dut.body.dBridge.dram.simSlave(ram, cd)
+    dut.body.interrupts #= 0
+
+    //One word write per request (the lower half of the 64 bits bus, the addresses being 8 bytes aligned)
+    val dma = dut.body.coherentDma.bus.get
+    val requests = scala.collection.mutable.Queue[Long]()
+    dma.cmd.valid #= false
+    dma.rsp.ready #= true
+    fork {
+      while(true) {
+        cd.waitSampling()
+        if(requests.nonEmpty) {
+          val address = requests.dequeue()
+          dma.cmd.valid #= true
+          dma.cmd.payload.last #= true
+          dma.cmd.payload.fragment.opcode #= Bmb.Cmd.Opcode.WRITE
+          dma.cmd.payload.fragment.address #= address
+          dma.cmd.payload.fragment.length #= 3
+          dma.cmd.payload.fragment.data #= dmaData
+          dma.cmd.payload.fragment.mask #= 0x0F
+          cd.waitSamplingWhere(dma.cmd.ready.toBoolean)
+          dma.cmd.valid #= false
+          cd.waitSamplingWhere(dma.rsp.valid.toBoolean)
+        }
+      }
+    }
+
+    var done = 0
+    cd.onFallingEdges{
+      val bus = dut.body.peripheral
+      if(bus.CYC.toBoolean && bus.STB.toBoolean && bus.WE.toBoolean){
+        val address = bus.ADR.toLong << 2
+        val data = bus.DAT_MOSI.toLong
+        if((address & 0xFF000000l) == 0xF8000000l) (address & 0xFFFF) match {
+          case 0x0C => requests.enqueue(data)
+          case 0x08 => {
+            assert(data == 0, s"Hart ${(address >> 16) & 0xFF} failed the test $data")
+            done += 1
+            if(done == cpuCount) simSuccess()
+          }
+          case _ =>
+        }
+      }
+    }
+  }
+}
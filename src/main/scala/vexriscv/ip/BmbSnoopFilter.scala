@@ -0,0 +1,143 @@
+package vexriscv.ip
+
+import spinal.core._
+import spinal.lib._
+import spinal.lib.bus.bmb.{Bmb, BmbParameter}
+
+
+case class BmbSnoopFilterCounters() extends Bundle{
+  val probesSent, probesFiltered, backInvalidations = UInt(32 bits)
+}
+
+//Sit between a DataCache memory bus and the coherent interconnect, and track which lines the cache may hold, in order
+//to only forward the invalidations which may hit it. The other ones are acknowledged in place, in order with the forwarded ones.
+//The directory is direct mapped, when a refill replace one of its entries, the previous line is invalidated in the cache.
+//With trackWrites, the written lines are recorded as well, as cbo.zero allocate its line in the cache without refill
+//before writing it.
+case class BmbSnoopFilter(p : BmbParameter,
+                          entries : Int,
+                          bytePerLine : Int,
+                          trackWrites : Boolean = false,
+                          pendingMax : Int = 16) extends Component{
+  assert(isPow2(entries) && isPow2(bytePerLine))
+
+  val io = new Bundle {
+    val input = slave(Bmb(p))
+    val output = master(Bmb(p))
+    val counters = out(BmbSnoopFilterCounters())
+  }
+
+  val addressWidth = p.access.addressWidth
+  val offsetRange = log2Up(bytePerLine)-1 downto 0
+  val indexRange = log2Up(bytePerLine) + log2Up(entries) - 1 downto log2Up(bytePerLine)
+  val tagRange = addressWidth-1 downto indexRange.high+1
+
+  val directory = new Area{
+    val valids = Reg(Bits(entries bits)) init(0)
+    val tags = Mem(UInt(tagRange.length bits), entries)
+    def present(address : UInt) = valids(address(indexRange)) && tags.readAsync(address(indexRange)) === address(tagRange)
+  }
+
+  val counters = new Area{
+    val probesSent, probesFiltered, backInvalidations = Reg(UInt(32 bits)) init(0)
+    io.counters.probesSent := probesSent
+    io.counters.probesFiltered := probesFiltered
+    io.counters.backInvalidations := backInvalidations
+  }
+
+  //Record the lines refilled (or written) by the cache
+  val track = new Area{
+    val cmd = io.input.cmd
+    val index = cmd.address(indexRange)
+    val lineRead = !cmd.isWrite && cmd.length === bytePerLine-1
+    val refill = cmd.valid && cmd.isFirst && (lineRead || (if(trackWrites) cmd.isWrite else False))
+    val victimValid = directory.valids(index)
+    val victimTag = directory.tags.readAsync(index)
+    val replace = victimValid && victimTag =/= cmd.address(tagRange)
+
+    val backInvalidation = Reg(Flow(UInt(addressWidth bits)))
+    backInvalidation.valid init(False)
+
+    io.output.cmd << cmd.haltWhen(refill && backInvalidation.valid)
+    val allocate = refill && io.output.cmd.ready && !backInvalidation.valid
+    directory.tags.write(index, cmd.address(tagRange), allocate)
+    when(allocate){
+      directory.valids(index) := True
+      when(replace){
+        backInvalidation.valid := True
+        backInvalidation.payload := victimTag @@ index @@ U(0, log2Up(bytePerLine) bits)
+        counters.backInvalidations := counters.backInvalidations + 1
+      }
+    }
+  }
+
+  io.input.rsp << io.output.rsp
+  io.input.sync << io.output.sync
+
+  //Remember for each invalidation given to the cache (or filtered) where its acknowledge has to go
+  case class Pending() extends Bundle{
+    val forwarded, local = Bool()
+  }
+  val order = StreamFifo(Pending(), pendingMax)
+  order.io.push.valid := False
+  order.io.push.payload.assignDontCare()
+
+  val invalidate = new Area{
+    val upstream = io.output.inv
+    val lastOffset = upstream.address(offsetRange).resize(Math.max(widthOf(upstream.length), offsetRange.length) + 1) + upstream.length
+    val singleLine = lastOffset < bytePerLine
+    val forward = upstream.all && (!singleLine || directory.present(upstream.address))
+
+    io.input.inv.valid := False
+    io.input.inv.payload := upstream.payload
+    upstream.ready := False
+
+    when(track.backInvalidation.valid){
+      io.input.inv.valid := order.io.push.ready
+      io.input.inv.all := True
+      io.input.inv.address := track.backInvalidation.payload
+      io.input.inv.length := bytePerLine-1
+      order.io.push.valid := io.input.inv.ready
+      order.io.push.forwarded := False
+      order.io.push.local := True
+      when(io.input.inv.fire){
+        track.backInvalidation.valid := False
+      }
+    } elsewhen(upstream.valid && order.io.push.ready){
+      order.io.push.forwarded := forward
+      order.io.push.local := False
+      when(forward){
+        io.input.inv.valid := True
+        upstream.ready := io.input.inv.ready
+        order.io.push.valid := io.input.inv.ready
+        when(io.input.inv.ready){
+          counters.probesSent := counters.probesSent + 1
+        }
+      } otherwise {
+        upstream.ready := True
+        order.io.push.valid := True
+        counters.probesFiltered := counters.probesFiltered + 1
+      }
+    }
+  }
+
+  val acknowledge = new Area{
+    val head = order.io.pop
+    io.output.ack.valid := False
+    io.input.ack.ready := False
+    head.ready := False
+    when(head.valid){
+      when(head.local){
+        io.input.ack.ready := True
+        head.ready := io.input.ack.valid
+      } elsewhen(head.forwarded){
+        io.output.ack.valid := io.input.ack.valid
+        io.input.ack.ready := io.output.ack.ready
+        head.ready := io.input.ack.fire
+      } otherwise {
+        io.output.ack.valid := True
+        head.ready := io.output.ack.ready
+      }
+    }
+  }
+}
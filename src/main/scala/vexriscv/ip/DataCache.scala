@@ -32,19 +32,28 @@ case class DataCacheConfig(cacheSize : Int,
                            directTlbHit : Boolean = false,
                            mergeExecuteMemory : Boolean = false,
                            asyncTagMemory : Boolean = false,
-                           withWriteAggregation : Boolean = false){
+                           withWriteAggregation : Boolean = false,
+                           wayPrediction : Boolean = false,
+                           victimLineCount : Int = 0,
+                           criticalWordFirst : Boolean = false,
+                           withCacheBlockOps : Boolean = false){
 
   if(rfDataWidth == -1)  rfDataWidth = cpuDataWidth 
   assert(!(mergeExecuteMemory && (earlyDataMux || earlyWaysHits)))
   assert(!(earlyDataMux && !earlyWaysHits))
   assert(isPow2(pendingMax))
   assert(rfDataWidth <= memDataWidth)
+  assert(!(wayPrediction && (earlyDataMux || wayCount == 1)))
+  assert(victimLineCount == 0 || wayCount == 1, "The victim buffer is only implemented for direct mapped caches")
+  assert(!(criticalWordFirst && (burstSize == 1 || victimLineCount != 0)))
 
   def lineCount = cacheSize/bytePerLine/wayCount
   def sizeMax = log2Up(bytePerLine)
   def sizeWidth = log2Up(sizeMax + 1)
   val aggregationWidth = if(withWriteAggregation) log2Up(memDataBytes+1) else 0
   def withWriteResponse = withExclusive
+  def withVictim = victimLineCount != 0
+  def withBackgroundRefill = criticalWordFirst || withCacheBlockOps
   def burstSize = bytePerLine*8/memDataWidth
   val burstLength = bytePerLine/(cpuDataWidth/8)
   def catchSomething = catchUnaligned || catchIllegal || catchAccessError
@@ -60,7 +69,7 @@ case class DataCacheConfig(cacheSize : Int,
     dataWidth = memDataWidth,
     useId = false,
     useRegion = false,
-    useBurst = false,
+    useBurst = criticalWordFirst,
     useLock = false,
     useQos = false
   )
@@ -72,7 +81,8 @@ case class DataCacheConfig(cacheSize : Int,
     burstCountWidth = log2Up(burstSize + 1)).copy(
     useByteEnable = true,
     constantBurstBehavior = true,
-    burstOnBurstBoundariesOnly = true,
+    burstOnBurstBoundariesOnly = !criticalWordFirst,
+    linewrapBursts = criticalWordFirst,
     useResponse = true,
     maximumPendingReadTransactions = 2
   )
@@ -93,6 +103,13 @@ case class DataCacheConfig(cacheSize : Int,
     addressGranularity = AddressGranularity.WORD
   )
 
+  def getWishboneBte() = if(!criticalWordFirst) B"00" else burstSize match {
+    case 4 => B"01"
+    case 8 => B"10"
+    case 16 => B"11"
+    case _ => SpinalError("Wishbone wrapped bursts are 4, 8 or 16 beats long")
+  }
+
   def getBmbParameter() = BmbParameter(
     BmbAccessParameter(
       addressWidth = 32,
@@ -139,6 +156,12 @@ case class DataCacheCpuExecuteArgs(p : DataCacheConfig) extends Bundle{
     val swap = Bool()
     val alu = Bits(3 bits)
   }
+  val isCbo = p.withCacheBlockOps generate Bool()
+  val cboCtrl = p.withCacheBlockOps generate new Bundle {
+    val invalidate = Bool() //cbo.inval and cbo.flush
+    val zero = Bool()
+  }
+  val isPrefetch = p.withCacheBlockOps generate Bool()
 
   val totalyConsistent = Bool() //Only for AMO/LRSC
 }
@@ -278,6 +301,9 @@ case class DataCacheMemBus(p : DataCacheConfig) extends Bundle with IMasterSlave
     }
   }
 
+  //Word offset of the beats, wrapping around the line when the burst start at the critical word
+  def burstOffset(address : UInt, counter : UInt, addressShift : Int) : UInt = if(p.criticalWordFirst) address(addressShift, widthOf(counter) bits) + counter else counter
+
   def toAxi4Shared(stageCmd : Boolean = false, pendingWritesMax  : Int = 7): Axi4Shared = new Area{
     setName("dBusToAxi4Shared")
     val axi = Axi4Shared(p.getAxi4SharedConfig()).setName("dbus_axi")
@@ -302,6 +328,11 @@ case class DataCacheMemBus(p : DataCacheConfig) extends Bundle with IMasterSlave
     axi.sharedCmd.size := log2Up(p.memDataBytes)
     axi.sharedCmd.addr := cmdStage.address
     axi.sharedCmd.len  := cmdStage.beatCountMinusOne.resized
+    if(p.criticalWordFirst) when(cmdStage.isBurst){
+      axi.sharedCmd.setBurstWRAP()
+    } otherwise {
+      axi.sharedCmd.setBurstINCR()
+    }
 
     axi.writeData.arbitrationFrom(dataStage)
     axi.writeData.data := dataStage.data
@@ -344,7 +375,7 @@ case class DataCacheMemBus(p : DataCacheConfig) extends Bundle with IMasterSlave
     val cmdBridge = Stream (DataCacheMemCmd(p))
     val isBurst = cmdBridge.isBurst
     cmdBridge.valid := cmd.valid
-    cmdBridge.address := (isBurst ? (cmd.address(31 downto widthOf(counter) + addressShift) @@ counter @@ U(0, addressShift bits)) | (cmd.address(31 downto addressShift) @@ U(0, addressShift bits)))
+    cmdBridge.address := (isBurst ? (cmd.address(31 downto widthOf(counter) + addressShift) @@ burstOffset(cmd.address, counter, addressShift) @@ U(0, addressShift bits)) | (cmd.address(31 downto addressShift) @@ U(0, addressShift bits)))
     cmdBridge.wr := cmd.wr
     cmdBridge.mask := cmd.mask
     cmdBridge.data := cmd.data
@@ -363,7 +394,7 @@ case class DataCacheMemBus(p : DataCacheConfig) extends Bundle with IMasterSlave
 
     bus.ADR := cmdBridge.address >> addressShift
     bus.CTI := Mux(isBurst, cmdBridge.last ? B"111" | B"010", B"000")
-    bus.BTE := B"00"
+    bus.BTE := isBurst ? p.getWishboneBte() | B"00"
     bus.SEL := cmdBridge.wr ? cmdBridge.mask | B((1 << p.memDataBytes)-1)
     bus.WE  := cmdBridge.wr
     bus.DAT_MOSI := cmdBridge.data
@@ -388,7 +419,7 @@ case class DataCacheMemBus(p : DataCacheConfig) extends Bundle with IMasterSlave
     when(    cmd.fire && cmd.last){ counter := 0 }
 
     bus.cmd.valid := cmd.valid
-    bus.cmd.address := (cmd.address(31 downto 2) | counter.resized) @@ U"00"
+    bus.cmd.address := (if(p.criticalWordFirst) cmd.address(31 downto widthOf(counter) + 2) @@ burstOffset(cmd.address, counter, 2) else cmd.address(31 downto 2) | counter.resized) @@ U"00"
     bus.cmd.write := cmd.wr
     bus.cmd.mask := cmd.mask
     bus.cmd.data := cmd.data
@@ -402,6 +433,7 @@ case class DataCacheMemBus(p : DataCacheConfig) extends Bundle with IMasterSlave
 
   def toBmb(syncPendingMax : Int = 32,
             timeoutCycles : Int = 32) : Bmb = new Area{
+    assert(!p.criticalWordFirst, "Bmb doesn't support wrapped bursts")
     setCompositeName(DataCacheMemBus.this, "Bridge", true)
     val pipelinedMemoryBusConfig = p.getBmbParameter()
     val bus = Bmb(pipelinedMemoryBusConfig).setCompositeName(this,"toBmb", true)
@@ -621,18 +653,34 @@ class DataCache(val p : DataCacheConfig, mmuParameter : MemoryTranslatorBusParam
     val data = Bits(memDataWidth bits)
     val mask = Bits(memDataWidth/8 bits)
   })
+  val dataReadForce = False //Used by the victim buffer to read the cache while the pipeline is stalled
+  val blockOpWrite = False //Set when a cache block operation update the tags or the data of a line
 
 
+  //MRU way per line, only the predicted way data ram is read, the load is replayed on mispredictions
+  val wayPredictor = wayPrediction generate new Area{
+    val mru = Mem(UInt(log2Up(wayCount) bits), wayLineCount)
+    val read = mru.readAsync(io.cpu.execute.address(lineRange))
+    val update = Flow(new Bundle{
+      val address = UInt(log2Up(wayLineCount) bits)
+      val way = UInt(log2Up(wayCount) bits)
+    })
+    update.valid := False
+    update.payload.assignDontCare()
+    mru.write(update.address, update.way, update.valid)
+  }
+
   val ways = for(i <- 0 until wayCount) yield new Area{
     val tags = Mem(new LineInfo(), wayLineCount)
     val data = Mem(Bits(memDataWidth bit), wayMemWordCount)
+    val dataReadEnable = if(wayPrediction) wayPredictor.read === i else True
 
     //Reads
     val tagsReadRsp = asyncTagMemory match {
       case false => tags.readSync(tagsReadCmd.payload, tagsReadCmd.valid && !io.cpu.memory.isStuck)
       case true => tags.readAsync(RegNextWhen(tagsReadCmd.payload, io.cpu.execute.isValid && !io.cpu.memory.isStuck))
     }
-    val dataReadRspMem = data.readSync(dataReadCmd.payload, dataReadCmd.valid && !io.cpu.memory.isStuck)
+    val dataReadRspMem = data.readSync(dataReadCmd.payload, dataReadCmd.valid && (!io.cpu.memory.isStuck || dataReadForce) && dataReadEnable)
     val dataReadRspSel = if(mergeExecuteMemory) io.cpu.writeBack.address else io.cpu.memory.address
     val dataReadRsp = dataReadRspMem.subdivideIn(cpuDataWidth bits).read(dataReadRspSel(memWordToCpuWordRange))
 
@@ -770,6 +818,7 @@ class DataCache(val p : DataCacheConfig, mmuParameter : MemoryTranslatorBusParam
     val wayInvalidate = B(0, wayCount bits) //Used if invalidate enabled
 
     val isAmo = if(withAmo) io.cpu.execute.isAmo else False
+    val predictedWay = wayPrediction generate CombInit(wayPredictor.read)
   }
 
   val stageA = new Area{
@@ -812,6 +861,7 @@ class DataCache(val p : DataCacheConfig, mmuParameter : MemoryTranslatorBusParam
     }
 
     val dataMux = earlyDataMux generate MuxOH(wayHits, ways.map(_.dataReadRsp))
+    val predictedWay = wayPrediction generate stagePipe(stage0.predictedWay)
     val wayInvalidate = stagePipe(stage0. wayInvalidate)
     val dataColisions = if(mergeExecuteMemory){
       stagePipe(stage0.dataColisions)
@@ -819,6 +869,12 @@ class DataCache(val p : DataCacheConfig, mmuParameter : MemoryTranslatorBusParam
       //Assume the writeback stage will never be unstall memory acces while memory stage is stalled
       stagePipe(stage0.dataColisions) | collisionProcess(io.cpu.memory.address(lineRange.high downto cpuWordRange.low), mask)
     }
+    //Cache block operations may update a line over many cycles, accumulate while stalled
+    val blockOpHazard = withCacheBlockOps generate RegInit(False)
+    if(withCacheBlockOps) {
+      blockOpHazard setWhen(blockOpWrite)
+      when(!io.cpu.memory.isStuck) { blockOpHazard := blockOpWrite }
+    }
   }
 
   val stageB = new Area {
@@ -832,16 +888,21 @@ class DataCache(val p : DataCacheConfig, mmuParameter : MemoryTranslatorBusParam
     val wayInvalidate = stagePipe(stageA. wayInvalidate)
     val consistancyHazard = if(stageA.consistancyCheck != null) stagePipe(stageA.consistancyCheck.hazard) else False
     val dataColisions = stagePipe(stageA.dataColisions)
+    val blockOpHazard = if(withCacheBlockOps) stagePipe(stageA.blockOpHazard || blockOpWrite) else False
 //    val unaligned = if(!catchUnaligned) False else stagePipe((stageA.request.size === 2 && io.cpu.memory.address(1 downto 0) =/= 0) || (stageA.request.size === 1 && io.cpu.memory.address(0 downto 0) =/= 0))
     val unaligned = if(!catchUnaligned) False else stagePipe((1 to log2Up(p.cpuDataBytes)).map(i => stageA.request.size === i && io.cpu.memory.address(i-1 downto 0) =/= 0).orR)
     val waysHitsBeforeInvalidate = if(earlyWaysHits) stagePipe(B(stageA.wayHits)) else B(tagsReadRsp.map(tag => mmuRsp.physicalAddress(tagRange) === tag.address && tag.valid).asBits())
     val waysHits = waysHitsBeforeInvalidate & ~wayInvalidate
     val waysHit = waysHits.orR
-    val dataMux = if(earlyDataMux) stagePipe(stageA.dataMux) else MuxOH(waysHits, dataReadRsp)
+    val predictedWay = wayPrediction generate stagePipe(stageA.predictedWay)
+    val wayPredictionMiss = wayPrediction generate (waysHit && (waysHits & UIntToOh(predictedWay)) === 0)
+    val dataMux = if(earlyDataMux) stagePipe(stageA.dataMux) else if(wayPrediction) dataReadRsp.read(predictedWay) else MuxOH(waysHits, dataReadRsp)
     val mask = stagePipe(stageA.mask)
 
     //Loader interface
     val loaderValid = False
+    val loaderZero = withCacheBlockOps generate False
+    val victimRefill = False
 
     val ioMemRspMuxed = io.mem.rsp.data.subdivideIn(cpuDataWidth bits).read(io.cpu.writeBack.address(memWordToCpuWordRange))
 
@@ -892,6 +953,8 @@ class DataCache(val p : DataCacheConfig, mmuParameter : MemoryTranslatorBusParam
     val isAmoCached = if(withInternalAmo) isAmo else False
     val isExternalLsrc = if(withExternalLrSc) request.isLrsc else False
     val isExternalAmo  = if(withExternalAmo)  request.isAmo  else False
+    val isCbo = if(withCacheBlockOps) request.isCbo else False
+    val isPrefetch = if(withCacheBlockOps) request.isPrefetch else False
 
     val requestDataBypass = CombInit(io.cpu.writeBack.storeData)
     import DataCacheExternalAmoStates._
@@ -926,6 +989,63 @@ class DataCache(val p : DataCacheConfig, mmuParameter : MemoryTranslatorBusParam
     }
 
 
+    //As the cache is write through, cbo.clean only check the permissions, cbo.flush behave like cbo.inval.
+    //cbo.zero allocate the line zeroed by the loader on misses, then write it word per word in the cache and the memory.
+    //Prefetches never trap, they are dropped if the line is present, not cacheable or not accessible.
+    val blockOps = withCacheBlockOps generate new Area{
+      val counter = Counter(bytePerLine/cpuDataBytes)
+      val address = mmuRsp.physicalAddress(tagRange.high downto lineRange.low) @@ counter.value @@ U(0, log2Up(cpuDataBytes) bits)
+      when(!io.cpu.writeBack.isStuck){
+        counter.clear()
+      }
+
+      def logic(): Unit = {
+        io.cpu.writeBack.haltIt := False
+        when(mmuRsp.isIoAccess) {
+          //Nothing cached
+        } elsewhen(isPrefetch) {
+          when(!waysHit && !loadStoreFault) {
+            io.mem.cmd.valid setWhen(!memCmdSent)
+            io.mem.cmd.address(0, (if(criticalWordFirst) memWordRange.low else lineRange.low) bits) := 0
+            io.mem.cmd.size := log2Up(p.bytePerLine)
+            io.cpu.writeBack.haltIt := !io.mem.cmd.ready
+            loaderValid setWhen(io.mem.cmd.ready)
+          }
+        } elsewhen(request.cboCtrl.invalidate) {
+          tagsWriteCmd.valid := waysHit
+          tagsWriteCmd.address := mmuRsp.physicalAddress(lineRange)
+          tagsWriteCmd.way := waysHits
+          tagsWriteCmd.data.valid := False
+          blockOpWrite := waysHit
+        } elsewhen(request.cboCtrl.zero) {
+          io.cpu.writeBack.haltIt := True
+          when(waysHit) {
+            io.mem.cmd.valid := True
+            io.mem.cmd.address := address
+            io.mem.cmd.size := log2Up(cpuDataBytes)
+            io.mem.cmd.mask.setAll()
+            io.mem.cmd.data := 0
+
+            dataWriteCmd.valid := True
+            dataWriteCmd.address := address(lineRange.high downto memWordRange.low)
+            dataWriteCmd.data := 0
+            dataWriteCmd.mask := 0
+            dataWriteCmd.mask.subdivideIn(cpuDataWidth/8 bits).write(address(memWordToCpuWordRange), B(cpuDataBytes bits, default -> True))
+            dataWriteCmd.way := waysHits
+            blockOpWrite := True
+
+            when(io.mem.cmd.ready) {
+              counter.increment()
+              io.cpu.writeBack.haltIt clearWhen(counter.willOverflowIfInc)
+            }
+          } otherwise {
+            loaderValid := True
+            loaderZero := True
+          }
+        }
+      }
+    }
+
     val cpuWriteToCache = False
     when(cpuWriteToCache){
       dataWriteCmd.valid setWhen(request.wr && waysHit)
@@ -993,6 +1113,8 @@ class DataCache(val p : DataCacheConfig, mmuParameter : MemoryTranslatorBusParam
             }
           }
         }
+      } elsewhen(isCbo || isPrefetch) {
+        if(withCacheBlockOps) blockOps.logic()
       } elsewhen(mmuRsp.isIoAccess || isExternalLsrc) {
         val waitResponse = !request.wr
         if(withExternalLrSc) waitResponse setWhen(request.isLrsc)
@@ -1027,6 +1149,18 @@ class DataCache(val p : DataCacheConfig, mmuParameter : MemoryTranslatorBusParam
             if(withAmo) io.mem.cmd.valid := False
           }
 
+          //The wrong way was read, correct the predictor and replay the access
+          if(wayPrediction) when((!request.wr || isAmoCached) && wayPredictionMiss){
+            io.cpu.redo := True
+            wayPredictor.update.valid := True
+            wayPredictor.update.address := mmuRsp.physicalAddress(lineRange)
+            wayPredictor.update.way := OHToUInt(waysHits)
+            if(withAmo) {
+              io.mem.cmd.valid := False
+              dataWriteCmd.valid := False
+            }
+          }
+
           if(withInternalLrSc) when(request.isLrsc && !lrSc.reserved){
             io.mem.cmd.valid := False
             dataWriteCmd.valid := False
@@ -1036,10 +1170,11 @@ class DataCache(val p : DataCacheConfig, mmuParameter : MemoryTranslatorBusParam
           //Emit cmd
           io.mem.cmd.valid setWhen(!memCmdSent)
           io.mem.cmd.wr := False
-          io.mem.cmd.address(0, lineRange.low bits) := 0
+          io.mem.cmd.address(0, (if(criticalWordFirst) memWordRange.low else lineRange.low) bits) := 0
           io.mem.cmd.size := log2Up(p.bytePerLine)
 
           loaderValid setWhen(io.mem.cmd.ready)
+          victimRefill := True
         }
       }
     }
@@ -1052,6 +1187,10 @@ class DataCache(val p : DataCacheConfig, mmuParameter : MemoryTranslatorBusParam
       io.cpu.writeBack.data := dataMux
       if(catchAccessError) io.cpu.writeBack.accessError := (waysHits & B(tagsReadRsp.map(_.error))) =/= 0 || (loadStoreFault && !mmuRsp.isPaging)
     }
+    when(isPrefetch){
+      io.cpu.writeBack.accessError := False
+      io.cpu.writeBack.mmuException := False
+    }
 
     if(withLrSc) {
       val success = if(withInternalLrSc)lrSc.reserved else io.mem.rsp.exclusive
@@ -1067,18 +1206,33 @@ class DataCache(val p : DataCacheConfig, mmuParameter : MemoryTranslatorBusParam
       requestDataBypass.subdivideIn(p.rfDataWidth bits).foreach(_ := amo.resultReg)
     }
 
+    //With critical word first, the missing load complete on its word while the loader keep filling the line in the background,
+    //prefetches complete as soon as their refill is issued.
+    //Memory accesses reaching this stage meanwhile were pipelined against the old line state and are replayed.
+    val background = withBackgroundRefill generate new Area{
+      val loading = False //Driven by the loader
+      val owner = RegInit(False) setWhen(loaderValid) clearWhen(!io.cpu.writeBack.isValid || !io.cpu.writeBack.isStuck)
+      val earlyRestart = if(criticalWordFirst) !request.wr && !isAmo && !isPrefetch && (if(withLrSc) !request.isLrsc else True) else False
+      val noRedo = RegNextWhen(earlyRestart || isPrefetch, loaderValid)
+      val hazard = loading && !owner
+      loaderValid clearWhen(memCmdSent)
+    }
+    val refillHazard = if(withBackgroundRefill) background.hazard else False
+
     //remove side effects on exceptions
     when(io.cpu.writeBack.isValid) {
-      when(consistancyHazard || mmuRsp.refilling || io.cpu.writeBack.accessError || io.cpu.writeBack.mmuException || io.cpu.writeBack.unalignedAccess) {
+      when(consistancyHazard || refillHazard || blockOpHazard || mmuRsp.refilling || io.cpu.writeBack.accessError || io.cpu.writeBack.mmuException || io.cpu.writeBack.unalignedAccess) {
         io.mem.cmd.valid := False
         tagsWriteCmd.valid := False
         dataWriteCmd.valid := False
         loaderValid := False
+        victimRefill := False
         io.cpu.writeBack.haltIt := False
+        blockOpWrite := False
         if (withInternalLrSc) lrSc.reserved := lrSc.reserved
         if (withExternalAmo) amo.external.state := LR_CMD
       }
-      io.cpu.redo setWhen((mmuRsp.refilling || consistancyHazard))
+      io.cpu.redo setWhen((mmuRsp.refilling || consistancyHazard || refillHazard || blockOpHazard) && !isPrefetch)
     }
 
     assert(!(io.cpu.writeBack.isValid && !io.cpu.writeBack.haltIt && io.cpu.writeBack.isStuck), "writeBack stuck by another plugin is not allowed", ERROR)
@@ -1094,18 +1248,22 @@ class DataCache(val p : DataCacheConfig, mmuParameter : MemoryTranslatorBusParam
     val kill = False
     val killReg = RegInit(False) setWhen(kill)
 
-    when(valid && io.mem.rsp.valid && rspLast){
+    val wordIndex = if(criticalWordFirst) counter.value + baseAddress(memWordRange) else counter.value
+    val zero = withCacheBlockOps generate RegNextWhen(stageB.loaderZero, stageB.loaderValid) //cbo.zero allocation, no memory refill
+    val rspValid = io.mem.rsp.valid && rspLast && (if(withCacheBlockOps) !zero else True)
+
+    when(valid && (if(withCacheBlockOps) rspValid || zero else rspValid)){
       dataWriteCmd.valid := True
-      dataWriteCmd.address := baseAddress(lineRange) @@ counter
-      dataWriteCmd.data := io.mem.rsp.data
+      dataWriteCmd.address := baseAddress(lineRange) @@ wordIndex
+      dataWriteCmd.data := (if(withCacheBlockOps) zero ? B(0, memDataWidth bits) | io.mem.rsp.data else io.mem.rsp.data)
       dataWriteCmd.mask.setAll()
       dataWriteCmd.way := waysAllocator
-      error := error | io.mem.rsp.error
+      error := error | (rspValid && io.mem.rsp.error)
       counter.increment()
     }
 
     val done = CombInit(counter.willOverflow)
-    if(withInvalidate) done setWhen(valid && pending.counter === 0) //Used to solve invalidate write request at the same time
+    if(withInvalidate) done setWhen(valid && pending.counter === 0 && (if(withCacheBlockOps) !zero else True)) //Used to solve invalidate write request at the same time
 
     when(done){
       valid := False
@@ -1115,9 +1273,15 @@ class DataCache(val p : DataCacheConfig, mmuParameter : MemoryTranslatorBusParam
       tagsWriteCmd.address := baseAddress(lineRange)
       tagsWriteCmd.data.valid := !(kill || killReg)
       tagsWriteCmd.data.address := baseAddress(tagRange)
-      tagsWriteCmd.data.error := error || (io.mem.rsp.valid && io.mem.rsp.error)
+      tagsWriteCmd.data.error := error || (io.mem.rsp.valid && io.mem.rsp.error && (if(withCacheBlockOps) !zero else True))
       tagsWriteCmd.way := waysAllocator
 
+      if(wayPrediction) {
+        wayPredictor.update.valid := True
+        wayPredictor.update.address := baseAddress(lineRange)
+        wayPredictor.update.way := OHToUInt(waysAllocator)
+      }
+
       error := False
       killReg := False
     }
@@ -1126,12 +1290,173 @@ class DataCache(val p : DataCacheConfig, mmuParameter : MemoryTranslatorBusParam
       waysAllocator := (waysAllocator ## waysAllocator.msb).resized
     }
 
-    io.cpu.redo setWhen(valid.rise())
+    //The first beat is the critical word, release the load which missed
+    if(withBackgroundRefill) stageB.background.loading := valid
+    if(criticalWordFirst) {
+      when(valid && rspValid && counter.value === 0 && io.cpu.writeBack.isValid && stageB.background.owner && stageB.background.earlyRestart){
+        io.cpu.writeBack.haltIt := False
+        io.cpu.writeBack.data := stageB.ioMemRspMuxed
+        if(catchAccessError) io.cpu.writeBack.accessError := io.mem.rsp.error
+      }
+    }
+
+    io.cpu.redo setWhen(valid.rise() && (if(withBackgroundRefill) !stageB.background.noRedo else True))
     io.cpu.execute.refilling := valid
 
     stageB.mmuRspFreeze setWhen(stageB.loaderValid || valid)
   }
 
+  //Small fully associative buffer of the lines evicted by refills. As the cache is write through, those lines are always clean.
+  //A line may be present in both the cache and the buffer, stores and invalidations drop it from the buffer.
+  val victim = withVictim generate new Area{
+    def lineAddress(address : UInt) = address(hitRange)
+
+    val entries = for(i <- 0 until victimLineCount) yield new Area{
+      val valid = RegInit(False)
+      val address = Reg(UInt(hitRange.length bits))
+      val invalidate = False
+      val probeHit = valid && !invalidate && address === lineAddress(stageB.mmuRsp.physicalAddress)
+    }
+    val data = Mem(Bits(memDataWidth bits), victimLineCount*memWordPerLine)
+
+    //Invalidation requests line index, driven by the invalidate area
+    val invLine = Flow(UInt(lineRange.length bits))
+    invLine.valid := False
+    invLine.payload.assignDontCare()
+    def invHit(line : UInt) = invLine.valid && invLine.payload === line
+
+    //Track the invalidations which happened between the cache tags read and the eviction
+    val stale = new Area{
+      val onMemory = !mergeExecuteMemory generate Reg(Bool())
+      val onWriteBack = Reg(Bool())
+      if(!mergeExecuteMemory) {
+        when(!io.cpu.memory.isStuck) {
+          onMemory := invHit(io.cpu.execute.address(lineRange))
+        } otherwise {
+          onMemory setWhen(invHit(io.cpu.memory.address(lineRange)))
+        }
+      }
+      when(!io.cpu.writeBack.isStuck) {
+        onWriteBack := (if(mergeExecuteMemory) False else onMemory) || invHit(io.cpu.memory.address(lineRange))
+      } otherwise {
+        onWriteBack setWhen(invHit(stageB.mmuRsp.physicalAddress(lineRange)))
+      }
+    }
+
+    val evictedTag = stageB.tagsReadRsp.head
+    val evictedValid = evictedTag.valid && !evictedTag.error && !stageB.wayInvalidate(0) && !stale.onWriteBack && !invHit(stageB.mmuRsp.physicalAddress(lineRange))
+
+    //Move a line from the cache to the buffer, and on swap, move the buffer line into the cache at the same time
+    val engine = new Area{
+      val busy = RegInit(False)
+      val swap = Reg(Bool())
+      val counter = Reg(UInt(log2Up(memWordPerLine + 2) bits))
+      val entry = Reg(UInt(log2Up(victimLineCount) bits))
+      val lineIndex = Reg(UInt(lineRange.length bits))
+      val cacheLine = Reg(UInt(hitRange.length bits))
+      val cacheLineValid = Reg(Bool())
+      val bufferLine = Reg(UInt(hitRange.length bits))
+      val kill = Reg(Bool())
+      val launched = RegInit(False) clearWhen(!io.cpu.writeBack.isStuck)
+      val roundRobin = Reg(UInt(log2Up(victimLineCount) bits)) init(0)
+      val hold = False
+
+      val probeHits = B(entries.map(_.probeHit))
+      val freeEntries = B(entries.map(!_.valid))
+      val allocation = freeEntries.orR ? OHToUInt(OHMasking.first(freeEntries)) | roundRobin
+
+      //Only start on the first refill cycle, to ensure the cache words are read before the refill overwrite them
+      val startSwap = stageB.victimRefill && !launched && !busy && probeHits.orR
+      val startSave = stageB.victimRefill && !launched && !busy && !probeHits.orR && evictedValid
+      launched setWhen(stageB.victimRefill)
+
+      when(startSwap){
+        io.mem.cmd.valid := False
+        stageB.loaderValid := False
+        io.cpu.redo := True
+      }
+      when(startSave){
+        roundRobin := roundRobin + 1
+      }
+      when(startSwap || startSave){
+        busy := True
+        swap := startSwap
+        counter := 0
+        entry := startSwap ? OHToUInt(OHMasking.first(probeHits)) | allocation
+        lineIndex := stageB.mmuRsp.physicalAddress(lineRange)
+        cacheLine := evictedTag.address @@ stageB.mmuRsp.physicalAddress(lineRange)
+        cacheLineValid := evictedValid
+        bufferLine := lineAddress(stageB.mmuRsp.physicalAddress)
+        kill := False
+      }
+
+      //Words are read from the cache on counter 0 until memWordPerLine-1, then written one cycle later
+      val wordIndex = counter.resize(log2Up(memWordPerLine))
+      val previousWordIndex = (counter - 1).resize(log2Up(memWordPerLine))
+      val reading = counter < memWordPerLine
+      val writing = counter =/= 0 && counter <= memWordPerLine
+      val done = busy && counter === memWordPerLine + 1 && !hold
+      val bufferWord = data.readAsync(entry @@ previousWordIndex, readFirst)
+
+      when(busy && (reading || writing)){
+        counter := counter + 1
+      }
+
+      when(busy && reading){
+        dataReadForce := True
+        dataReadCmd.valid := True
+        dataReadCmd.payload := lineIndex @@ wordIndex
+      }
+
+      when(busy && writing){
+        data.write(entry @@ previousWordIndex, ways.head.dataReadRspMem)
+        when(swap){
+          dataWriteCmd.valid := True
+          dataWriteCmd.way.setAll()
+          dataWriteCmd.address := lineIndex @@ previousWordIndex
+          dataWriteCmd.data := bufferWord
+          dataWriteCmd.mask.setAll()
+        }
+      }
+
+      //Both lines share the same index, any invalidation on it drop them
+      kill setWhen(invHit(lineIndex))
+      val killNow = kill || invHit(lineIndex)
+
+      when(done){
+        busy := False
+        for((e, id) <- entries.zipWithIndex) when(entry === id){
+          e.valid := cacheLineValid && !killNow
+          e.address := cacheLine
+        }
+        when(swap){
+          tagsWriteCmd.valid := True
+          tagsWriteCmd.way.setAll()
+          tagsWriteCmd.address := lineIndex
+          tagsWriteCmd.data.valid := !killNow
+          tagsWriteCmd.data.error := False
+          tagsWriteCmd.data.address := (bufferLine >> lineRange.length).resized
+        }
+      }
+
+      io.cpu.execute.refilling setWhen(busy)
+    }
+
+    //Write through stores make the buffer copy obsolete
+    when(io.cpu.writeBack.isValid && stageB.request.wr && !stageB.mmuRsp.isIoAccess){
+      for(e <- entries) e.invalidate setWhen(e.valid && e.address === lineAddress(stageB.mmuRsp.physicalAddress))
+    }
+
+    //Cache flush
+    when(stageB.flusher.start){
+      entries.foreach(_.invalidate := True)
+      engine.kill := True
+    }
+    engine.hold setWhen(!stageB.flusher.counter.msb)
+
+    for(e <- entries) e.valid clearWhen(e.invalidate)
+  }
+
   val invalidate = withInvalidate generate new Area{
     val s0 = new Area{
       val input = io.mem.inv
@@ -1164,7 +1489,16 @@ class DataCache(val p : DataCacheConfig, mmuParameter : MemoryTranslatorBusParam
       val wayHits = RegNextWhen(s1.wayHits, s1.input.ready)
       val wayHit = wayHits.orR
 
+      val victimHit = if(withVictim) B(victim.entries.map(e => e.valid && e.address === input.address(hitRange))).orR else False
+
       when(input.valid && input.enable) {
+        if(withVictim) {
+          victim.invLine.valid := True
+          victim.invLine.payload := input.address(lineRange)
+          for(e <- victim.entries) e.invalidate setWhen(e.valid && e.address === input.address(hitRange))
+          victim.engine.hold setWhen(wayHit)
+        }
+
         //Manage invalidate write during cpu read hazard
         when(input.address(lineRange) === io.cpu.execute.address(lineRange)) {
           stage0.wayInvalidate := wayHits
@@ -1181,7 +1515,7 @@ class DataCache(val p : DataCacheConfig, mmuParameter : MemoryTranslatorBusParam
         }
       }
       io.mem.ack.arbitrationFrom(input)
-      io.mem.ack.hit := wayHit
+      io.mem.ack.hit := wayHit || victimHit
       io.mem.ack.last := input.last
 
       //Manage invalidation read during write hazard
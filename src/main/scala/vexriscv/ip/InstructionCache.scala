@@ -25,9 +25,15 @@ case class InstructionCacheConfig( cacheSize : Int,
                                    twoCycleRamInnerMux : Boolean = false,
                                    preResetFlush : Boolean = false,
                                    bypassGen : Boolean = false,
-                                   reducedBankWidth : Boolean = false){
+                                   reducedBankWidth : Boolean = false,
+                                   wayPrediction : Boolean = false,
+                                   criticalWordFirst : Boolean = false,
+                                   wayLocking : Boolean = false){
 
   assert(!(twoCycleRam && !twoCycleCache))
+  assert(!(wayPrediction && (twoCycleRam || reducedBankWidth || wayCount == 1)))
+  assert(!(criticalWordFirst && burstSize == 1))
+  assert(!(wayLocking && wayCount == 1), "Way locking require at least two ways")
 
   def burstSize = bytePerLine*8/memDataWidth
   def catchSomething = catchAccessFault || catchIllegalAccess
@@ -47,7 +53,8 @@ case class InstructionCacheConfig( cacheSize : Int,
     dataWidth = memDataWidth,
     burstCountWidth = log2Up(burstSize + 1)).getReadOnlyConfig.copy(
     useResponse = true,
-    constantBurstBehavior = true
+    constantBurstBehavior = true,
+    linewrapBursts = criticalWordFirst
   )
 
   def getPipelinedMemoryBusConfig() = PipelinedMemoryBusConfig(
@@ -71,6 +78,13 @@ case class InstructionCacheConfig( cacheSize : Int,
     addressGranularity = AddressGranularity.WORD
   )
 
+  def getWishboneBte() = if(!criticalWordFirst) B"00" else burstSize match {
+    case 4 => B"01"
+    case 8 => B"10"
+    case 16 => B"11"
+    case _ => SpinalError("Wishbone wrapped bursts are 4, 8 or 16 beats long")
+  }
+
   def getBmbParameter() = BmbParameter(
     BmbAccessParameter(
       addressWidth = 32,
@@ -98,6 +112,17 @@ case class InstructionCacheCpuPrefetch(p : InstructionCacheConfig) extends Bundl
   }
 }
 
+case class InstructionCacheLock(p : InstructionCacheConfig) extends Bundle with IMasterSlave{
+  val ways = Bits(p.wayCount bits) //Skipped by the refills and the flushes, the way 0 can't be locked
+  val preload = Flow(UInt(p.addressWidth bits)) //Refill the last way with the way sized window starting at that address
+  val preloading = Bool
+
+  override def asMaster(): Unit = {
+    out(ways, preload)
+    in(preloading)
+  }
+}
+
 trait InstructionCacheCommons{
   val isValid : Bool
   val isStuck : Bool
@@ -105,6 +130,7 @@ trait InstructionCacheCommons{
   val physicalAddress : UInt
   val data   : Bits
   val cacheMiss, error,  mmuRefilling, mmuException, isUser : Bool
+  val wayMiss : Bool
 }
 
 case class InstructionCacheCpuFetch(p : InstructionCacheConfig, mmuParameter : MemoryTranslatorBusParameter) extends Bundle with IMasterSlave with InstructionCacheCommons {
@@ -118,10 +144,11 @@ case class InstructionCacheCpuFetch(p : InstructionCacheConfig, mmuParameter : M
   val mmuRsp  = MemoryTranslatorRsp(mmuParameter)
   val physicalAddress = UInt(p.addressWidth bits)
   val cacheMiss, error, mmuRefilling, mmuException, isUser  = ifGen(!p.twoCycleCache)(Bool)
+  val wayMiss = ifGen(!p.twoCycleCache && p.wayPrediction)(Bool)
 
   override def asMaster(): Unit = {
     out(isValid, isStuck, isRemoved, pc)
-    inWithNull(error,mmuRefilling,mmuException,data, cacheMiss,physicalAddress)
+    inWithNull(error,mmuRefilling,mmuException,data, cacheMiss,physicalAddress, wayMiss)
     outWithNull(isUser, dataBypass, dataBypassValid)
     out(mmuRsp)
   }
@@ -135,11 +162,12 @@ case class InstructionCacheCpuDecode(p : InstructionCacheConfig) extends Bundle
   val physicalAddress = UInt(p.addressWidth bits)
   val data  =  Bits(p.cpuDataWidth bits)
   val cacheMiss, error, mmuRefilling, mmuException, isUser  = ifGen(p.twoCycleCache)(Bool)
+  val wayMiss = ifGen(p.twoCycleCache && p.wayPrediction)(Bool)
 
   override def asMaster(): Unit = {
     out(isValid, isStuck, pc)
     outWithNull(isUser)
-    inWithNull(error, mmuRefilling, mmuException,data, cacheMiss, physicalAddress)
+    inWithNull(error, mmuRefilling, mmuException,data, cacheMiss, physicalAddress, wayMiss)
   }
 }
 
@@ -173,6 +201,9 @@ case class InstructionCacheMemBus(p : InstructionCacheConfig) extends Bundle wit
     slave(rsp)
   }
 
+  //Word offset of the beats, wrapping around the line when the burst start at the critical word
+  def burstOffset(counter : UInt, addressShift : Int) : UInt = if(p.criticalWordFirst) cmd.address(addressShift, widthOf(counter) bits) + counter else counter
+
   def toAxi4ReadOnly(): Axi4ReadOnly = {
     val axiConfig = p.getAxi4Config()
     val mm = Axi4ReadOnly(axiConfig)
@@ -182,7 +213,7 @@ case class InstructionCacheMemBus(p : InstructionCacheConfig) extends Bundle wit
     mm.readCmd.addr := cmd.address
     mm.readCmd.prot  := "110"
     mm.readCmd.cache := "1111"
-    mm.readCmd.setBurstINCR()
+    if(p.criticalWordFirst) mm.readCmd.setBurstWRAP() else mm.readCmd.setBurstINCR()
     cmd.ready := mm.readCmd.ready
     rsp.valid := mm.readRsp.valid
     rsp.data  := mm.readRsp.data
@@ -210,7 +241,7 @@ case class InstructionCacheMemBus(p : InstructionCacheConfig) extends Bundle wit
     val bus = PipelinedMemoryBus(pipelinedMemoryBusConfig)
     val counter = Counter(p.burstSize, bus.cmd.fire)
     bus.cmd.valid := cmd.valid
-    bus.cmd.address := cmd.address(31 downto widthOf(counter.value) + 2) @@ counter @@ U"00"
+    bus.cmd.address := cmd.address(31 downto widthOf(counter.value) + 2) @@ burstOffset(counter, 2) @@ U"00"
     bus.cmd.write := False
     bus.cmd.mask.assignDontCare()
     bus.cmd.data.assignDontCare()
@@ -229,9 +260,9 @@ case class InstructionCacheMemBus(p : InstructionCacheConfig) extends Bundle wit
     val pending = counter =/= 0
     val lastCycle = counter === counter.maxValue
 
-    bus.ADR := (cmd.address >> widthOf(counter) + log2Up(p.memDataWidth/8)) @@ counter
+    bus.ADR := (cmd.address >> widthOf(counter) + log2Up(p.memDataWidth/8)) @@ burstOffset(counter, log2Up(p.memDataWidth/8))
     bus.CTI := lastCycle ? B"111" | B"010"
-    bus.BTE := "00"
+    bus.BTE := p.getWishboneBte()
     bus.SEL.setAll()
     bus.WE  := False
     bus.DAT_MOSI.assignDontCare()
@@ -253,6 +284,7 @@ case class InstructionCacheMemBus(p : InstructionCacheConfig) extends Bundle wit
   }
 
   def toBmb() : Bmb = {
+    assert(!p.criticalWordFirst, "Bmb doesn't support wrapped bursts")
     val busParameter = p.getBmbParameter
     val bus = Bmb(busParameter).setCompositeName(this,"toBmb", true)
     bus.cmd.arbitrationFrom(cmd)
@@ -285,6 +317,7 @@ class InstructionCache(p : InstructionCacheConfig, mmuParameter : MemoryTranslat
     val flush = in Bool()
     val cpu = slave(InstructionCacheCpuBus(p, mmuParameter))
     val mem = master(InstructionCacheMemBus(p))
+    val lock = wayLocking generate slave(InstructionCacheLock(p))
   }
 
   val lineWidth = bytePerLine*8
@@ -296,6 +329,7 @@ class InstructionCache(p : InstructionCacheConfig, mmuParameter : MemoryTranslat
 
   val tagRange = addressWidth-1 downto log2Up(wayLineCount*bytePerLine)
   val lineRange = tagRange.low-1 downto log2Up(bytePerLine)
+  val memWordRange = log2Up(bytePerLine)-1 downto log2Up(memDataWidth/8)
 
   case class LineTag() extends Bundle{
     val valid = Bool
@@ -320,6 +354,19 @@ class InstructionCache(p : InstructionCacheConfig, mmuParameter : MemoryTranslat
     }
   })
 
+  //MRU way per line, only the predicted way bank is read, the fetch is redone on mispredictions
+  val wayPredictor = wayPrediction generate new Area{
+    val mru = Mem(UInt(log2Up(wayCount) bits), wayLineCount)
+    val read = mru.readAsync(io.cpu.prefetch.pc(lineRange))
+    val update = Flow(new Bundle{
+      val address = UInt(lineRange.length bits)
+      val way = UInt(log2Up(wayCount) bits)
+    })
+    update.valid := False
+    update.payload.assignDontCare()
+    mru.write(update.address, update.way, update.valid)
+  }
+
 
   val lineLoader = new Area{
     val fire = False
@@ -327,13 +374,30 @@ class InstructionCache(p : InstructionCacheConfig, mmuParameter : MemoryTranslat
     val address = KeepAttribute(Reg(UInt(addressWidth bits)))
     val hadError = RegInit(False) clearWhen(fire)
     val flushPending = RegInit(True)
+    val wordIndex = KeepAttribute(Reg(UInt(log2Up(memWordPerLine) bits)) init(0))
+    val beatIndex = criticalWordFirst generate Reg(UInt(log2Up(memWordPerLine) bits)) init(0)
 
-    when(io.cpu.fill.valid){
+    //With critical word first, fetches may continue during the refill, the miss they may produce are replayed until the loader is done
+    when(io.cpu.fill.valid && (if(criticalWordFirst) !valid else True)){
       valid := True
       address := io.cpu.fill.payload
     }
 
-    io.cpu.prefetch.haltIt := valid || flushPending
+    //Let the prefetch read the words of the refilled line which already landed in the banks
+    val earlyRestart = criticalWordFirst generate new Area{
+      val wordsLoaded = Reg(Bits(memWordPerLine bits))
+      when(io.cpu.fill.valid && !valid){
+        wordsLoaded := 0
+        wordIndex := io.cpu.fill.payload(memWordRange)
+      }
+      when(io.mem.rsp.valid){
+        wordsLoaded(wordIndex) := True
+      }
+      val lineHit = valid && io.cpu.prefetch.pc(lineRange) === address(lineRange)
+      val allowed = lineHit && wordsLoaded(io.cpu.prefetch.pc(memWordRange))
+    }
+
+    io.cpu.prefetch.haltIt := (if(criticalWordFirst) valid && !earlyRestart.allowed else valid) || flushPending
 
     val flushCounter = Reg(UInt(log2Up(wayLineCount) + 1 bit))
     when(!flushCounter.msb){
@@ -354,15 +418,53 @@ class InstructionCache(p : InstructionCacheConfig, mmuParameter : MemoryTranslat
       flushPending := False
     }
 
+    //Fill every line of the last way from a way sized window, one refill after the other, while the fetch is halted
+    val preload = wayLocking generate new Area{
+      val busy = RegInit(False)
+      val base = Reg(UInt(tagRange.length bits))
+      val counter = Reg(UInt(log2Up(wayLineCount) + 1 bits))
+      val launch = busy && !counter.msb && !valid && !io.cpu.fill.valid && !flushPending && flushCounter.msb
+
+      when(io.lock.preload.valid){
+        busy := True
+        base := io.lock.preload.payload(tagRange)
+        counter := 0
+      }
+      when(launch){
+        valid := True
+        address := base @@ counter.resize(lineRange.length) @@ U(0, lineRange.low bits)
+        wordIndex := 0
+        counter := counter + 1
+      }
+      when(busy && counter.msb && !valid){
+        busy := False
+      }
+
+      io.lock.preloading := busy
+      io.cpu.prefetch.haltIt setWhen(busy)
+    }
 
 
     val cmdSent = RegInit(False) setWhen(io.mem.cmd.fire) clearWhen(fire)
     io.mem.cmd.valid := valid && !cmdSent
     io.mem.cmd.address := address(tagRange.high downto lineRange.low) @@ U(0,lineRange.low bit)
+    if(criticalWordFirst) io.mem.cmd.address(memWordRange) := address(memWordRange)
     io.mem.cmd.size := log2Up(p.bytePerLine)
 
     val wayToAllocate = Counter(wayCount, !valid)
-    val wordIndex = KeepAttribute(Reg(UInt(log2Up(memWordPerLine) bits)) init(0))
+
+    //The way is captured when the refill start, as the locks may change during it
+    val lock = wayLocking generate new Area{
+      val ways = io.lock.ways & ~B(1, wayCount bits)
+      val way = Reg(UInt(log2Up(wayCount) bits)) init(0)
+      when(!valid){
+        way := ways(wayToAllocate.value) ? OHToUInt(OHMasking.first(~ways)) | wayToAllocate.value
+        when(preload.launch){
+          way := wayCount-1
+        }
+      }
+    }
+    val allocatedWay = if(wayLocking) lock.way else wayToAllocate.value
 
 
     val write = new Area{
@@ -371,23 +473,29 @@ class InstructionCache(p : InstructionCacheConfig, mmuParameter : MemoryTranslat
     }
 
     for(wayId <- 0 until wayCount){
-      val wayHit = wayToAllocate === wayId
+      val wayHit = allocatedWay === wayId
       val tag = write.tag(wayId)
-      tag.valid := ((wayHit && fire) || !flushCounter.msb)
+      tag.valid := ((wayHit && fire) || !flushCounter.msb && (if(wayLocking) !lock.ways(wayId) else True))
       tag.address := (flushCounter.msb ? address(lineRange) | flushCounter(flushCounter.high-1 downto 0))
       tag.data.valid := flushCounter.msb
       tag.data.error := hadError || io.mem.rsp.error
       tag.data.address := address(tagRange)
     }
 
+    if(wayPrediction) when(fire){
+      wayPredictor.update.valid := True
+      wayPredictor.update.address := address(lineRange)
+      wayPredictor.update.way := allocatedWay
+    }
+
     for((writeBank, bankId) <- write.data.zipWithIndex){
       if(!reducedBankWidth) {
-        writeBank.valid := io.mem.rsp.valid && wayToAllocate === bankId
+        writeBank.valid := io.mem.rsp.valid && allocatedWay === bankId
         writeBank.address := address(lineRange) @@ wordIndex
         writeBank.data := io.mem.rsp.data
       } else {
-        val sel = U(bankId) - wayToAllocate.value
-        val groupSel = wayToAllocate(log2Up(bankCount)-1 downto log2Up(bankCount/memToBankRatio))
+        val sel = U(bankId) - allocatedWay
+        val groupSel = allocatedWay(log2Up(bankCount)-1 downto log2Up(bankCount/memToBankRatio))
         val subSel = sel(log2Up(bankCount/memToBankRatio) -1 downto 0)
         writeBank.valid := io.mem.rsp.valid && groupSel === (bankId >> log2Up(bankCount/memToBankRatio))
         writeBank.address := address(lineRange) @@ wordIndex @@ (subSel)
@@ -398,8 +506,9 @@ class InstructionCache(p : InstructionCacheConfig, mmuParameter : MemoryTranslat
 
     when(io.mem.rsp.valid) {
       wordIndex := (wordIndex + 1).resized
+      if(criticalWordFirst) beatIndex := beatIndex + 1
       hadError.setWhen(io.mem.rsp.error)
-      when(wordIndex === wordIndex.maxValue) {
+      when((if(criticalWordFirst) beatIndex else wordIndex) === memWordPerLine-1) {
         fire := True
       }
     }
@@ -407,8 +516,10 @@ class InstructionCache(p : InstructionCacheConfig, mmuParameter : MemoryTranslat
 
   val fetchStage = new Area{
     val read = new Area{
-      val banksValue = for(bank <- banks) yield new Area{
-        val dataMem = bank.readSync(io.cpu.prefetch.pc(lineRange.high downto log2Up(bankWidth/8)), !io.cpu.fetch.isStuck)
+      val predictedWay = wayPrediction generate RegNextWhen(wayPredictor.read, !io.cpu.fetch.isStuck)
+      val banksValue = for((bank, bankId) <- banks.zipWithIndex) yield new Area{
+        val readEnable = if(wayPrediction) wayPredictor.read === bankId else True
+        val dataMem = bank.readSync(io.cpu.prefetch.pc(lineRange.high downto log2Up(bankWidth/8)), !io.cpu.fetch.isStuck && readEnable)
         val data = if(!twoCycleRamInnerMux) dataMem.subdivideIn(cpuDataWidth bits).read(io.cpu.fetch.pc(bankWordToCpuWordRange)) else dataMem
       }
 
@@ -422,19 +533,42 @@ class InstructionCache(p : InstructionCacheConfig, mmuParameter : MemoryTranslat
       }
     }
 
+    //The refilled line hit on the words read after their arrival, while the tag of its way isn't reliable until the loader is done
+    val earlyRestart = criticalWordFirst generate new Area{
+      def stage[T <: Data](that : T) = RegNextWhen(that, !io.cpu.fetch.isStuck)
+      val loaded = stage(lineLoader.earlyRestart.allowed) init(False)
+      val lineHit = stage(lineLoader.earlyRestart.lineHit) init(False)
+      val address = stage(lineLoader.address(tagRange.high downto lineRange.low))
+      val way = stage(lineLoader.allocatedWay)
+      val error = stage(lineLoader.hadError)
+      val hit = loaded && io.cpu.fetch.mmuRsp.physicalAddress(tagRange.high downto lineRange.low) === address
+
+      def wayHit(wayId : Int, tagHit : Bool, lineHit : Bool, hit : Bool, way : UInt) = (tagHit && !(lineHit && way === wayId)) || (hit && way === wayId)
+    }
+
 
     val hit = (!twoCycleRam) generate new Area{
-      val hits = read.waysValues.map(way => way.tag.valid && way.tag.address === io.cpu.fetch.mmuRsp.physicalAddress(tagRange))
+      val hits = read.waysValues.zipWithIndex.map{case (way, id) =>
+        val tagHit = way.tag.valid && way.tag.address === io.cpu.fetch.mmuRsp.physicalAddress(tagRange)
+        if(!criticalWordFirst) tagHit else earlyRestart.wayHit(id, tagHit, earlyRestart.lineHit, earlyRestart.hit, earlyRestart.way)
+      }
       val valid = Cat(hits).orR
       val wayId = OHToUInt(hits)
       val bankId = if(!reducedBankWidth) wayId else (wayId >> log2Up(bankCount/memToBankRatio)) @@ ((wayId + (io.cpu.fetch.mmuRsp.physicalAddress(log2Up(bankWidth/8), log2Up(bankCount) bits))).resize(log2Up(bankCount/memToBankRatio)))
-      val error = read.waysValues.map(_.tag.error).read(wayId)
-      val data = read.banksValue.map(_.data).read(bankId)
+      val error = if(!criticalWordFirst) read.waysValues.map(_.tag.error).read(wayId) else earlyRestart.hit ? earlyRestart.error | read.waysValues.map(_.tag.error).read(wayId)
+      val wayMiss = wayPrediction generate (valid && wayId =/= read.predictedWay)
+      val data = read.banksValue.map(_.data).read(if(wayPrediction) read.predictedWay else bankId)
       val word = if(cpuDataWidth == memDataWidth || !twoCycleRamInnerMux) CombInit(data) else data.subdivideIn(cpuDataWidth bits).read(io.cpu.fetch.pc(bankWordToCpuWordRange))
       io.cpu.fetch.data := (if(p.bypassGen) (io.cpu.fetch.dataBypassValid ? io.cpu.fetch.dataBypass | word) else word)
       if(twoCycleCache){
         io.cpu.decode.data := RegNextWhen(io.cpu.fetch.data,!io.cpu.decode.isStuck)
       }
+
+      if(wayPrediction) when(io.cpu.fetch.isValid && wayMiss && !lineLoader.fire){
+        wayPredictor.update.valid := True
+        wayPredictor.update.address := io.cpu.fetch.mmuRsp.physicalAddress(lineRange)
+        wayPredictor.update.way := wayId
+      }
     }
 
     if(twoCycleRam && wayCount == 1){
@@ -448,6 +582,7 @@ class InstructionCache(p : InstructionCacheConfig, mmuParameter : MemoryTranslat
       val mmuRsp = io.cpu.fetch.mmuRsp
 
       io.cpu.fetch.cacheMiss := !hit.valid
+      if(wayPrediction) io.cpu.fetch.wayMiss := hit.wayMiss
       io.cpu.fetch.error := hit.error || (!mmuRsp.isPaging && (mmuRsp.exception || !mmuRsp.allowExecute))
       io.cpu.fetch.mmuRefilling := mmuRsp.refilling
       io.cpu.fetch.mmuException := !mmuRsp.refilling && mmuRsp.isPaging && (mmuRsp.exception || !mmuRsp.allowExecute)
@@ -465,11 +600,20 @@ class InstructionCache(p : InstructionCacheConfig, mmuParameter : MemoryTranslat
       val error = stage(fetchStage.hit.error)
     } else new Area{
       val tags = fetchStage.read.waysValues.map(way => stage(way.tag))
-      val hits = tags.map(tag => tag.valid && tag.address === mmuRsp.physicalAddress(tagRange))
+      val earlyRestart = criticalWordFirst generate new Area{
+        val lineHit = stage(fetchStage.earlyRestart.lineHit) init(False)
+        val hit = stage(fetchStage.earlyRestart.hit) init(False)
+        val way = stage(fetchStage.earlyRestart.way)
+        val error = stage(fetchStage.earlyRestart.error)
+      }
+      val hits = tags.zipWithIndex.map{case (tag, id) =>
+        val tagHit = tag.valid && tag.address === mmuRsp.physicalAddress(tagRange)
+        if(!criticalWordFirst) tagHit else fetchStage.earlyRestart.wayHit(id, tagHit, earlyRestart.lineHit, earlyRestart.hit, earlyRestart.way)
+      }
       val valid = Cat(hits).orR
       val wayId = OHToUInt(hits)
       val bankId = if(!reducedBankWidth) wayId else (wayId >> log2Up(bankCount/memToBankRatio)) @@ ((wayId + (mmuRsp.physicalAddress(log2Up(bankWidth/8), log2Up(bankCount) bits))).resize(log2Up(bankCount/memToBankRatio)))
-      val error = tags(wayId).error
+      val error = if(!criticalWordFirst) tags(wayId).error else earlyRestart.hit ? earlyRestart.error | tags(wayId).error
       val data = fetchStage.read.banksValue.map(bank => stage(bank.data)).read(bankId)
       val word = if(cpuDataWidth == memDataWidth || !twoCycleRamInnerMux) data else data.subdivideIn(cpuDataWidth bits).read(io.cpu.decode.pc(bankWordToCpuWordRange))
       if(p.bypassGen) when(stage(io.cpu.fetch.dataBypassValid)){
@@ -479,6 +623,7 @@ class InstructionCache(p : InstructionCacheConfig, mmuParameter : MemoryTranslat
     }
 
     io.cpu.decode.cacheMiss := !hit.valid
+    if(wayPrediction) io.cpu.decode.wayMiss := stage(fetchStage.hit.wayMiss)
     io.cpu.decode.error := hit.error || (!mmuRsp.isPaging && (mmuRsp.exception || !mmuRsp.allowExecute))
     io.cpu.decode.mmuRefilling := mmuRsp.refilling
     io.cpu.decode.mmuException := !mmuRsp.refilling && mmuRsp.isPaging && (mmuRsp.exception || !mmuRsp.allowExecute)
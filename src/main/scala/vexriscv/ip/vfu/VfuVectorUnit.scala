@@ -0,0 +1,204 @@
+package vexriscv.ip.vfu
+
+import spinal.core._
+import spinal.lib._
+import spinal.lib.fsm._
+import vexriscv.plugin.{VfuBus, VfuParameter}
+
+//Zve32x subset (LMUL = 1, unmasked), executing the instructions in order, out of the integer pipeline.
+//The arithmetic instructions process a whole register per instruction, the loads and stores do one data cache access per
+//element. Instructions with a scalar result answer on the rsp channel, the other ones pulse the completion. A faulting
+//element access end the load or store without register file write and report the fault with the completion.
+case class VfuVectorUnit(p : VfuParameter) extends Component{
+  import p._
+  val io = new Bundle {
+    val port = slave(VfuBus(p))
+  }
+
+  val rf = Mem(Bits(vlen bits), 32)
+  val rfWrite = Flow(new Bundle {
+    val address = UInt(5 bits)
+    val data = Bits(vlen bits)
+    val mask = Bits(vlenBytes bits)
+  })
+  rfWrite.valid := False
+  rfWrite.payload.assignDontCare()
+  rf.write(rfWrite.address, rfWrite.data, rfWrite.valid, rfWrite.mask)
+
+  //The head of the queue stay in place until the instruction is done, which allow to read the register file continuously
+  val cmd = io.port.cmd.queue(queueDepth)
+  cmd.ready := False
+
+  val instruction = cmd.instruction
+  val vd = instruction(11 downto 7).asUInt
+  val vs1 = instruction(19 downto 15).asUInt
+  val vs2 = instruction(24 downto 20).asUInt
+  val funct3 = instruction(14 downto 12)
+  val funct6 = instruction(31 downto 26)
+  val isLoad = instruction(6 downto 0) === B"0000111"
+  val isStore = instruction(6 downto 0) === B"0100111"
+  val isOpm = funct3 === B"010" || funct3 === B"110"
+  val isVector = funct3 === B"000" || funct3 === B"010"
+  val isReduction = funct3 === B"010" && funct6 === B"000000"
+  val isMoveToScalar = funct3 === B"010" && funct6 === B"010000"
+  val isMoveFromScalar = funct3 === B"110" && funct6 === B"010000"
+  val scalar = (funct3 === B"011") ? S(instruction(19 downto 15)).resize(32).asBits | cmd.inputs(0)
+
+  val vs1Data = rf.readSync(vs1)
+  val vs2Data = rf.readSync(vs2)
+  val vdData = rf.readSync(vd)
+
+  def byteMask(count : UInt, eew : UInt) = Vec((0 until vlenBytes).map(b => (U(b, log2Up(vlenBytes) bits) >> eew) < count)).asBits
+  def element(value : Bits, sewBits : Int, i : Int) = value(i*sewBits, sewBits bits).asUInt
+
+  val arithmetic = new Area{
+    def lanes(sewBits : Int) : Bits = {
+      val splat = Vec.fill(vlen/sewBits)(scalar(sewBits-1 downto 0)).asBits
+      val operand = isVector ? vs1Data | splat
+      Vec((0 until vlen/sewBits).map{i =>
+        val x = element(vs2Data, sewBits, i)
+        val y = element(operand, sewBits, i)
+        val product = (x * y).resize(sewBits)
+        (isOpm ## funct6).mux(
+          B"0000010" -> (x - y),
+          B"0001001" -> (x & y),
+          B"0001010" -> (x | y),
+          B"0001011" -> (x ^ y),
+          B"0010111" -> y,
+          B"1100101" -> product,
+          B"1101101" -> (product + element(vdData, sewBits, i)),
+          default    -> (x + y)
+        )
+      }).asBits
+    }
+
+    def reduce(sewBits : Int) : Bits = {
+      val terms = (0 until vlen/sewBits).map(i => (U(i) < cmd.vl) ? element(vs2Data, sewBits, i) | U(0, sewBits bits))
+      (terms.reduceBalancedTree(_ + _) + element(vs1Data, sewBits, 0)).asBits.resize(vlen)
+    }
+
+    val result = cmd.sew.mux(0 -> lanes(8), 1 -> lanes(16), default -> lanes(32))
+    val reduction = cmd.sew.mux(0 -> reduce(8), 1 -> reduce(16), default -> reduce(32))
+    val toScalar = cmd.sew.mux(
+      0 -> S(vs2Data(7 downto 0)).resize(32).asBits,
+      1 -> S(vs2Data(15 downto 0)).resize(32).asBits,
+      default -> vs2Data(31 downto 0)
+    )
+    val elements = byteMask(cmd.vl, cmd.sew)
+    val first = byteMask((cmd.vl =/= 0).asUInt.resize(vlWidth), cmd.sew)
+  }
+
+  val memory = new Area{
+    val eew = funct3.mux(B"000" -> U(0, 2 bits), B"101" -> U(1, 2 bits), default -> U(2, 2 bits))
+    val strided = instruction(27 downto 26) === B"10"
+    val stride = strided ? cmd.inputs(1).asUInt | (U(1, 32 bits) |<< eew)
+    val index = Reg(UInt(vlWidth bits))
+    val address = Reg(UInt(32 bits))
+    val buffer = Reg(Bits(vlen bits))
+    val done = index === cmd.vl || index === (U(vlenBytes, vlWidth bits) >> eew)
+
+    val byteOffset = (index << eew).resize(log2Up(vlenBytes))
+    val window = (buffer >> (byteOffset << 3)).resize(32)
+    val storeData = eew.mux(
+      0 -> window(7 downto 0) #* 4,
+      1 -> window(15 downto 0) #* 2,
+      default -> window
+    )
+    val loadData = (io.port.mem.rsp.data.resize(vlen) << (byteOffset << 3)).resize(vlen)
+    val loadMask = (eew.mux(0 -> B"0001", 1 -> B"0011", default -> B"1111").resize(vlenBytes) << byteOffset).resize(vlenBytes)
+
+    io.port.mem.cmd.valid := False
+    io.port.mem.cmd.address := address
+    io.port.mem.cmd.size := eew
+    io.port.mem.cmd.write := isStore
+    io.port.mem.cmd.data := storeData
+    io.port.mem.cmd.writeMask.assignDontCare()
+  }
+
+  io.port.rsp.valid := False
+  io.port.rsp.output := arithmetic.toScalar
+  io.port.completion.valid := False
+  io.port.completion.fault := False
+  io.port.completion.code.assignDontCare()
+  io.port.completion.address := memory.address
+
+  val fsm = new StateMachine{
+    val idle = new State with EntryPoint
+    val execute, memoryCmd, memoryRsp = new State
+
+    idle.whenIsActive{
+      when(cmd.valid){
+        goto(execute)
+      }
+    }
+
+    execute.whenIsActive{
+      when(isLoad || isStore){
+        memory.index := 0
+        memory.address := cmd.inputs(0).asUInt
+        memory.buffer := vdData
+        goto(memoryCmd)
+      } elsewhen(isMoveToScalar){
+        io.port.rsp.valid := True
+        when(io.port.rsp.ready){
+          cmd.ready := True
+          goto(idle)
+        }
+      } otherwise {
+        rfWrite.valid := True
+        rfWrite.address := vd
+        rfWrite.data := arithmetic.result
+        rfWrite.mask := arithmetic.elements
+        when(isReduction){
+          rfWrite.data := arithmetic.reduction
+          rfWrite.mask := arithmetic.first
+        }
+        when(isMoveFromScalar){
+          rfWrite.data := scalar.resized
+          rfWrite.mask := arithmetic.first
+        }
+        io.port.completion.valid := True
+        cmd.ready := True
+        goto(idle)
+      }
+    }
+
+    memoryCmd.whenIsActive{
+      when(memory.done){
+        rfWrite.valid := isLoad
+        rfWrite.address := vd
+        rfWrite.data := memory.buffer
+        rfWrite.mask := byteMask(memory.index, memory.eew)
+        io.port.completion.valid := True
+        cmd.ready := True
+        goto(idle)
+      } otherwise {
+        io.port.mem.cmd.valid := True
+        when(io.port.mem.cmd.ready){
+          goto(memoryRsp)
+        }
+      }
+    }
+
+    memoryRsp.whenIsActive{
+      when(io.port.mem.rsp.valid){
+        goto(memoryCmd)
+        when(io.port.mem.rsp.fault){
+          io.port.completion.valid := True
+          io.port.completion.fault := True
+          io.port.completion.code := io.port.mem.rsp.code
+          cmd.ready := True
+          goto(idle)
+        } elsewhen(!io.port.mem.rsp.redo){
+          when(isLoad){
+            for(i <- 0 until vlenBytes) when(memory.loadMask(i)){
+              memory.buffer(i*8, 8 bits) := memory.loadData(i*8, 8 bits)
+            }
+          }
+          memory.index := memory.index + 1
+          memory.address := memory.address + memory.stride
+        }
+      }
+    }
+  }
+}
@@ -37,6 +37,10 @@ object CsrAccess {
 
 
 case class ExceptionPortInfo(port : Flow[ExceptionCause],stage : Stage, priority : Int, codeWidth : Int)
+case class CsrTrapTrace() extends Bundle{
+  val interrupt = Bool()
+  val code = UInt(5 bits)
+}
 case class CsrPluginConfig(
                             catchIllegalAccess  : Boolean,
                             var mvendorid       : BigInt,
@@ -479,6 +483,12 @@ class CsrPlugin(val config: CsrPluginConfig) extends Plugin[VexRiscv] with Excep
   var stoptime : Bool = null
   var xretAwayFromMachine : Bool = null
 
+  var trapTrace : Flow[CsrTrapTrace] = null
+  def getTrapTrace() : Flow[CsrTrapTrace] = {
+    if(trapTrace == null) trapTrace = Flow(CsrTrapTrace())
+    trapTrace
+  }
+
   var debugBus : DebugHartBus = null
   var debugMode : Bool = null
   var injectionPort : Stream[Bits] = null
@@ -1385,6 +1395,12 @@ class CsrPlugin(val config: CsrPluginConfig) extends Plugin[VexRiscv] with Excep
         is(3){ xtvec := machineCsr.mtvec }
       }
 
+      if(trapTrace != null){
+        trapTrace.valid := hadException || interruptJump
+        trapTrace.interrupt := !hadException
+        trapTrace.code := trapCause.resized
+      }
+
       val trapEnterDebug = False
       if(withPrivilegedDebug) trapEnterDebug setWhen(debug.doHalt || trapCauseEbreakDebug || !hadException && debug.doHalt || !debug.running)
       when(hadException || interruptJump){
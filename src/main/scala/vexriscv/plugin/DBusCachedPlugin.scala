@@ -67,11 +67,16 @@ class DBusCachedPlugin(val config : DataCacheConfig,
   var redoBranch : Flow[UInt] = null
   var writesPending : Bool = null
 
+  //Cache stages, with a split memory stage the management stage is the memory data one, followed by the write back
+  def mmuAndBufferStage = if(pipeline.writeBack != null) pipeline.memory else pipeline.execute
+  def managementStage = pipeline.stageAfter(mmuAndBufferStage)
+
   @dontName var dBusAccess : DBusAccess = null
+  val dBusAccesses = ArrayBuffer[DBusAccess]()
   override def newDBusAccess(): DBusAccess = {
-    assert(dBusAccess == null)
-    dBusAccess = DBusAccess()
-    dBusAccess
+    val access = DBusAccess()
+    dBusAccesses += access
+    access
   }
 
   override def getVexRiscvRegressionArgs(): Seq[String] = {
@@ -170,6 +175,8 @@ class DBusCachedPlugin(val config : DataCacheConfig,
   object MEMORY_FENCE extends Stageable(Bool)
   object MEMORY_FENCE_WR extends Stageable(Bool)
   object MEMORY_FORCE_CONSTISTENCY extends Stageable(Bool)
+  object MEMORY_CBO extends Stageable(Bool)
+  object MEMORY_PREFETCH extends Stageable(Bool)
   object IS_DBUS_SHARING extends Stageable(Bool())
   object MEMORY_VIRTUAL_ADDRESS extends Stageable(UInt(32 bits))
   object MEMORY_STORE_DATA_RF extends Stageable(Bits(32 bits))
@@ -266,6 +273,20 @@ class DBusCachedPlugin(val config : DataCacheConfig,
       }
     }
 
+    if(withCacheBlockOps){
+      //Decoded as stores without data, the prefetch hints are ORI encodings and are detected in the decode stage
+      val cboActions = storeActions.filter(e => e._1 != SRC2_CTRL && e._1 != RS2_USE) ++ Seq(
+        SRC_ADD_ZERO -> True,
+        MEMORY_CBO -> True
+      )
+      decoderService.addDefault(MEMORY_CBO, False)
+      for(i <- List(CBO_INVAL, CBO_CLEAN, CBO_FLUSH, CBO_ZERO)){
+        decoderService.add(i, cboActions)
+        if(withLrSc) decoderService.add(i, List(MEMORY_LRSC -> False))
+        if(withAmo)  decoderService.add(i, List(MEMORY_AMO -> False))
+      }
+    }
+
     def MANAGEMENT  = M"-------00000-----101-----0001111"
 
     decoderService.addDefault(MEMORY_MANAGMENT, False)
@@ -286,10 +307,10 @@ class DBusCachedPlugin(val config : DataCacheConfig,
     }
 
     mmuBus = pipeline.service(classOf[MemoryTranslator]).newTranslationPort(MemoryTranslatorPort.PRIORITY_DATA ,memoryTranslatorPortConfig)
-    redoBranch = pipeline.service(classOf[JumpService]).createJumpInterface(if(pipeline.writeBack != null) pipeline.writeBack else pipeline.memory)
+    redoBranch = pipeline.service(classOf[JumpService]).createJumpInterface(managementStage)
 
     if(catchSomething)
-      exceptionBus = pipeline.service(classOf[ExceptionService]).newExceptionPort(if(pipeline.writeBack == null) pipeline.memory else pipeline.writeBack)
+      exceptionBus = pipeline.service(classOf[ExceptionService]).newExceptionPort(managementStage)
 
     if(pipeline.serviceExist(classOf[PrivilegeService]))
       privilegeService = pipeline.service(classOf[PrivilegeService])
@@ -355,6 +376,23 @@ class DBusCachedPlugin(val config : DataCacheConfig,
       }
 
 
+      //Zicbop prefetch.r/w are ORI with rd = x0, turn them into non binding loads. prefetch.i stay a nop
+      //As rd = x0, the S immediate is the prefetch offset, which give the address through the ALU adder as the loads
+      val prefetch = withCacheBlockOps generate new Area {
+        val hit = input(INSTRUCTION) === Riscv.PREFETCH_R || input(INSTRUCTION) === Riscv.PREFETCH_W
+        insert(MEMORY_PREFETCH) := hit
+        when(hit) {
+          input(MEMORY_ENABLE) := True
+          input(MEMORY_WR) := False
+          input(HAS_SIDE_EFFECT) := True
+          input(SRC2_CTRL) := Src2CtrlEnum.IMS
+          input(SRC_USE_SUB_LESS) := False
+          input(IntAluPlugin.ALU_CTRL) := IntAluPlugin.AluCtrlEnum.ADD_SUB
+          if(withLrSc) input(MEMORY_LRSC) := False
+          if(withAmo)  input(MEMORY_AMO) := False
+        }
+      }
+
       //Manage write to read hit ordering (ensure invalidation timings)
       val fence = new Area {
         insert(MEMORY_FORCE_CONSTISTENCY) := False
@@ -408,7 +446,19 @@ class DBusCachedPlugin(val config : DataCacheConfig,
       }
 
 
-      when(cache.io.cpu.execute.refilling && arbitration.isValid){
+      val blockOps = withCacheBlockOps generate new Area {
+        val isPrefetch = input(MEMORY_PREFETCH)
+        cache.io.cpu.execute.args.isCbo := input(MEMORY_CBO)
+        cache.io.cpu.execute.args.cboCtrl.invalidate := !input(INSTRUCTION)(20) && !input(INSTRUCTION)(22)
+        cache.io.cpu.execute.args.cboCtrl.zero := input(INSTRUCTION)(22)
+        cache.io.cpu.execute.args.isPrefetch := isPrefetch
+        when(input(MEMORY_CBO) || isPrefetch){
+          cache.io.cpu.execute.args.size := 0
+        }
+      }
+
+      //With refills running in the background, only the memory accesses wait on them
+      when(cache.io.cpu.execute.refilling && arbitration.isValid && (if(config.withBackgroundRefill) input(MEMORY_ENABLE) else True)){
         arbitration.haltByOther := True
       }
 
@@ -443,6 +493,7 @@ class DBusCachedPlugin(val config : DataCacheConfig,
         }
         for((port, sel) <- (tightlyCoupledPorts, input(MEMORY_TIGHTLY).asBools).zipped){
           port.bus.enable       := arbitration.isValid && input(MEMORY_ENABLE) && sel && !arbitration.isStuck
+          if(withCacheBlockOps) port.bus.enable clearWhen(input(MEMORY_CBO) || input(MEMORY_PREFETCH))
 
           port.bus.address      := Delay(input(SRC_ADD), tightlyCoupledAddressStage.toInt).asUInt.resized
           port.bus.write_enable := input(MEMORY_WR)
@@ -456,7 +507,6 @@ class DBusCachedPlugin(val config : DataCacheConfig,
       }
     }
 
-    val mmuAndBufferStage = if(writeBack != null) memory else execute
     mmuAndBufferStage plug new Area {
       import mmuAndBufferStage._
 
@@ -481,7 +531,6 @@ class DBusCachedPlugin(val config : DataCacheConfig,
         KeepAttribute(insert(MEMORY_TIGHTLY_DATA))      }
     }
 
-    val managementStage = stages.last
     val mgs = managementStage plug new Area{
       import managementStage._
       cache.io.cpu.writeBack.isValid := arbitration.isValid && input(MEMORY_ENABLE)
@@ -595,7 +644,24 @@ class DBusCachedPlugin(val config : DataCacheConfig,
       }
     }
 
-    //Share access to the dBus (used by self refilled MMU)
+    //Arbitrate the dBus users, one access at the time
+    if(dBusAccesses.size == 1) dBusAccess = dBusAccesses.head
+    if(dBusAccesses.size > 1) dBusAccess = (pipeline plug new Area{
+      val port = DBusAccess()
+      val arbiter = StreamArbiterFactory.lowerFirst.noLock.build(DBusAccessCmd(), dBusAccesses.size)
+      (arbiter.io.inputs, dBusAccesses).zipped.foreach(_ << _.cmd)
+
+      val busy = RegInit(False) setWhen(port.cmd.fire) clearWhen(port.rsp.valid)
+      val owner = RegNextWhen(arbiter.io.chosenOH, port.cmd.fire)
+      port.cmd << arbiter.io.output.haltWhen(busy)
+      for((access, id) <- dBusAccesses.zipWithIndex){
+        access.rsp.valid := port.rsp.valid && owner(id)
+        access.rsp.payload := port.rsp.payload
+      }
+    }).port
+
+    //Share access to the dBus (used by self refilled MMU and the vector unit), on physical addresses already translated and
+    //checked by the requesters
     if(dBusAccess != null) pipeline plug new Area{
       dBusAccess.cmd.ready := False
       val forceDatapath = False
@@ -607,12 +673,17 @@ class DBusCachedPlugin(val config : DataCacheConfig,
             cache.io.cpu.execute.isValid := True
             dBusAccess.cmd.ready := !execute.arbitration.isStuck
           }
-          cache.io.cpu.execute.args.wr := False                         //dBusAccess.cmd.write
-//          execute.insert(MEMORY_STORE_DATA_RF) := dBusAccess.cmd.data //Not implemented
+          cache.io.cpu.execute.args.wr := dBusAccess.cmd.write
+          execute.insert(MEMORY_STORE_DATA_RF) := dBusAccess.cmd.data //Already replicated by the requester for sub word writes
           cache.io.cpu.execute.args.size := dBusAccess.cmd.size.resized
           if(withLrSc) execute.input(MEMORY_LRSC) := False
           if(withAmo)  execute.input(MEMORY_AMO) := False
+          if(withCacheBlockOps) {
+            execute.input(MEMORY_CBO) := False
+            execute.input(MEMORY_PREFETCH) := False
+          }
           cache.io.cpu.execute.address := dBusAccess.cmd.address  //Will only be 12 muxes
+          if(twoStageMmu) mmuBus.cmd(0).virtualAddress := dBusAccess.cmd.address
           forceDatapath := True
         }
       }
@@ -622,7 +693,7 @@ class DBusCachedPlugin(val config : DataCacheConfig,
 
       if(mmuAndBufferStage != execute) (cache.io.cpu.memory.isValid setWhen(mmuAndBufferStage.input(IS_DBUS_SHARING)))
       cache.io.cpu.writeBack.isValid setWhen(managementStage.input(IS_DBUS_SHARING))
-      dBusAccess.rsp.valid := managementStage.input(IS_DBUS_SHARING) && !cache.io.cpu.writeBack.isWrite && (cache.io.cpu.redo || !cache.io.cpu.writeBack.haltIt)
+      dBusAccess.rsp.valid := managementStage.input(IS_DBUS_SHARING) && (cache.io.cpu.redo || !cache.io.cpu.writeBack.haltIt)
       dBusAccess.rsp.data := mgs.rspRf
       dBusAccess.rsp.error := cache.io.cpu.writeBack.unalignedAccess || cache.io.cpu.writeBack.accessError
       dBusAccess.rsp.redo := cache.io.cpu.redo
@@ -639,7 +710,7 @@ class DBusCachedPlugin(val config : DataCacheConfig,
       }
     }
 
-    when(stages.last.arbitration.haltByOther){
+    when(stages.dropWhile(_ != managementStage).map(_.arbitration.haltByOther).orR){
       cache.io.cpu.writeBack.isValid := False
     }
 
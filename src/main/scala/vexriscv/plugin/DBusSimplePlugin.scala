@@ -309,10 +309,11 @@ class DBusSimplePlugin(catchAddressMisaligned : Boolean = false,
   val catchSomething = catchAccessFault || catchAddressMisaligned || memoryTranslatorPortConfig != null
 
   @dontName var dBusAccess : DBusAccess = null
+  val dBusAccesses = ArrayBuffer[DBusAccess]()
   override def newDBusAccess(): DBusAccess = {
-    assert(dBusAccess == null)
-    dBusAccess = DBusAccess()
-    dBusAccess
+    val access = DBusAccess()
+    dBusAccesses += access
+    access
   }
 
   override def setup(pipeline: VexRiscv): Unit = {
@@ -378,7 +379,7 @@ class DBusSimplePlugin(catchAddressMisaligned : Boolean = false,
 
     decoderService.add(FENCE, Nil)
 
-    rspStage = if(stages.last == execute) execute else (if(emitCmdInMemoryStage) writeBack else memory)
+    rspStage = if(stages.last == execute) execute else (if(emitCmdInMemoryStage) stageAfter(memory) else memory)
     if(catchSomething) {
       val exceptionService = pipeline.service(classOf[ExceptionService])
       memoryExceptionPort = exceptionService.newExceptionPort(rspStage)
@@ -579,7 +580,24 @@ class DBusSimplePlugin(catchAddressMisaligned : Boolean = false,
       insert(FORMAL_MEM_RDATA) := input(MEMORY_READ_DATA)
     }
 
-    //Share access to the dBus (used by self refilled MMU)
+    //Arbitrate the dBus users, one access at the time
+    if(dBusAccesses.size == 1) dBusAccess = dBusAccesses.head
+    if(dBusAccesses.size > 1) dBusAccess = (pipeline plug new Area{
+      val port = DBusAccess()
+      val arbiter = StreamArbiterFactory.lowerFirst.noLock.build(DBusAccessCmd(), dBusAccesses.size)
+      (arbiter.io.inputs, dBusAccesses).zipped.foreach(_ << _.cmd)
+
+      val busy = RegInit(False) setWhen(port.cmd.fire) clearWhen(port.rsp.valid)
+      val owner = RegNextWhen(arbiter.io.chosenOH, port.cmd.fire)
+      val rspOwner = port.cmd.fire ? arbiter.io.chosenOH | owner //Writes respond on the cmd cycle
+      port.cmd << arbiter.io.output.haltWhen(busy)
+      for((access, id) <- dBusAccesses.zipWithIndex){
+        access.rsp.valid := port.rsp.valid && rspOwner(id)
+        access.rsp.payload := port.rsp.payload
+      }
+    }).port
+
+    //Share access to the dBus (used by self refilled MMU and the debug memory access), writes get their response when accepted
     val dBusSharing = (dBusAccess != null) generate new Area{
       val state = Reg(UInt(2 bits)) init(0)
       dBusAccess.cmd.ready := False
@@ -607,6 +625,7 @@ class DBusSimplePlugin(catchAddressMisaligned : Boolean = false,
           when(dBus.cmd.ready){
             state := (dBusAccess.cmd.write ? U(0) | U(2))
             dBusAccess.cmd.ready := True
+            dBusAccess.rsp.valid := dBusAccess.cmd.write
           }
         }
         is(2){
@@ -190,10 +190,15 @@ case class DebugExtensionIo() extends Bundle with IMasterSlave{
   }
 }
 
-class DebugPlugin(var debugClockDomain : ClockDomain, hardwareBreakpointCount : Int = 0, BreakpointReadback : Boolean = false) extends Plugin[VexRiscv] {
+//withMemoryAccess add an auto incremented memory port on the debug bus, using the CPU data bus (and cache) :
+//- 0x08 : address, write to set it (clear the error flag), read to get it
+//- 0x0C : data, each read/write does a 32 bits memory access at the address, then increment it by 4
+//Memory errors are reported as a sticky flag in the bit 5 of the status register (0x00). Addresses aren't translated by the MMU.
+class DebugPlugin(var debugClockDomain : ClockDomain, hardwareBreakpointCount : Int = 0, BreakpointReadback : Boolean = false, withMemoryAccess : Boolean = false) extends Plugin[VexRiscv] {
 
   var io : DebugExtensionIo = null
   var injectionPort : Stream[Bits] = null
+  var dBusAccess : DBusAccess = null
 
 
   object IS_EBREAK extends Stageable(Bool)
@@ -210,6 +215,7 @@ class DebugPlugin(var debugClockDomain : ClockDomain, hardwareBreakpointCount :
     decoderService.add(EBREAK,List(IS_EBREAK -> True))
 
     injectionPort = pipeline.service(classOf[IBusFetcher]).getInjectionPort().setCompositeName(this, "injectionPort")
+    if(withMemoryAccess) dBusAccess = pipeline.service(classOf[DBusAccessService]).newDBusAccess()
 
     if(pipeline.serviceExist(classOf[ReportService])){
       val report = pipeline.service(classOf[ReportService])
@@ -273,6 +279,41 @@ class DebugPlugin(var debugClockDomain : ClockDomain, hardwareBreakpointCount :
       }
 
 
+      val memory = withMemoryAccess generate new Area{
+        val address = Reg(UInt(32 bits))
+        val data = Reg(Bits(32 bits))
+        val error = RegInit(False)
+        val pending = RegInit(False)
+        val done = RegInit(False)
+
+        dBusAccess.cmd.valid := False
+        dBusAccess.cmd.write := io.bus.cmd.wr
+        dBusAccess.cmd.address := address
+        dBusAccess.cmd.data := io.bus.cmd.data
+        dBusAccess.cmd.size := 2
+        dBusAccess.cmd.writeMask := 0xF
+
+        when(dBusAccess.cmd.fire){
+          pending := True
+        }
+        when(dBusAccess.rsp.valid){
+          pending := False
+          when(!dBusAccess.rsp.redo){
+            done := True
+            data := dBusAccess.rsp.data
+            error setWhen(dBusAccess.rsp.error)
+          }
+        }
+
+        when(RegNext(io.bus.cmd.address(7 downto 2)) === 0){ //Status register only, the breakpoints readback also have the bit 2 cleared
+          io.bus.rsp.data(5) := error
+        }
+        switch(RegNext(io.bus.cmd.address(7 downto 2))) {
+          is(0x2) { io.bus.rsp.data := address.asBits }
+          is(0x3) { io.bus.rsp.data := data }
+        }
+      }
+
       injectionPort.valid := False
       injectionPort.payload := io.bus.cmd.data
 
@@ -294,6 +335,20 @@ class DebugPlugin(var debugClockDomain : ClockDomain, hardwareBreakpointCount :
               io.bus.cmd.ready := injectionPort.ready
             }
           }
+          if(withMemoryAccess) is(0x2) {
+            when(io.bus.cmd.wr) {
+              memory.address := io.bus.cmd.data.asUInt
+              memory.error := False
+            }
+          }
+          if(withMemoryAccess) is(0x3) {
+            dBusAccess.cmd.valid := !memory.pending && !memory.done
+            io.bus.cmd.ready := memory.done
+            when(memory.done) {
+              memory.done := False
+              memory.address := memory.address + 4
+            }
+          }
           for(i <- 0 until hardwareBreakpointCount){
             is(0x10 + i){
               when(io.bus.cmd.wr){
@@ -25,6 +25,7 @@ class EmbeddedRiscvJtag(var p : DebugTransportModuleParameter,
 
   var jtag : Jtag = null
   var jtagInstruction : JtagTapInstructionCtrl = null
+  var dmi : DebugBus = null
   var ndmreset : Bool = null
 
 
@@ -32,7 +33,8 @@ class EmbeddedRiscvJtag(var p : DebugTransportModuleParameter,
 
   override def setup(pipeline: VexRiscv): Unit = {
     jtag = withTap generate slave(Jtag()).setName("jtag")
-    jtagInstruction = !withTap generate slave(JtagTapInstructionCtrl()).setName("jtagInstruction")
+    jtagInstruction = !withTap && withTunneling generate slave(JtagTapInstructionCtrl()).setName("jtagInstruction")
+    dmi = !withTap && !withTunneling generate slave(DebugBus(7)).setName("dmi")
     ndmreset = out(Bool()).setName("ndmreset")
     assert(debugCd != null, "You need to set the debugCd of the VexRiscv EmbeddedRiscvJtag.")
   }
@@ -81,6 +83,10 @@ class EmbeddedRiscvJtag(var p : DebugTransportModuleParameter,
       logic.io.instruction <> jtagInstruction
       dm.io.ctrl <> logic.io.bus
     }
+    //Without TAP nor tunneling, the Debug Module Interface is directly exposed (ex : in process simulation transactor)
+    val dmiExternal = if (!withTap && !withTunneling) new Area {
+      dm.io.ctrl <> dmi
+    }
 
     val privBus = pipeline.service(classOf[CsrPlugin]).debugBus.setAsDirectionLess()
     privBus <> dm.io.harts(0)
@@ -52,6 +52,8 @@ class FpuPlugin(externalFpu : Boolean = false,
 
   override def setup(pipeline: VexRiscv): Unit = {
     import pipeline.config._
+    //The stores are bypassed and the write back halted while the data cache management stage is memoryData, which can't be stuck by the others
+    assert(!withMemoryDataStage, "FpuPlugin isn't compatible with withMemoryDataStage")
 
     type ENC = (Stageable[_ <: BaseType],Any)
 
@@ -96,9 +96,14 @@ class HazardSimplePlugin(bypassExecute : Boolean = false,
         }
       }
 
-      if (withWriteBackStage) trackHazardWithStage(writeBack, bypassWriteBack, null)
-      if (withMemoryStage) trackHazardWithStage(memory, bypassMemory, if (stages.last == memory) null else BYPASSABLE_MEMORY_STAGE)
-      if (readStage != execute) trackHazardWithStage(execute, bypassExecute, if (stages.last == execute) null else BYPASSABLE_EXECUTE_STAGE)
+      //From the oldest to the youngest stage, as the last bypass assignment win.
+      //Stages between the memory and the last one (memory data) only bypass what was already bypassable in the memory stage
+      for (stage <- stagesFromExecute.reverse if stage != readStage) stage match {
+        case `execute` => trackHazardWithStage(execute, bypassExecute, if (stages.last == execute) null else BYPASSABLE_EXECUTE_STAGE)
+        case `memory` => trackHazardWithStage(memory, bypassMemory, if (stages.last == memory) null else BYPASSABLE_MEMORY_STAGE)
+        case _ if stage == stages.last => trackHazardWithStage(stage, bypassWriteBack, null)
+        case _ => trackHazardWithStage(stage, bypassMemory, BYPASSABLE_MEMORY_STAGE)
+      }
 
 
       if (!pessimisticUseSrc) {
@@ -36,7 +36,8 @@ class IBusCachedPlugin(resetVector : BigInt = 0x80000000l,
                        injectorStage : Boolean = false,
                        withoutInjectorStage : Boolean = false,
                        relaxPredictorAddress : Boolean = true,
-                       predictionBuffer : Boolean = true)  extends IBusFetcherImpl(
+                       predictionBuffer : Boolean = true,
+                       lockCsrId : Int = 0x7D0)  extends IBusFetcherImpl(
   resetVector = resetVector,
   keepPcPlus4 = keepPcPlus4,
   decodePcGen = compressedGen,
@@ -152,6 +153,23 @@ class IBusCachedPlugin(resetVector : BigInt = 0x80000000l,
         rspCounter := rspCounter + 1
       }
 
+      //lockCsrId     : locked ways mask, the way 0 can't be locked
+      //lockCsrId + 1 : scratchpad, bit 0 enable, upper bits the way size aligned base address. Enabling it preload the last way with
+      //                that window and then keep the way locked, which make it behave like an address mapped scratchpad
+      val lock = wayLocking generate new Area{
+        assert(pipeline.serviceExist(classOf[CsrInterface]), "IBusCachedPlugin wayLocking require a CsrPlugin to implement its lock CSRs")
+        val csrService = pipeline.service(classOf[CsrInterface])
+        val ways = Reg(Bits(wayCount bits)) init(0)
+        val scratchpadEnable = RegInit(False)
+        val scratchpadBase = Reg(UInt(32 - log2Up(cacheSize/wayCount) bits))
+        csrService.rw(lockCsrId, 0 -> ways)
+        csrService.rw(lockCsrId + 1, 0 -> scratchpadEnable, log2Up(cacheSize/wayCount) -> scratchpadBase)
+
+        cache.io.lock.ways := ways | (scratchpadEnable ## B(0, wayCount-1 bits))
+        cache.io.lock.preload.valid := RegNext(csrService.isWriting(lockCsrId + 1), False) && scratchpadEnable
+        cache.io.lock.preload.payload := scratchpadBase @@ U(0, log2Up(cacheSize/wayCount) bits)
+      }
+
       val stageOffset = if(relaxedPcCalculation) 1 else 0
       def stages = iBusRsp.stages.drop(stageOffset)
 
@@ -259,6 +277,12 @@ class IBusCachedPlugin(resetVector : BigInt = 0x80000000l,
           redoFetch := True
         }
 
+        if(wayPrediction) when(cacheRsp.isValid && cacheRsp.wayMiss && !issueDetected) {
+          issueDetected \= True
+          redoFetch := True
+          cache.io.cpu.fill.valid := False
+        }
+
         if(catchAccessFault) when(cacheRsp.isValid && cacheRsp.error && !issueDetected) {
           issueDetected \= True
           decodeExceptionPort.valid := iBusRsp.readyForError
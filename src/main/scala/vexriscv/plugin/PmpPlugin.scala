@@ -97,7 +97,8 @@ case class PmpRegister(previous : PmpRegister) extends Area {
 
   // Computed PMP region bounds
   val region = new Area {
-    val valid, locked = Bool
+    val valid = RegInit(False)
+    val locked = Bool
 
     // The calculated start & end addresses can overflow xlen by 4 bit:
     //
@@ -120,7 +121,7 @@ case class PmpRegister(previous : PmpRegister) extends Area {
     // hence requiring xlen + 2 + 2 bit to represent the exclusive end
     // address. This could be optimized by using a saturating add, or making the
     // end address exclusive.
-    val start, end = UInt(36 bits)
+    val start, end = Reg(UInt(36 bits))
   }
 
   when(~state.l) {
@@ -136,42 +137,57 @@ case class PmpRegister(previous : PmpRegister) extends Area {
     }
   }
 
-  // Extend state.addr to 36 bits, to avoid these computations overflowing (as
+  // The region bounds are precomputed from the values the state registers
+  // are about to take, and registered along them. This keeps the address
+  // decoding out of the access check path.
+  val next = new Area {
+    val a = (~state.l) ? csr.a | state.a
+    val addr = (~state.l) ? csr.addr | state.addr
+    val valid = Bool
+    val start, end = UInt(36 bits)
+  }
+
+  // Extend next.addr to 36 bits, to avoid these computations overflowing (as
   // explained above):
-  val extended_addr = (B"00" ## state.addr.asBits).asUInt
+  val extended_addr = (B"00" ## next.addr.asBits).asUInt
   val shifted = extended_addr << 2
   val mask = extended_addr ^ (extended_addr + 1)
   val masked = (extended_addr & ~mask) << 2
 
-  // PMP changes take effect two clock cycles after the initial CSR write (i.e.,
-  // settings propagate from csr -> state -> region).
   region.locked := state.l
-  region.valid := True
+  next.valid := True
 
-  switch(csr.a) {
+  switch(next.a) {
     is(TOR) {
-      if (previous == null) region.start := 0
-      else region.start := previous.region.end
-      region.end := shifted
+      if (previous == null) next.start := 0
+      else next.start := previous.next.end
+      next.end := shifted
     }
     is(NA4) {
-      region.start := shifted
-      region.end := shifted + 4
+      next.start := shifted
+      next.end := shifted + 4
     }
     is(NAPOT) {
-      region.start := masked
-      region.end := masked + ((mask + 1) << 2)
+      next.start := masked
+      next.end := masked + ((mask + 1) << 2)
     }
     default {
-      region.start := 0
-      region.end := shifted
-      region.valid := False
+      next.start := 0
+      next.end := shifted
+      next.valid := False
     }
   }
+
+  region.valid := next.valid
+  region.start := next.start
+  region.end := next.end
 }
 
 
-class PmpPlugin(regions : Int, ioRange : UInt => Bool) extends Plugin[VexRiscv] with MemoryTranslator {
+// With pipelined = true, the translation ports have one cycle of latency : the region bounds are compared in the first
+// translation stage and the permissions resolved in the second one. It requires the IBusCachedPlugin and the DBusCachedPlugin
+// with the memory and write back stages.
+class PmpPlugin(regions : Int, ioRange : UInt => Bool, pipelined : Boolean = false) extends Plugin[VexRiscv] with MemoryTranslator {
 
   // Each pmpcfg# CSR configures four regions.
   assert((regions % 4) == 0)
@@ -180,7 +196,7 @@ class PmpPlugin(regions : Int, ioRange : UInt => Bool) extends Plugin[VexRiscv]
   val portsInfo = ArrayBuffer[ProtectedMemoryTranslatorPort]()
 
   override def newTranslationPort(priority : Int, args : Any): MemoryTranslatorBus = {
-    val port = ProtectedMemoryTranslatorPort(MemoryTranslatorBus(new MemoryTranslatorBusParameter(0, 0)))
+    val port = ProtectedMemoryTranslatorPort(MemoryTranslatorBus(new MemoryTranslatorBusParameter(0, if(pipelined) 1 else 0)))
     portsInfo += port
     port.bus
   }
@@ -237,14 +253,21 @@ class PmpPlugin(regions : Int, ioRange : UInt => Bool) extends Plugin[VexRiscv]
       // Connect memory ports to PMP logic.
       val ports = for ((port, portId) <- portsInfo.zipWithIndex) yield new Area {
 
-        val address = port.bus.cmd(0).virtualAddress
+        val address = port.bus.cmd.last.virtualAddress
         port.bus.rsp.physicalAddress := address
 
-        // Only the first matching PMP region applies.
-        val hits = pmps.map(pmp => pmp.region.valid &
+        def inRegions(address : UInt) = pmps.map(pmp => pmp.region.valid &
           pmp.region.start <= address &
-          pmp.region.end > address &
-          (pmp.region.locked | ~privilegeService.isMachine()))
+          pmp.region.end > address)
+
+        val matches = if (!pipelined) inRegions(address) else {
+          inRegions(port.bus.cmd.head.virtualAddress).map(RegNextWhen(_, !port.bus.cmd.last.isStuck))
+        }
+
+        // Only the first matching PMP region applies.
+        val hits = matches.zip(pmps).map { case (hit, pmp) =>
+          hit & (pmp.region.locked | ~privilegeService.isMachine())
+        }
 
         // M-mode has full access by default, others have none.
         when(CountOne(hits) === 0) {
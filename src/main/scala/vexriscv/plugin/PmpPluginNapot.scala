@@ -95,7 +95,10 @@ class PmpSetter(cutoff : Int) extends Component with Pmp {
 
 case class ProtectedMemoryTranslatorPort(bus : MemoryTranslatorBus)
 
-class PmpPluginNapot(regions : Int, granularity : Int, ioRange : UInt => Bool) extends Plugin[VexRiscv] with MemoryTranslator with Pmp {
+// With pipelined = true, the translation ports have one cycle of latency : the regions are matched in the first translation
+// stage and the permissions resolved in the second one. It requires the IBusCachedPlugin and the DBusCachedPlugin with the
+// memory and write back stages.
+class PmpPluginNapot(regions : Int, granularity : Int, ioRange : UInt => Bool, pipelined : Boolean = false) extends Plugin[VexRiscv] with MemoryTranslator with Pmp {
   assert(regions % 4 == 0 & regions <= 16)
   assert(granularity >= 8)
 
@@ -104,7 +107,7 @@ class PmpPluginNapot(regions : Int, granularity : Int, ioRange : UInt => Bool) e
   val cutoff = log2Up(granularity) - 1
   
   override def newTranslationPort(priority : Int, args : Any): MemoryTranslatorBus = {
-    val port = ProtectedMemoryTranslatorPort(MemoryTranslatorBus(new MemoryTranslatorBusParameter(0, 0)))
+    val port = ProtectedMemoryTranslatorPort(MemoryTranslatorBus(new MemoryTranslatorBusParameter(0, if(pipelined) 1 else 0)))
     priority match {
       case PRIORITY_INSTRUCTION => iPort = port
       case PRIORITY_DATA => dPort = port
@@ -251,19 +254,26 @@ class PmpPluginNapot(regions : Int, granularity : Int, ioRange : UInt => Bool) e
     }
 
     pipeline plug new Area {
-      def getHits(address : UInt) = {
+      def getMatches(address : UInt) = {
         (0 until regions).map(i =>
             ((address & state.mask(U(i, log2Up(regions) bits))) === state.base(U(i, log2Up(regions) bits))) &
-            (state.pmpcfg(i)(lBit) | ~machineMode) & (state.pmpcfg(i)(aBits) === NAPOT)
+            (state.pmpcfg(i)(aBits) === NAPOT)
         )
       }
 
+      def getHits(port : ProtectedMemoryTranslatorPort) = {
+        val matches = if (!pipelined) getMatches(port.bus.cmd.last.virtualAddress(31 downto cutoff)) else {
+          getMatches(port.bus.cmd.head.virtualAddress(31 downto cutoff)).map(RegNextWhen(_, !port.bus.cmd.last.isStuck))
+        }
+        (0 until regions).map(i => matches(i) & (state.pmpcfg(i)(lBit) | ~machineMode))
+      }
+
       def getPermission(hits : IndexedSeq[Bool], bit : Int) = {
         MuxOH(OHMasking.first(hits), state.pmpcfg.map(_(bit)))
       }
 
       val dGuard = new Area {
-        val address = dPort.bus.cmd(0).virtualAddress
+        val address = dPort.bus.cmd.last.virtualAddress
         dPort.bus.rsp.physicalAddress := address
         dPort.bus.rsp.isIoAccess := ioRange(address)
         dPort.bus.rsp.isPaging := False
@@ -272,7 +282,7 @@ class PmpPluginNapot(regions : Int, granularity : Int, ioRange : UInt => Bool) e
         dPort.bus.rsp.allowExecute := False
         dPort.bus.busy := False
 
-        val hits = getHits(address(31 downto cutoff))
+        val hits = getHits(dPort)
 
         when(~hits.orR) {
           dPort.bus.rsp.allowRead := machineMode
@@ -284,7 +294,7 @@ class PmpPluginNapot(regions : Int, granularity : Int, ioRange : UInt => Bool) e
       }
 
       val iGuard = new Area {
-        val address = iPort.bus.cmd(0).virtualAddress
+        val address = iPort.bus.cmd.last.virtualAddress
         iPort.bus.rsp.physicalAddress := address
         iPort.bus.rsp.isIoAccess := ioRange(address)
         iPort.bus.rsp.isPaging := False
@@ -294,7 +304,7 @@ class PmpPluginNapot(regions : Int, granularity : Int, ioRange : UInt => Bool) e
         iPort.bus.rsp.allowWrite := False
         iPort.bus.busy := False
 
-        val hits = getHits(address(31 downto cutoff))
+        val hits = getHits(iPort)
 
         when(~hits.orR) {
           iPort.bus.rsp.allowExecute := machineMode
@@ -10,7 +10,7 @@ class SingleInstructionLimiterPlugin() extends Plugin[VexRiscv] {
     import pipeline._
     import pipeline.config._
     val fetcher = pipeline.service(classOf[IBusFetcher])
-    when(fetcher.incoming() || List(decode,execute,memory,writeBack).map(_.arbitration.isValid).orR) {
+    when(fetcher.incoming() || stages.map(_.arbitration.isValid).orR) {
       fetcher.haltIt()
     }
   }
@@ -0,0 +1,185 @@
+package vexriscv.plugin
+
+import spinal.core._
+import spinal.lib._
+import vexriscv._
+
+//Words emitted by the TracePlugin (E-Trace like branch history, the decoder follows the program binary)
+//- Branch bitmap  : [0] = 1, [5:1] branch count, [31:6] taken flags, first branch in bit 6
+//- Address header : [0] = 0, [2:1] kind, [4:3] privilege, [5] interrupt, [10:6] trap cause,
+//                   [31:11] instructions retired since the previous address header,
+//                   followed by a word with the PC of the next retired instruction
+//Address headers are only emitted on what the binary can't tell : start, indirect jumps, traps, xret and counter overflow
+object TracePacket{
+  val SYNC = 0
+  val JUMP = 1
+  val TRAP = 2
+
+  def bitmapCapacity = 26
+  def countWidth = 21
+}
+
+case class TraceEvent() extends Bundle{
+  val bitmapValid = Bool()
+  val bitmapCount = UInt(5 bits)
+  val bitmap = Bits(TracePacket.bitmapCapacity bits)
+  val addressValid = Bool()
+  val kind = UInt(2 bits)
+  val privilege = Bits(2 bits)
+  val interrupt = Bool()
+  val cause = UInt(5 bits)
+  val count = UInt(TracePacket.countWidth bits)
+  val address = UInt(32 bits)
+}
+
+//Compressed instruction trace of the retired instructions.
+//If sinkWords is 0, the words are given on the trace stream, else they are written in a ring buffer readable through CSRs :
+//- sinkCsrId     : read the number of words ever written, write the ring buffer read index
+//- sinkCsrId + 1 : read the word at the read index and increment it
+//The decode stage is stalled when the event FIFO can't take the instructions in flight, the trace is lossless.
+class TracePlugin(fifoDepth : Int = 16,
+                  sinkWords : Int = 0,
+                  sinkCsrId : Int = 0x7D8) extends Plugin[VexRiscv]{
+  assert(sinkWords == 0 || isPow2(sinkWords))
+
+  var trace : Stream[Bits] = null
+  var trapTrace : Flow[CsrTrapTrace] = null
+
+  override def setup(pipeline: VexRiscv): Unit = {
+    if(sinkWords == 0) trace = master(Stream(Bits(32 bits))).setName("trace")
+    pipeline.plugins.foreach{
+      case csr : CsrPlugin => trapTrace = csr.getTrapTrace()
+      case _ =>
+    }
+  }
+
+  override def build(pipeline: VexRiscv): Unit = {
+    import pipeline._
+    import pipeline.config._
+
+    val privilegeService = pipeline.serviceElse(classOf[PrivilegeService], PrivilegeServiceDefault())
+    val stage = stages.last
+
+    val encoder = stage plug new Area{
+      import stage._
+
+      val events = StreamFifo(TraceEvent(), fifoDepth)
+
+      val previous = new Area{
+        val valid = RegInit(False)
+        val branch, jal, jalr = Reg(Bool())
+        val nextPc = Reg(UInt(32 bits))
+      }
+
+      val trap = new Area{
+        val pending = RegInit(False)
+        val interrupt = Reg(Bool())
+        val cause = Reg(UInt(5 bits))
+      }
+
+      val bitmap = Reg(Bits(TracePacket.bitmapCapacity bits))
+      val bitmapCount = Reg(UInt(5 bits)) init(0)
+      val counter = Reg(UInt(TracePacket.countWidth bits)) init(0)
+
+      val pc = input(PC)
+      val sequential = pc === previous.nextPc
+      val addressNeeded = !previous.valid || trap.pending || previous.jalr || counter.andR || !previous.branch && !previous.jal && !sequential
+      val branchBit = !addressNeeded && previous.branch
+      val bitmapFull = branchBit && bitmapCount === TracePacket.bitmapCapacity - 1
+      val push = addressNeeded || bitmapFull
+
+      //Each instruction pushes at most one event, so letting an instruction leave the decode stage only when the FIFO has
+      //room for it and all the ones in flight avoids stalling the last stage (a DBusCachedPlugin writeBack can't wait)
+      val inFlight = CountOne(stages.drop(stages.indexOf(decode) + 1).map(_.arbitration.isValid))
+      decode.arbitration.haltByOther setWhen(decode.arbitration.isValid && events.io.availability <= inFlight)
+
+      val event = events.io.push.payload
+      events.io.push.valid := arbitration.isFiring && push
+      event.bitmapValid := bitmapCount =/= 0 || branchBit
+      event.bitmapCount := bitmapCount + U(branchBit)
+      event.bitmap := bitmap
+      when(branchBit){
+        event.bitmap(bitmapCount) := !sequential
+      }
+      event.addressValid := addressNeeded
+      event.kind := TracePacket.SYNC
+      when(previous.valid && (previous.jalr || !sequential)) { event.kind := TracePacket.JUMP }
+      when(trap.pending) { event.kind := TracePacket.TRAP }
+      event.privilege := privilegeService.encodeBits()
+      event.interrupt := trap.interrupt
+      event.cause := trap.cause
+      event.count := counter
+      event.address := pc
+
+      when(arbitration.isFiring){
+        previous.valid := True
+        previous.branch := input(BRANCH_CTRL) === BranchCtrlEnum.B
+        previous.jal := input(BRANCH_CTRL) === BranchCtrlEnum.JAL
+        previous.jalr := input(BRANCH_CTRL) === BranchCtrlEnum.JALR
+        previous.nextPc := pc + (if(withRvc) (input(IS_RVC) ? U(2) | U(4)) else U(4))
+        trap.pending := False
+        counter := counter + 1
+        when(branchBit){
+          bitmap(bitmapCount) := !sequential
+          bitmapCount := bitmapCount + 1
+        }
+        when(push){
+          bitmapCount := 0
+        }
+        when(addressNeeded){
+          counter := 1
+        }
+      }
+
+      if(trapTrace != null) when(trapTrace.valid){
+        trap.pending := True
+        trap.interrupt := trapTrace.interrupt
+        trap.cause := trapTrace.code
+      }
+    }
+
+    //Split each event into its bitmap, header and address words
+    val serializer = new Area{
+      val event = encoder.events.io.pop
+      val words = Stream(Bits(32 bits))
+      val phase = Reg(UInt(2 bits)) init(0)
+      val current = (phase === 0) ? (event.bitmapValid ? U(0, 2 bits) | U(1, 2 bits)) | phase
+      val last = current === 2 || current === 0 && !event.addressValid
+
+      words.valid := event.valid
+      words.payload := current.mux(
+        0 -> event.bitmap ## event.bitmapCount ## True,
+        1 -> event.count ## event.cause ## event.interrupt ## event.privilege ## event.kind ## False,
+        default -> event.address.asBits
+      )
+      event.ready := words.ready && last
+      when(words.fire){
+        phase := last ? U(0) | current + 1
+      }
+    }
+
+    if(sinkWords == 0) {
+      trace << serializer.words
+    }
+
+    val sink = sinkWords != 0 generate new Area{
+      val ram = Mem(Bits(32 bits), sinkWords)
+      val written = Reg(UInt(32 bits)) init(0)
+      val readIndex = Reg(UInt(log2Up(sinkWords) bits)) init(0)
+
+      serializer.words.ready := True
+      ram.write(written(readIndex.range), serializer.words.payload, serializer.words.valid)
+      when(serializer.words.valid){
+        written := written + 1
+      }
+
+      val csrService = pipeline.service(classOf[CsrInterface])
+      csrService.r(sinkCsrId, written)
+      csrService.w(sinkCsrId, readIndex)
+      csrService.r(sinkCsrId + 1, ram.readAsync(readIndex))
+      csrService.onRead(sinkCsrId + 1){
+        readIndex := readIndex + 1
+      }
+    }
+  }
+}
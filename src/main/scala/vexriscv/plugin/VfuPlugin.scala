@@ -1,6 +1,7 @@
 package vexriscv.plugin
 
-import vexriscv.{DecoderService, ExceptionCause, ExceptionService, Stage, Stageable, VexRiscv}
+import vexriscv.{DecoderService, ExceptionCause, ExceptionService, InterruptionInhibitor, JumpService, MemoryTranslator, MemoryTranslatorBus, Stage, Stageable, VexRiscv}
+import vexriscv.ip.vfu.VfuVectorUnit
 import spinal.core._
 import spinal.lib._
 import spinal.lib.bus.bmb.WeakConnector
@@ -14,31 +15,75 @@ object VfuPlugin{
 }
 
 
-case class VfuParameter() //Empty for now
+//vlen = 0 keep the bare command/response bus, else the plugin implement a Zve32x subset with an internal VfuVectorUnit
+case class VfuParameter(vlen : Int = 0,
+                        queueDepth : Int = 4){
+  def withVector = vlen != 0
+  def vlenBytes = vlen/8
+  def vlWidth = log2Up(vlenBytes) + 1
+  assert(!withVector || isPow2(vlen) && vlen >= 32)
+}
 
 case class VfuCmd( p : VfuParameter ) extends Bundle{
   val instruction = Bits(32 bits)
   val inputs = Vec(Bits(32 bits), 2)
   val rounding = Bits(VfuPlugin.ROUND_MODE_WIDTH bits)
+  val vl = p.withVector generate UInt(p.vlWidth bits)
+  val sew = p.withVector generate UInt(2 bits)
 }
 
 case class VfuRsp(p : VfuParameter) extends Bundle{
   val output = Bits(32 bits)
 }
 
+//Element access of the unit, on a virtual address. The fault code is the exception code to raise
+case class VfuMemRsp() extends Bundle{
+  val data = Bits(32 bits)
+  val redo = Bool()
+  val fault = Bool()
+  val code = UInt(4 bits)
+}
+
+case class VfuMemBus() extends Bundle with IMasterSlave{
+  val cmd = Stream(DBusAccessCmd())
+  val rsp = Flow(VfuMemRsp())
+
+  override def asMaster(): Unit = {
+    master(cmd)
+    slave(rsp)
+  }
+}
+
+case class VfuCompletion() extends Bundle{
+  val fault = Bool()
+  val code = UInt(4 bits)
+  val address = UInt(32 bits)
+}
+
 case class VfuBus(p : VfuParameter) extends Bundle with IMasterSlave{
   val cmd = Stream(VfuCmd(p))
   val rsp = Stream(VfuRsp(p))
+  val completion = p.withVector generate Flow(VfuCompletion()) //For each instruction done without response
+  val mem = p.withVector generate VfuMemBus()  //Element accesses of the unit, translated and checked by the plugin
 
   def <<(m : VfuBus) : Unit = {
     val s = this
     s.cmd << m.cmd
     m.rsp << s.rsp
+    if(p.withVector) {
+      m.completion := s.completion
+      m.mem.cmd << s.mem.cmd
+      s.mem.rsp := m.mem.rsp
+    }
   }
 
   override def asMaster(): Unit = {
     master(cmd)
     slave(rsp)
+    if(p.withVector) {
+      slave(completion)
+      slave(mem)
+    }
   }
 }
 
@@ -46,10 +91,16 @@ case class VfuBus(p : VfuParameter) extends Bundle with IMasterSlave{
 
 class VfuPlugin(val stageCount : Int,
                 val allowZeroLatency : Boolean,
-                val parameter : VfuParameter) extends Plugin[VexRiscv]{
+                val parameter : VfuParameter,
+                val memoryTranslatorPortConfig : Any = MmuPortConfig(portTlbSize = 4)) extends Plugin[VexRiscv]{
   def p = parameter
   
   var bus : VfuBus = null
+  var dBusAccess : DBusAccess = null
+  var mmuBus : MemoryTranslatorBus = null
+  var redoBranch : Flow[UInt] = null
+  var decodeExceptionPort : Flow[ExceptionCause] = null
+  var trapTrace : Flow[CsrTrapTrace] = null
 
   lazy val forkStage = pipeline.execute
   lazy val joinStage = pipeline.stages(Math.min(pipeline.stages.length - 1, pipeline.indexOf(forkStage) + stageCount))
@@ -57,17 +108,23 @@ class VfuPlugin(val stageCount : Int,
 
   object VFU_ENABLE extends Stageable(Bool())
   object VFU_IN_FLIGHT extends Stageable(Bool())
+  object VFU_MEMORY extends Stageable(Bool())
+  object VFU_SETVL extends Stageable(Bool())
+  object VFU_SETVL_VL extends Stageable(UInt(p.vlWidth bits))
+  object VFU_SETVL_SEW extends Stageable(UInt(3 bits))
+  object VFU_SETVL_VILL extends Stageable(Bool())
 
   override def setup(pipeline: VexRiscv): Unit = {
     import pipeline._
     import pipeline.config._
 
-    bus = master(VfuBus(p))
+    bus = VfuBus(p)
+    if(!p.withVector) master(bus)
 
     val decoderService = pipeline.service(classOf[DecoderService])
     decoderService.addDefault(VFU_ENABLE, False)
 
-    decoderService.add(
+    if(!p.withVector) decoderService.add(
       key = M"-------------------------0001011",
       values = List(
         VFU_ENABLE -> True,
@@ -78,6 +135,54 @@ class VfuPlugin(val stageCount : Int,
         RS2_USE -> True
       )
     )
+
+    if(p.withVector) {
+      import vexriscv.Riscv._
+      decoderService.addDefault(VFU_SETVL, False)
+      decoderService.addDefault(VFU_MEMORY, False)
+
+      val setVl = List[(Stageable[_ <: BaseType],Any)](
+        VFU_SETVL -> True,
+        REGFILE_WRITE_VALID -> True,
+        BYPASSABLE_EXECUTE_STAGE -> True,
+        BYPASSABLE_MEMORY_STAGE -> True,
+        RS1_USE -> True
+      )
+      val vector = List[(Stageable[_ <: BaseType],Any)](
+        VFU_ENABLE -> True
+      )
+      val vectorX = vector :+ (RS1_USE -> True)
+      val vectorStrided = vectorX :+ (RS2_USE -> True)
+      val vectorMemory = vectorX :+ (VFU_MEMORY -> True)
+      val vectorMemoryStrided = vectorStrided :+ (VFU_MEMORY -> True)
+      val vectorToScalar = vector ++ List(
+        REGFILE_WRITE_VALID -> True,
+        BYPASSABLE_EXECUTE_STAGE -> False,
+        BYPASSABLE_MEMORY_STAGE  -> Bool(stageCount <= 1)
+      )
+
+      decoderService.add(List(
+        VSETVLI -> setVl,
+        VSETIVLI -> setVl,
+        VSETVL -> (setVl :+ (RS2_USE -> True))
+      ) ++ List(VADD_VV, VADD_VI, VSUB_VV, VAND_VV, VAND_VI, VOR_VV, VOR_VI, VXOR_VV, VXOR_VI, VMV_V_V, VMV_V_I, VMUL_VV, VMACC_VV, VREDSUM_VS).map(_ -> vector)
+        ++ List(VADD_VX, VSUB_VX, VAND_VX, VOR_VX, VXOR_VX, VMV_V_X, VMUL_VX, VMACC_VX, VMV_S_X).map(_ -> vectorX)
+        ++ List(VLE8, VLE16, VLE32, VSE8, VSE16, VSE32).map(_ -> vectorMemory)
+        ++ List(VLSE8, VLSE16, VLSE32, VSSE8, VSSE16, VSSE32).map(_ -> vectorMemoryStrided)
+        :+ (VMV_X_S -> vectorToScalar)
+      )
+
+      dBusAccess = pipeline.service(classOf[DBusAccessService]).newDBusAccess()
+      if(pipeline.serviceExist(classOf[MemoryTranslator])) {
+        mmuBus = pipeline.service(classOf[MemoryTranslator]).newTranslationPort(MemoryTranslatorPort.PRIORITY_DATA, memoryTranslatorPortConfig)
+      }
+      redoBranch = pipeline.service(classOf[JumpService]).createJumpInterface(forkStage)
+      decodeExceptionPort = pipeline.service(classOf[ExceptionService]).newExceptionPort(decode)
+      pipeline.plugins.foreach{
+        case plugin : CsrPlugin => trapTrace = plugin.getTrapTrace()
+        case _ =>
+      }
+    }
   }
 
   override def build(pipeline: VexRiscv): Unit = {
@@ -91,10 +196,83 @@ class VfuPlugin(val stageCount : Int,
       factory.rw(csrAddress = 0xBC0, bitOffset = 0, that = rounding)
     }
 
+    //vl and vtype live on the pipeline side, vsetvl update them when it leaves the last stage
+    val vector = p.withVector generate (pipeline plug new Area{
+      val vl = Reg(UInt(p.vlWidth bits)) init(0)
+      val sew = Reg(UInt(3 bits)) init(0)
+      val vill = RegInit(True)
+
+      csr.factory.r(0xC20, vl)
+      csr.factory.r(0xC21, 3 -> sew, 31 -> vill)
+      csr.factory.r(0xC22, U(p.vlenBytes, 32 bits))
+    })
+
+    val setVl = p.withVector generate (execute plug new Area{
+      import execute._
+      val instruction = input(INSTRUCTION)
+      val isImmediate = instruction(31 downto 30) === 3
+      val isRegister = instruction(31 downto 30) === 2
+
+      val vtype = CombInit(instruction(30 downto 20))
+      when(isImmediate){ vtype := B"0" ## instruction(29 downto 20) }
+      when(isRegister){ vtype := input(RS2)(10 downto 0) }
+      val sew = vtype(5 downto 3).asUInt
+      val vill = vtype(2 downto 0) =/= 0 || sew > 2 || vtype(10 downto 8) =/= 0 //Only LMUL=1
+      val vlmax = U(p.vlenBytes, p.vlWidth bits) >> sew
+
+      val rs1Zero = instruction(19 downto 15) === 0
+      val rdZero = instruction(11 downto 7) === 0
+      val avl = isImmediate ? instruction(19 downto 15).asUInt.resize(32) | input(RS1).asUInt
+      val vl = CombInit((avl < vlmax.resize(32)) ? avl.resize(p.vlWidth) | vlmax)
+      when(!isImmediate && rs1Zero){
+        vl := (rdZero ? vector.vl | vlmax)
+      }
+      when(vill){
+        vl := 0
+      }
+
+      insert(VFU_SETVL_VL) := vl
+      insert(VFU_SETVL_SEW) := sew
+      insert(VFU_SETVL_VILL) := vill
+      when(input(VFU_SETVL)){
+        output(REGFILE_WRITE_DATA) := vl.asBits.resized
+      }
+    })
+
+    val setVlCommit = p.withVector generate (stages.last plug new Area{
+      import stages.last._
+      when(arbitration.isFiring && input(VFU_SETVL)){
+        vector.vl := input(VFU_SETVL_VL)
+        vector.sew := input(VFU_SETVL_SEW)
+        vector.vill := input(VFU_SETVL_VILL)
+      }
+    })
+
+    //The vector loads and stores are dispatched with the pipeline empty and then redone. The unit translate and check
+    //each element access, and the redone instance wait in decode for the completion to either trap on the fault or
+    //retire without dispatch, which keep the element faults precise.
+    val parking = p.withVector generate (pipeline plug new Area{
+      val awaiting = RegInit(False) //Dispatched, waiting for the completion
+      val parked = RegInit(False)   //Dispatched, the redone instance didn't retire yet
+      val pc = Reg(UInt(32 bits))
+      val result = Reg(VfuCompletion())
+
+      when(bus.completion.valid && awaiting){
+        awaiting := False
+        result := bus.completion.payload
+      }
+      if(trapTrace != null) when(trapTrace.valid){
+        parked := False
+      }
+      if(pipeline.serviceExist(classOf[InterruptionInhibitor])) when(awaiting || parked){
+        pipeline.service(classOf[InterruptionInhibitor]).inhibateInterrupts()
+      }
+    })
 
-    forkStage plug new Area{
+    val fork = forkStage plug new Area{
       import forkStage._
-      val hazard = stages.dropWhile(_ != forkStage).tail.map(s => s.arbitration.isValid && s.input(HAS_SIDE_EFFECT)).orR
+      val memoryOp = if(p.withVector) input(VFU_MEMORY) else False
+      val hazard = stages.dropWhile(_ != forkStage).tail.map(s => s.arbitration.isValid && (s.input(HAS_SIDE_EFFECT) || memoryOp)).orR
       val scheduleWish = arbitration.isValid && input(VFU_ENABLE)
       val schedule = scheduleWish && !hazard
       arbitration.haltItself setWhen(scheduleWish && hazard)
@@ -110,8 +288,144 @@ class VfuPlugin(val stageCount : Int,
       bus.cmd.inputs(0) := input(RS1)
       bus.cmd.inputs(1) := input(RS2)
       bus.cmd.rounding := csr.rounding
+      if(p.withVector) {
+        bus.cmd.vl := vector.vl
+        bus.cmd.sew := vector.sew.resized
+
+        redoBranch.valid := bus.cmd.fire && memoryOp
+        redoBranch.payload := input(PC)
+        arbitration.flushIt setWhen(redoBranch.valid)
+        arbitration.flushNext setWhen(redoBranch.valid)
+        when(redoBranch.valid){
+          parking.awaiting := True
+          parking.parked := True
+          parking.pc := input(PC)
+        }
+      }
     }
 
+    //The unit execute the instructions without scalar result in the background. Decode wait on it for the instructions
+    //with a scalar result and the memory accesses, and keep the number of pending instructions under its queue depth.
+    val scoreboard = p.withVector generate (decode plug new Area{
+      import decode._
+      val dispatched = bus.cmd.fire && !forkStage.input(REGFILE_WRITE_VALID)
+      val pending = Reg(UInt(log2Up(p.queueDepth + 1) + 1 bits)) init(0)
+      pending := pending + U(dispatched).resized - U(bus.completion.valid).resized
+
+      val forking = forkStage.arbitration.isValid && forkStage.input(VFU_ENABLE) && !fork.fired
+      val busy = pending =/= 0 || forking
+      val full = pending + U(forking).resized >= p.queueDepth
+      val setVlInFlight = stagesFromExecute.map(s => s.arbitration.isValid && s.input(VFU_SETVL)).orR
+      val memoryAccess = pipeline.plugins.collectFirst{ case plugin : DBusCachedPlugin => input(plugin.MEMORY_ENABLE) }.getOrElse(False)
+
+      //The redone instance of the dispatched load or store
+      val claim = parking.parked && input(VFU_MEMORY) && input(PC) === parking.pc
+      val vectorOp = input(VFU_ENABLE) && !claim
+      when(claim){
+        output(VFU_ENABLE) := False
+      }
+      arbitration.haltByOther setWhen(parking.awaiting)
+      arbitration.haltByOther setWhen(arbitration.isValid && (
+        vectorOp && full ||
+        vectorOp && (input(REGFILE_WRITE_VALID) || input(VFU_MEMORY)) && busy ||
+        (vectorOp || input(VFU_SETVL)) && setVlInFlight ||
+        !vectorOp && memoryAccess && busy
+      ))
+
+      val illegal = arbitration.isValid && vectorOp && vector.vill && !setVlInFlight
+      val fault = arbitration.isValid && claim && !parking.awaiting && parking.result.fault
+      decodeExceptionPort.valid := illegal || fault
+      decodeExceptionPort.code := 2
+      decodeExceptionPort.badAddr := input(INSTRUCTION).asUInt
+      when(fault){
+        decodeExceptionPort.code := parking.result.code
+        decodeExceptionPort.badAddr := parking.result.address
+      }
+      when(arbitration.isValid && claim && !parking.awaiting && (fault || !arbitration.isStuck)){
+        parking.parked := False
+      }
+    })
+
+    val unit = p.withVector generate (pipeline plug new Area{
+      val logic = VfuVectorUnit(p)
+      logic.io.port << bus
+    })
+
+    //Translate and check the element accesses of the unit before giving them to the data cache
+    val memoryBridge = p.withVector generate (pipeline plug new Area{
+      val cmd = bus.mem.cmd
+      val rsp = bus.mem.rsp
+      val checked = RegInit(False)
+      val translating = cmd.valid && !checked
+      val physicalAddress = Reg(UInt(32 bits))
+      val write = RegNextWhen(cmd.write, cmd.fire)
+      val faulted = RegInit(False) clearWhen(rsp.valid)
+      val faultCode = Reg(UInt(4 bits))
+
+      val misaligned = cmd.size.mux(
+        0 -> False,
+        1 -> cmd.address(0),
+        default -> (cmd.address(1 downto 0) =/= 0)
+      )
+
+      val latency = if(mmuBus != null) mmuBus.p.latency else 0
+      val settled = if(latency == 0) True else {
+        val counter = Reg(UInt(log2Up(latency + 1) bits)) init(0)
+        when(translating && counter =/= latency){ counter := counter + 1 }
+        when(!translating || cmd.fire){ counter := 0 }
+        counter === latency
+      }
+
+      val permission = new Area{
+        val physicalAddress = if(mmuBus != null) mmuBus.rsp.physicalAddress else cmd.address
+        val refilling = if(mmuBus != null) mmuBus.rsp.refilling else False
+        val isPaging = if(mmuBus != null) mmuBus.rsp.isPaging else False
+        val denied = if(mmuBus != null) mmuBus.rsp.exception || (cmd.write ? !mmuBus.rsp.allowWrite | !mmuBus.rsp.allowRead) else False
+      }
+
+      if(mmuBus != null) {
+        for(port <- mmuBus.cmd) {
+          port.isValid := translating
+          port.isStuck := False
+          port.virtualAddress := cmd.address
+          port.bypassTranslation := False
+        }
+        mmuBus.end := !translating || cmd.fire
+      }
+
+      cmd.ready := False
+      when(translating && settled){
+        when(misaligned){
+          cmd.ready := True
+          faulted := True
+          faultCode := (cmd.write ? U(6, 4 bits) | U(4, 4 bits))
+        } elsewhen(!permission.refilling){
+          when(permission.denied){
+            cmd.ready := True
+            faulted := True
+            faultCode := permission.isPaging ? (cmd.write ? U(15, 4 bits) | U(13, 4 bits)) | (cmd.write ? U(7, 4 bits) | U(5, 4 bits))
+          } otherwise {
+            checked := True
+            physicalAddress := permission.physicalAddress
+          }
+        }
+      }
+
+      dBusAccess.cmd.valid := checked
+      dBusAccess.cmd.payload := cmd.payload
+      dBusAccess.cmd.address := physicalAddress
+      when(dBusAccess.cmd.fire){
+        checked := False
+        cmd.ready := True
+      }
+
+      rsp.valid := faulted || dBusAccess.rsp.valid
+      rsp.data := dBusAccess.rsp.data
+      rsp.redo := dBusAccess.rsp.redo
+      rsp.fault := faulted || dBusAccess.rsp.error && !dBusAccess.rsp.redo
+      rsp.code := faulted ? faultCode | (write ? U(7, 4 bits) | U(5, 4 bits))
+    })
+
     joinStage plug new Area{
       import joinStage._
 
@@ -133,4 +447,3 @@ class VfuPlugin(val stageCount : Int,
     addPrePopTask(() => stages.dropWhile(_ != memory).reverse.dropWhile(_ != joinStage).foreach(s => s.input(VFU_IN_FLIGHT).init(False)))
   }
 }
-
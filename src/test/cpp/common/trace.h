@@ -0,0 +1,151 @@
+#pragma once
+
+#include <stdint.h>
+#include <deque>
+#include <functional>
+
+// Decoder for the words emitted by the TracePlugin. It rebuilds the retired PC stream by walking the program
+// binary, using the branch bitmaps for the conditional branches and the address packets for everything else.
+class TraceDecoder{
+public:
+	enum Kind {SYNC = 0, JUMP = 1, TRAP = 2};
+
+	struct Address{
+		uint32_t kind, privilege, interrupt, cause, count, pc;
+	};
+
+	struct Item{
+		bool isBitmap;
+		uint32_t bits, bitCount;
+		Address address;
+	};
+
+	std::function<uint16_t(uint32_t)> fetch16;
+	std::deque<Item> items;
+	std::deque<bool> bits;
+	bool headerPending = false;
+	Address header;
+
+	bool synced = false;
+	bool error = false;
+	uint32_t pc = 0, retired = 0, privilege = 3;
+	uint64_t words = 0, decoded = 0, traps = 0;
+
+	TraceDecoder(std::function<uint16_t(uint32_t)> fetch16) : fetch16(fetch16) {}
+
+	void push(uint32_t word){
+		words++;
+		if(headerPending){
+			header.pc = word;
+			items.push_back({false, 0, 0, header});
+			headerPending = false;
+		} else if(word & 1){
+			items.push_back({true, word >> 6, (word >> 1) & 0x1F, {}});
+		} else {
+			header.kind = (word >> 1) & 3;
+			header.privilege = (word >> 3) & 3;
+			header.interrupt = (word >> 5) & 1;
+			header.cause = (word >> 6) & 0x1F;
+			header.count = word >> 11;
+			headerPending = true;
+		}
+	}
+
+	// Give the next retired PC, return false when the trace received so far isn't enough to tell it
+	bool next(uint32_t *nextPc){
+		if(error) return false;
+		if(!synced){
+			if(items.empty()) return false;
+			if(items.front().isBitmap) return fail();
+			return jump(nextPc);
+		}
+
+		if(!items.empty() && !items.front().isBitmap){
+			Address &a = items.front().address;
+			if(a.count == retired) {
+				if(!bits.empty()) return fail();
+				return jump(nextPc);
+			}
+			if(a.count < retired) return fail();
+		}
+		// Without pending branch bits nor packets, an address packet (ex. interrupt) may still come for this instruction
+		if(bits.empty() && items.empty()) return false;
+
+		uint32_t i = fetch16(pc);
+		bool rvc = (i & 3) != 3;
+		if(!rvc) i |= fetch16(pc + 2) << 16;
+		uint32_t target = pc + (rvc ? 2 : 4);
+
+		if(rvc){
+			uint32_t quadrant = i & 3, funct3 = (i >> 13) & 7;
+			if(quadrant == 1 && (funct3 == 1 || funct3 == 5)){ // c.jal c.j
+				target = pc + sext(((i >> 12) & 1) << 11 | ((i >> 11) & 1) << 4 | ((i >> 9) & 3) << 8 | ((i >> 8) & 1) << 10 |
+				                   ((i >> 7) & 1) << 6 | ((i >> 6) & 1) << 7 | ((i >> 3) & 7) << 1 | ((i >> 2) & 1) << 5, 12);
+			} else if(quadrant == 1 && (funct3 == 6 || funct3 == 7)){ // c.beqz c.bnez
+				if(!takeBit(&target, pc + sext(((i >> 12) & 1) << 8 | ((i >> 10) & 3) << 3 | ((i >> 5) & 3) << 6 |
+				                                ((i >> 3) & 3) << 1 | ((i >> 2) & 1) << 5, 9))) return false;
+			} else if(quadrant == 2 && funct3 == 4 && ((i >> 2) & 0x1F) == 0 && ((i >> 7) & 0x1F) != 0){ // c.jr c.jalr
+				return indirect();
+			}
+		} else {
+			switch(i & 0x7F){
+			case 0x63: // branches
+				if(!takeBit(&target, pc + sext(((i >> 31) & 1) << 12 | ((i >> 7) & 1) << 11 | ((i >> 25) & 0x3F) << 5 | ((i >> 8) & 0xF) << 1, 13))) return false;
+				break;
+			case 0x6F: // jal
+				target = pc + sext(((i >> 31) & 1) << 20 | ((i >> 12) & 0xFF) << 12 | ((i >> 20) & 1) << 11 | ((i >> 21) & 0x3FF) << 1, 21);
+				break;
+			case 0x67: // jalr
+				return indirect();
+			}
+		}
+
+		pc = target;
+		retired++;
+		decoded++;
+		*nextPc = pc;
+		return true;
+	}
+
+private:
+	static uint32_t sext(uint32_t value, int width){
+		return (uint32_t)(((int32_t)(value << (32 - width))) >> (32 - width));
+	}
+
+	bool fail(){
+		error = true;
+		return false;
+	}
+
+	bool jump(uint32_t *nextPc){
+		Address &a = items.front().address;
+		if(a.kind == TRAP) traps++;
+		privilege = a.privilege;
+		pc = a.pc;
+		items.pop_front();
+		synced = true;
+		retired = 1;
+		decoded++;
+		*nextPc = pc;
+		return true;
+	}
+
+	// Indirect jumps always have their address packet, which wasn't there
+	bool indirect(){
+		if(items.empty()) return false;
+		return fail();
+	}
+
+	bool takeBit(uint32_t *target, uint32_t taken){
+		if(bits.empty()){
+			if(items.empty()) return false;
+			if(!items.front().isBitmap) return fail();
+			Item &b = items.front();
+			for(uint32_t idx = 0;idx < b.bitCount;idx++) bits.push_back((b.bits >> idx) & 1);
+			items.pop_front();
+		}
+		if(bits.front()) *target = taken;
+		bits.pop_front();
+		return true;
+	}
+};
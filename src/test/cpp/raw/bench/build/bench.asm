@@ -0,0 +1,182 @@
+
+build/bench.elf:	file format elf32-littleriscv
+
+Disassembly of section .text:
+
+80000000 <_start>:
+80000000: 6f 00 80 00  	j	0x80000008 <init>
+
+80000004 <irq_enable>:
+80000004: 00 00        	<unknown>
+80000006: 00 00        	<unknown>
+
+80000008 <init>:
+80000008: 13 0e 00 00  	li	t3, 0
+8000000c: b7 0f 10 f0  	lui	t6, 983296
+80000010: 93 8f 4f f5  	addi	t6, t6, -172
+80000014: b7 00 01 80  	lui	ra, 524304
+80000018: 13 01 00 40  	li	sp, 1024
+8000001c: b7 01 02 01  	lui	gp, 4128
+80000020: 93 81 41 30  	addi	gp, gp, 772
+
+80000024 <init_buffer>:
+80000024: 23 a0 30 00  	sw	gp, 0(ra)
+80000028: 93 81 11 11  	addi	gp, gp, 273
+8000002c: 93 80 40 00  	addi	ra, ra, 4
+80000030: 13 01 f1 ff  	addi	sp, sp, -1
+80000034: e3 18 01 fe  	bnez	sp, 0x80000024 <init_buffer>
+80000038: b7 40 01 80  	lui	ra, 524308
+8000003c: 37 51 01 80  	lui	sp, 524309
+80000040: 13 02 f0 3f  	li	tp, 1023
+
+80000044 <init_strings>:
+80000044: 93 71 f2 03  	andi	gp, tp, 63
+80000048: 93 81 01 02  	addi	gp, gp, 32
+8000004c: 23 80 30 00  	sb	gp, 0(ra)
+80000050: 23 00 31 00  	sb	gp, 0(sp)
+80000054: 93 80 10 00  	addi	ra, ra, 1
+80000058: 13 01 11 00  	addi	sp, sp, 1
+8000005c: 13 02 f2 ff  	addi	tp, tp, -1
+80000060: e3 12 02 fe  	bnez	tp, 0x80000044 <init_strings>
+80000064: 23 80 00 00  	sb	zero, 0(ra)
+80000068: 23 00 01 00  	sb	zero, 0(sp)
+
+8000006c <memcpy>:
+8000006c: 13 0e 10 00  	li	t3, 1
+80000070: b7 00 01 80  	lui	ra, 524304
+80000074: 37 21 01 80  	lui	sp, 524306
+80000078: b7 11 01 80  	lui	gp, 524305
+8000007c: 23 a0 cf 01  	sw	t3, 0(t6)
+
+80000080 <memcpy_loop>:
+80000080: 03 a2 00 00  	lw	tp, 0(ra)
+80000084: 83 a2 40 00  	lw	t0, 4(ra)
+80000088: 03 a3 80 00  	lw	t1, 8(ra)
+8000008c: 83 a3 c0 00  	lw	t2, 12(ra)
+80000090: 23 20 41 00  	sw	tp, 0(sp)
+80000094: 23 22 51 00  	sw	t0, 4(sp)
+80000098: 23 24 61 00  	sw	t1, 8(sp)
+8000009c: 23 26 71 00  	sw	t2, 12(sp)
+800000a0: 93 80 00 01  	addi	ra, ra, 16
+800000a4: 13 01 01 01  	addi	sp, sp, 16
+800000a8: e3 9c 30 fc  	bne	ra, gp, 0x80000080 <memcpy_loop>
+800000ac: 23 a0 0f 00  	sw	zero, 0(t6)
+800000b0: b7 00 01 80  	lui	ra, 524304
+800000b4: 37 21 01 80  	lui	sp, 524306
+
+800000b8 <memcpy_check>:
+800000b8: 03 a2 00 00  	lw	tp, 0(ra)
+800000bc: 83 22 01 00  	lw	t0, 0(sp)
+800000c0: 63 1a 52 12  	bne	tp, t0, 0x800001f4 <fail>
+800000c4: 93 80 40 00  	addi	ra, ra, 4
+800000c8: 13 01 41 00  	addi	sp, sp, 4
+800000cc: e3 96 30 fe  	bne	ra, gp, 0x800000b8 <memcpy_check>
+
+800000d0 <memset>:
+800000d0: 13 0e 20 00  	li	t3, 2
+800000d4: b7 20 01 80  	lui	ra, 524306
+800000d8: b7 31 01 80  	lui	gp, 524307
+800000dc: 37 62 5a 5a  	lui	tp, 370086
+800000e0: 13 02 a2 a5  	addi	tp, tp, -1446
+800000e4: 23 a0 cf 01  	sw	t3, 0(t6)
+
+800000e8 <memset_loop>:
+800000e8: 23 a0 40 00  	sw	tp, 0(ra)
+800000ec: 23 a2 40 00  	sw	tp, 4(ra)
+800000f0: 23 a4 40 00  	sw	tp, 8(ra)
+800000f4: 23 a6 40 00  	sw	tp, 12(ra)
+800000f8: 93 80 00 01  	addi	ra, ra, 16
+800000fc: e3 96 30 fe  	bne	ra, gp, 0x800000e8 <memset_loop>
+80000100: 23 a0 0f 00  	sw	zero, 0(t6)
+80000104: b7 20 01 80  	lui	ra, 524306
+
+80000108 <memset_check>:
+80000108: 83 a2 00 00  	lw	t0, 0(ra)
+8000010c: 63 14 52 0e  	bne	tp, t0, 0x800001f4 <fail>
+80000110: 93 80 40 00  	addi	ra, ra, 4
+80000114: e3 9a 30 fe  	bne	ra, gp, 0x80000108 <memset_check>
+
+80000118 <strcmp>:
+80000118: 13 0e 30 00  	li	t3, 3
+8000011c: b7 40 01 80  	lui	ra, 524308
+80000120: 37 51 01 80  	lui	sp, 524309
+80000124: 23 a0 cf 01  	sw	t3, 0(t6)
+
+80000128 <strcmp_loop>:
+80000128: 03 c2 00 00  	lbu	tp, 0(ra)
+8000012c: 83 42 01 00  	lbu	t0, 0(sp)
+80000130: 63 18 52 00  	bne	tp, t0, 0x80000140 <strcmp_done>
+80000134: 93 80 10 00  	addi	ra, ra, 1
+80000138: 13 01 11 00  	addi	sp, sp, 1
+8000013c: e3 16 02 fe  	bnez	tp, 0x80000128 <strcmp_loop>
+
+80000140 <strcmp_done>:
+80000140: 23 a0 0f 00  	sw	zero, 0(t6)
+80000144: 63 18 52 0a  	bne	tp, t0, 0x800001f4 <fail>
+80000148: b7 41 01 80  	lui	gp, 524308
+8000014c: 93 81 01 40  	addi	gp, gp, 1024
+80000150: 63 92 30 0a  	bne	ra, gp, 0x800001f4 <fail>
+
+80000154 <irq>:
+80000154: 97 00 00 00  	auipc	ra, 0
+80000158: 93 80 00 eb  	addi	ra, ra, -336
+8000015c: 83 a0 00 00  	lw	ra, 0(ra)
+80000160: 63 80 00 0a  	beqz	ra, 0x80000200 <pass>
+80000164: 13 0e 40 00  	li	t3, 4
+80000168: 97 00 00 00  	auipc	ra, 0
+8000016c: 93 80 40 06  	addi	ra, ra, 100
+80000170: 73 90 50 30  	csrw	mtvec, ra
+80000174: 93 00 00 08  	li	ra, 128
+80000178: 73 90 40 30  	csrw	mie, ra
+8000017c: 13 0f 00 01  	li	t5, 16
+80000180: 23 a0 cf 01  	sw	t3, 0(t6)
+
+80000184 <irq_loop>:
+80000184: b7 00 10 f0  	lui	ra, 983296
+80000188: 93 80 00 f4  	addi	ra, ra, -192
+8000018c: 03 a1 00 00  	lw	sp, 0(ra)
+80000190: 13 01 01 04  	addi	sp, sp, 64
+80000194: b7 00 10 f0  	lui	ra, 983296
+80000198: 93 80 80 f4  	addi	ra, ra, -184
+8000019c: 93 01 f0 ff  	li	gp, -1
+800001a0: 23 a2 30 00  	sw	gp, 4(ra)
+800001a4: 23 a0 20 00  	sw	sp, 0(ra)
+800001a8: 23 a2 00 00  	sw	zero, 4(ra)
+800001ac: 93 0e 0f 00  	mv	t4, t5
+800001b0: 73 60 04 30  	csrsi	mstatus, 8
+
+800001b4 <irq_wait>:
+800001b4: 63 80 ee 01  	beq	t4, t5, 0x800001b4 <irq_wait>
+800001b8: 73 70 04 30  	csrci	mstatus, 8
+800001bc: e3 14 0f fc  	bnez	t5, 0x80000184 <irq_loop>
+800001c0: 23 a0 0f 00  	sw	zero, 0(t6)
+800001c4: 73 10 40 30  	csrw	mie, zero
+800001c8: 6f 00 80 03  	j	0x80000200 <pass>
+
+800001cc <trap>:
+800001cc: f3 20 20 34  	csrr	ra, mcause
+800001d0: 37 01 00 80  	lui	sp, 524288
+800001d4: 13 01 71 00  	addi	sp, sp, 7
+800001d8: 63 9e 20 00  	bne	ra, sp, 0x800001f4 <fail>
+800001dc: b7 00 10 f0  	lui	ra, 983296
+800001e0: 93 80 80 f4  	addi	ra, ra, -184
+800001e4: 13 01 f0 ff  	li	sp, -1
+800001e8: 23 a2 20 00  	sw	sp, 4(ra)
+800001ec: 13 0f ff ff  	addi	t5, t5, -1
+800001f0: 73 00 20 30  	mret	
+
+800001f4 <fail>:
+800001f4: 37 01 10 f0  	lui	sp, 983296
+800001f8: 13 01 41 f2  	addi	sp, sp, -220
+800001fc: 23 20 c1 01  	sw	t3, 0(sp)
+
+80000200 <pass>:
+80000200: 37 01 10 f0  	lui	sp, 983296
+80000204: 13 01 01 f2  	addi	sp, sp, -224
+80000208: 23 20 01 00  	sw	zero, 0(sp)
+8000020c: 13 00 00 00  	nop
+80000210: 13 00 00 00  	nop
+80000214: 13 00 00 00  	nop
+80000218: 13 00 00 00  	nop
+8000021c: 13 00 00 00  	nop
+80000220: 13 00 00 00  	nop
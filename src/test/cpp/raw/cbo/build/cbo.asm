@@ -0,0 +1,172 @@
+
+build/cbo.elf:	file format elf32-littleriscv
+
+Disassembly of section .crt_section:
+
+80000000 <_start>:
+80000000: 6f 00 40 02  	j	0x80000024 <test1>
+80000004: 13 00 00 00  	nop
+80000008: 13 00 00 00  	nop
+8000000c: 13 00 00 00  	nop
+80000010: 13 00 00 00  	nop
+80000014: 13 00 00 00  	nop
+80000018: 13 00 00 00  	nop
+8000001c: 13 00 00 00  	nop
+
+80000020 <trap>:
+80000020: 6f 00 00 1e  	j	0x80000200 <fail>
+
+80000024 <test1>:
+80000024: 13 0e 10 00  	li	t3, 1
+80000028: 37 f5 0f 90  	lui	a0, 590079
+8000002c: b7 05 67 f5  	lui	a1, 1005168
+80000030: 93 00 a0 00  	li	ra, 10
+80000034: 23 20 15 00  	sw	ra, 0(a0)
+80000038: 03 21 05 00  	lw	sp, 0(a0)
+8000003c: 23 a0 05 00  	sw	zero, 0(a1)
+80000040: 03 21 05 00  	lw	sp, 0(a0)
+80000044: 63 1e 11 1a  	bne	sp, ra, 0x80000200 <fail>
+80000048: 0f 20 05 00  	<unknown>
+8000004c: 03 21 05 00  	lw	sp, 0(a0)
+80000050: 93 00 b0 00  	li	ra, 11
+80000054: 63 16 11 1a  	bne	sp, ra, 0x80000200 <fail>
+
+80000058 <test2>:
+80000058: 13 0e 20 00  	li	t3, 2
+8000005c: 03 21 05 00  	lw	sp, 0(a0)
+80000060: 23 a0 05 00  	sw	zero, 0(a1)
+80000064: 03 21 05 00  	lw	sp, 0(a0)
+80000068: 63 1c 11 18  	bne	sp, ra, 0x80000200 <fail>
+8000006c: 0f 20 25 00  	<unknown>
+80000070: 03 21 05 00  	lw	sp, 0(a0)
+80000074: 93 00 c0 00  	li	ra, 12
+80000078: 63 14 11 18  	bne	sp, ra, 0x80000200 <fail>
+
+8000007c <test3>:
+8000007c: 13 0e 30 00  	li	t3, 3
+80000080: 03 21 05 00  	lw	sp, 0(a0)
+80000084: 23 a0 05 00  	sw	zero, 0(a1)
+80000088: 0f 20 15 00  	<unknown>
+8000008c: 03 21 05 00  	lw	sp, 0(a0)
+80000090: 63 18 11 16  	bne	sp, ra, 0x80000200 <fail>
+80000094: 0f 20 05 00  	<unknown>
+80000098: 03 21 05 00  	lw	sp, 0(a0)
+8000009c: 93 00 d0 00  	li	ra, 13
+800000a0: 63 10 11 16  	bne	sp, ra, 0x80000200 <fail>
+
+800000a4 <test4>:
+800000a4: 13 0e 40 00  	li	t3, 4
+800000a8: 37 f5 0f 90  	lui	a0, 590079
+800000ac: 13 05 05 10  	addi	a0, a0, 256
+800000b0: b7 10 11 11  	lui	ra, 69905
+800000b4: 93 80 10 11  	addi	ra, ra, 273
+800000b8: 23 20 15 00  	sw	ra, 0(a0)
+800000bc: 23 22 15 00  	sw	ra, 4(a0)
+800000c0: 23 2e 15 00  	sw	ra, 28(a0)
+800000c4: 03 21 05 00  	lw	sp, 0(a0)
+800000c8: 0f 20 45 00  	<unknown>
+800000cc: 03 21 05 00  	lw	sp, 0(a0)
+800000d0: 63 18 01 12  	bnez	sp, 0x80000200 <fail>
+800000d4: 03 21 c5 01  	lw	sp, 28(a0)
+800000d8: 63 14 01 12  	bnez	sp, 0x80000200 <fail>
+800000dc: 0f 20 05 00  	<unknown>
+800000e0: 03 21 45 00  	lw	sp, 4(a0)
+800000e4: 63 1e 01 10  	bnez	sp, 0x80000200 <fail>
+800000e8: 03 21 c5 01  	lw	sp, 28(a0)
+800000ec: 63 1a 01 10  	bnez	sp, 0x80000200 <fail>
+
+800000f0 <test5>:
+800000f0: 13 0e 50 00  	li	t3, 5
+800000f4: 37 f5 0f 90  	lui	a0, 590079
+800000f8: 13 05 05 20  	addi	a0, a0, 512
+800000fc: b7 05 67 f5  	lui	a1, 1005168
+80000100: 93 85 05 20  	addi	a1, a1, 512
+80000104: b7 20 22 22  	lui	ra, 139810
+80000108: 93 80 20 22  	addi	ra, ra, 546
+8000010c: 23 20 15 00  	sw	ra, 0(a0)
+80000110: 23 24 15 00  	sw	ra, 8(a0)
+80000114: 0f 20 05 00  	<unknown>
+80000118: 0f 20 45 00  	<unknown>
+8000011c: 03 21 85 00  	lw	sp, 8(a0)
+80000120: 63 10 01 0e  	bnez	sp, 0x80000200 <fail>
+80000124: 23 a0 05 00  	sw	zero, 0(a1)
+80000128: 03 21 05 00  	lw	sp, 0(a0)
+8000012c: 63 1a 01 0c  	bnez	sp, 0x80000200 <fail>
+80000130: 0f 20 05 00  	<unknown>
+80000134: 03 21 05 00  	lw	sp, 0(a0)
+80000138: 93 00 10 00  	li	ra, 1
+8000013c: 63 12 11 0c  	bne	sp, ra, 0x80000200 <fail>
+80000140: 03 21 85 00  	lw	sp, 8(a0)
+80000144: 63 1e 01 0a  	bnez	sp, 0x80000200 <fail>
+
+80000148 <test6>:
+80000148: 13 0e 60 00  	li	t3, 6
+8000014c: 37 f5 0f 90  	lui	a0, 590079
+80000150: 13 05 05 30  	addi	a0, a0, 768
+80000154: b7 05 67 f5  	lui	a1, 1005168
+80000158: 93 85 05 34  	addi	a1, a1, 832
+8000015c: 93 00 e0 01  	li	ra, 30
+80000160: 23 20 15 04  	sw	ra, 64(a0)
+80000164: 93 01 05 04  	addi	gp, a0, 64
+80000168: 13 02 05 00  	mv	tp, a0
+8000016c: 13 85 01 00  	mv	a0, gp
+80000170: 0f 20 05 00  	<unknown>
+80000174: 13 05 02 00  	mv	a0, tp
+80000178: 13 60 15 04  	ori	zero, a0, 65
+8000017c: 93 02 80 0c  	li	t0, 200
+
+80000180 <test6_wait>:
+80000180: 93 82 f2 ff  	addi	t0, t0, -1
+80000184: e3 9e 02 fe  	bnez	t0, 0x80000180 <test6_wait>
+80000188: 23 a0 05 00  	sw	zero, 0(a1)
+8000018c: 03 21 05 04  	lw	sp, 64(a0)
+80000190: 63 18 11 06  	bne	sp, ra, 0x80000200 <fail>
+
+80000194 <test7>:
+80000194: 13 0e 70 00  	li	t3, 7
+80000198: 37 f5 0f 90  	lui	a0, 590079
+8000019c: 13 05 05 40  	addi	a0, a0, 1024
+800001a0: b7 05 67 f5  	lui	a1, 1005168
+800001a4: 93 85 05 44  	addi	a1, a1, 1088
+800001a8: 93 00 80 02  	li	ra, 40
+800001ac: 23 20 15 04  	sw	ra, 64(a0)
+800001b0: 93 01 05 04  	addi	gp, a0, 64
+800001b4: 13 02 05 00  	mv	tp, a0
+800001b8: 13 85 01 00  	mv	a0, gp
+800001bc: 0f 20 05 00  	<unknown>
+800001c0: 13 05 02 00  	mv	a0, tp
+800001c4: 13 60 35 04  	ori	zero, a0, 67
+800001c8: 93 02 80 0c  	li	t0, 200
+
+800001cc <test7_wait>:
+800001cc: 93 82 f2 ff  	addi	t0, t0, -1
+800001d0: e3 9e 02 fe  	bnez	t0, 0x800001cc <test7_wait>
+800001d4: 23 a0 05 00  	sw	zero, 0(a1)
+800001d8: 03 21 05 04  	lw	sp, 64(a0)
+800001dc: 63 12 11 02  	bne	sp, ra, 0x80000200 <fail>
+
+800001e0 <test8>:
+800001e0: 13 0e 80 00  	li	t3, 8
+800001e4: 37 05 10 f0  	lui	a0, 983296
+800001e8: 13 05 05 f2  	addi	a0, a0, -224
+800001ec: 13 60 15 04  	ori	zero, a0, 65
+800001f0: b7 01 10 f0  	lui	gp, 983296
+800001f4: 93 81 01 f2  	addi	gp, gp, -224
+800001f8: 63 14 35 00  	bne	a0, gp, 0x80000200 <fail>
+800001fc: 6f 00 00 01  	j	0x8000020c <pass>
+
+80000200 <fail>:
+80000200: 37 01 10 f0  	lui	sp, 983296
+80000204: 13 01 41 f2  	addi	sp, sp, -220
+80000208: 23 20 c1 01  	sw	t3, 0(sp)
+
+8000020c <pass>:
+8000020c: 37 01 10 f0  	lui	sp, 983296
+80000210: 13 01 01 f2  	addi	sp, sp, -224
+80000214: 23 20 01 00  	sw	zero, 0(sp)
+80000218: 13 00 00 00  	nop
+8000021c: 13 00 00 00  	nop
+80000220: 13 00 00 00  	nop
+80000224: 13 00 00 00  	nop
+80000228: 13 00 00 00  	nop
+8000022c: 13 00 00 00  	nop
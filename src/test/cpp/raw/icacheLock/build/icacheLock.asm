@@ -0,0 +1,110 @@
+
+build/icacheLock.elf:	file format elf32-littleriscv
+
+Disassembly of section .crt_section:
+
+80000000 <_start>:
+80000000: 73 10 00 7d  	csrw	2000, zero
+80000004: 73 10 10 7d  	csrw	2001, zero
+80000008: 0f 10 00 00  	fence.i	
+
+8000000c <test1>:
+8000000c: 13 0e 10 00  	li	t3, 1
+80000010: 93 00 20 00  	li	ra, 2
+80000014: 73 90 00 7d  	csrw	2000, ra
+80000018: 73 21 00 7d  	csrr	sp, 2000
+8000001c: 63 9e 20 0c  	bne	ra, sp, 0x800000f8 <fail>
+80000020: 73 10 00 7d  	csrw	2000, zero
+
+80000024 <test2>:
+80000024: 13 0e 20 00  	li	t3, 2
+
+80000028 <.Lpcrel_hi0>:
+80000028: 97 00 01 00  	auipc	ra, 16
+8000002c: 93 80 80 fd  	addi	ra, ra, -40
+80000030: 93 e0 10 00  	ori	ra, ra, 1
+80000034: 73 90 10 7d  	csrw	2001, ra
+80000038: 13 00 00 00  	nop
+8000003c: 13 00 00 00  	nop
+80000040: 13 00 00 00  	nop
+80000044: 13 00 00 00  	nop
+80000048: 13 00 00 00  	nop
+8000004c: 13 00 00 00  	nop
+80000050: 13 00 00 00  	nop
+80000054: 13 00 00 00  	nop
+80000058: 73 21 10 7d  	csrr	sp, 2001
+8000005c: 63 9e 20 08  	bne	ra, sp, 0x800000f8 <fail>
+
+80000060 <.Lpcrel_hi1>:
+80000060: 97 00 01 00  	auipc	ra, 16
+80000064: 93 80 00 fa  	addi	ra, ra, -96
+80000068: 37 01 20 00  	lui	sp, 512
+8000006c: 13 01 31 51  	addi	sp, sp, 1299
+80000070: 23 a0 20 00  	sw	sp, 0(ra)
+80000074: 0f 10 00 00  	fence.i	
+80000078: 97 00 01 00  	auipc	ra, 16
+8000007c: e7 80 80 f8  	jalr	-120(ra)
+80000080: 93 00 10 00  	li	ra, 1
+80000084: 63 1a 15 06  	bne	a0, ra, 0x800000f8 <fail>
+
+80000088 <test3>:
+80000088: 13 0e 30 00  	li	t3, 3
+8000008c: 97 00 02 00  	auipc	ra, 32
+80000090: e7 80 40 f7  	jalr	-140(ra)
+80000094: 97 00 02 00  	auipc	ra, 32
+80000098: e7 80 c0 f6  	jalr	-148(ra)
+8000009c: 97 00 01 00  	auipc	ra, 16
+800000a0: e7 80 40 f6  	jalr	-156(ra)
+800000a4: 93 00 10 00  	li	ra, 1
+800000a8: 63 18 15 04  	bne	a0, ra, 0x800000f8 <fail>
+
+800000ac <test4>:
+800000ac: 13 0e 40 00  	li	t3, 4
+800000b0: 93 00 f0 ff  	li	ra, -1
+800000b4: 73 90 00 7d  	csrw	2000, ra
+800000b8: 73 10 10 7d  	csrw	2001, zero
+800000bc: 0f 10 00 00  	fence.i	
+800000c0: 97 00 02 00  	auipc	ra, 32
+800000c4: e7 80 00 f4  	jalr	-192(ra)
+800000c8: 97 00 01 00  	auipc	ra, 16
+800000cc: e7 80 80 f3  	jalr	-200(ra)
+800000d0: 93 00 10 00  	li	ra, 1
+800000d4: 63 12 15 02  	bne	a0, ra, 0x800000f8 <fail>
+
+800000d8 <test5>:
+800000d8: 13 0e 50 00  	li	t3, 5
+800000dc: 73 10 00 7d  	csrw	2000, zero
+800000e0: 0f 10 00 00  	fence.i	
+800000e4: 97 00 01 00  	auipc	ra, 16
+800000e8: e7 80 c0 f1  	jalr	-228(ra)
+800000ec: 93 00 20 00  	li	ra, 2
+800000f0: 63 14 15 00  	bne	a0, ra, 0x800000f8 <fail>
+800000f4: 6f 00 00 01  	j	0x80000104 <pass>
+
+800000f8 <fail>:
+800000f8: 37 01 10 f0  	lui	sp, 983296
+800000fc: 13 01 41 f2  	addi	sp, sp, -220
+80000100: 23 20 c1 01  	sw	t3, 0(sp)
+
+80000104 <pass>:
+80000104: 37 01 10 f0  	lui	sp, 983296
+80000108: 13 01 01 f2  	addi	sp, sp, -224
+8000010c: 23 20 01 00  	sw	zero, 0(sp)
+80000110: 13 00 00 00  	nop
+80000114: 13 00 00 00  	nop
+80000118: 13 00 00 00  	nop
+8000011c: 13 00 00 00  	nop
+80000120: 13 00 00 00  	nop
+80000124: 13 00 00 00  	nop
+
+Disassembly of section .locked_section:
+
+80010000 <locked_function>:
+80010000: 13 05 10 00  	li	a0, 1
+80010004: 67 80 00 00  	ret
+
+Disassembly of section .thrash_section:
+
+80020000 <thrash_function>:
+80020000: 13 05 30 00  	li	a0, 3
+80020004: 67 80 00 00  	ret
@@ -0,0 +1,173 @@
+
+build/smpBandwidth.elf:	file format elf32-littleriscv
+
+Disassembly of section .crt_section:
+
+80000000 <_start>:
+80000000: 73 24 40 f1  	csrr	s0, mhartid
+80000004: b7 02 00 f8  	lui	t0, 1015808
+80000008: 73 23 40 f1  	csrr	t1, mhartid
+8000000c: 13 13 03 01  	slli	t1, t1, 16
+80000010: b3 82 62 00  	add	t0, t0, t1
+80000014: 23 a0 82 00  	sw	s0, 0(t0)
+
+80000018 <count_thread_start>:
+80000018: 13 05 10 00  	li	a0, 1
+8000001c: 97 05 00 00  	auipc	a1, 0
+80000020: 93 85 c5 15  	addi	a1, a1, 348
+80000024: 2f a0 a5 00  	amoadd.w	zero, a0, (a1)
+
+80000028 <count_thread_wait>:
+80000028: 17 04 00 00  	auipc	s0, 0
+8000002c: 03 24 04 15  	lw	s0, 336(s0)
+80000030: 13 05 00 19  	li	a0, 400
+80000034: 97 00 00 00  	auipc	ra, 0
+80000038: e7 80 80 13  	jalr	312(ra)
+8000003c: 97 04 00 00  	auipc	s1, 0
+80000040: 83 a4 c4 13  	lw	s1, 316(s1)
+80000044: e3 92 84 fe  	bne	s1, s0, 0x80000028 <count_thread_wait>
+80000048: b7 02 00 f8  	lui	t0, 1015808
+8000004c: 93 82 42 00  	addi	t0, t0, 4
+80000050: 73 23 40 f1  	csrr	t1, mhartid
+80000054: 13 13 03 01  	slli	t1, t1, 16
+80000058: b3 82 62 00  	add	t0, t0, t1
+8000005c: 23 a0 92 00  	sw	s1, 0(t0)
+
+80000060 <clear>:
+80000060: 73 29 40 f1  	csrr	s2, mhartid
+80000064: 13 19 d9 00  	slli	s2, s2, 13
+80000068: b7 02 10 80  	lui	t0, 524544
+8000006c: 33 09 59 00  	add	s2, s2, t0
+80000070: b7 22 00 00  	lui	t0, 2
+80000074: b3 09 59 00  	add	s3, s2, t0
+80000078: 93 03 09 00  	mv	t2, s2
+
+8000007c <clear_word>:
+8000007c: 23 a0 03 00  	sw	zero, 0(t2)
+80000080: 93 83 43 00  	addi	t2, t2, 4
+80000084: e3 ec 33 ff  	bltu	t2, s3, 0x8000007c <clear_word>
+80000088: 17 05 00 00  	auipc	a0, 0
+8000008c: 13 05 85 0f  	addi	a0, a0, 248
+80000090: 97 00 00 00  	auipc	ra, 0
+80000094: e7 80 80 0c  	jalr	200(ra)
+
+80000098 <bench>:
+80000098: b7 02 00 f8  	lui	t0, 1015808
+8000009c: 93 82 82 01  	addi	t0, t0, 24
+800000a0: 73 23 40 f1  	csrr	t1, mhartid
+800000a4: 13 13 03 01  	slli	t1, t1, 16
+800000a8: b3 82 62 00  	add	t0, t0, t1
+800000ac: 23 a0 02 00  	sw	zero, 0(t0)
+800000b0: 13 0a 40 00  	li	s4, 4
+
+800000b4 <bench_iteration>:
+800000b4: 93 03 09 00  	mv	t2, s2
+
+800000b8 <bench_word>:
+800000b8: 03 ae 03 00  	lw	t3, 0(t2)
+800000bc: 13 0e 1e 00  	addi	t3, t3, 1
+800000c0: 23 a0 c3 01  	sw	t3, 0(t2)
+800000c4: 93 83 43 00  	addi	t2, t2, 4
+800000c8: e3 e8 33 ff  	bltu	t2, s3, 0x800000b8 <bench_word>
+800000cc: 13 0a fa ff  	addi	s4, s4, -1
+800000d0: e3 12 0a fe  	bnez	s4, 0x800000b4 <bench_iteration>
+800000d4: b7 02 00 f8  	lui	t0, 1015808
+800000d8: 93 82 c2 01  	addi	t0, t0, 28
+800000dc: 73 23 40 f1  	csrr	t1, mhartid
+800000e0: 13 13 03 01  	slli	t1, t1, 16
+800000e4: b3 82 62 00  	add	t0, t0, t1
+800000e8: 23 a0 02 00  	sw	zero, 0(t0)
+800000ec: 17 05 00 00  	auipc	a0, 0
+800000f0: 13 05 45 0d  	addi	a0, a0, 212
+800000f4: 97 00 00 00  	auipc	ra, 0
+800000f8: e7 80 40 06  	jalr	100(ra)
+
+800000fc <check>:
+800000fc: 13 0a 40 00  	li	s4, 4
+80000100: 93 03 09 00  	mv	t2, s2
+
+80000104 <check_word>:
+80000104: 03 ae 03 00  	lw	t3, 0(t2)
+80000108: 63 16 4e 03  	bne	t3, s4, 0x80000134 <failure>
+8000010c: 93 83 43 00  	addi	t2, t2, 4
+80000110: e3 ea 33 ff  	bltu	t2, s3, 0x80000104 <check_word>
+
+80000114 <success>:
+80000114: 13 04 00 00  	li	s0, 0
+80000118: b7 02 00 f8  	lui	t0, 1015808
+8000011c: 93 82 82 00  	addi	t0, t0, 8
+80000120: 73 23 40 f1  	csrr	t1, mhartid
+80000124: 13 13 03 01  	slli	t1, t1, 16
+80000128: b3 82 62 00  	add	t0, t0, t1
+8000012c: 23 a0 82 00  	sw	s0, 0(t0)
+80000130: 6f 00 40 02  	j	0x80000154 <end>
+
+80000134 <failure>:
+80000134: 13 04 10 00  	li	s0, 1
+80000138: b7 02 00 f8  	lui	t0, 1015808
+8000013c: 93 82 82 00  	addi	t0, t0, 8
+80000140: 73 23 40 f1  	csrr	t1, mhartid
+80000144: 13 13 03 01  	slli	t1, t1, 16
+80000148: b3 82 62 00  	add	t0, t0, t1
+8000014c: 23 a0 82 00  	sw	s0, 0(t0)
+80000150: 6f 00 40 00  	j	0x80000154 <end>
+
+80000154 <end>:
+80000154: 6f 00 00 00  	j	0x80000154 <end>
+
+80000158 <barrier>:
+80000158: 93 02 10 00  	li	t0, 1
+8000015c: 2f 20 55 00  	amoadd.w	zero, t0, (a0)
+
+80000160 <barrier_wait>:
+80000160: 83 22 05 00  	lw	t0, 0(a0)
+80000164: e3 9e 92 fe  	bne	t0, s1, 0x80000160 <barrier_wait>
+80000168: 67 80 00 00  	ret
+
+8000016c <sleep>:
+8000016c: 13 05 f5 ff  	addi	a0, a0, -1
+80000170: e3 1e 05 fe  	bnez	a0, 0x8000016c <sleep>
+80000174: 67 80 00 00  	ret
+
+80000178 <thread_count>:
+80000178: 00 00        	<unknown>
+8000017a: 00 00        	<unknown>
+8000017c: 13 00 00 00  	nop
+
+80000180 <barrier_start>:
+80000180: 00 00        	<unknown>
+80000182: 00 00        	<unknown>
+80000184: 13 00 00 00  	nop
+80000188: 13 00 00 00  	nop
+8000018c: 13 00 00 00  	nop
+80000190: 13 00 00 00  	nop
+80000194: 13 00 00 00  	nop
+80000198: 13 00 00 00  	nop
+8000019c: 13 00 00 00  	nop
+800001a0: 13 00 00 00  	nop
+800001a4: 13 00 00 00  	nop
+800001a8: 13 00 00 00  	nop
+800001ac: 13 00 00 00  	nop
+800001b0: 13 00 00 00  	nop
+800001b4: 13 00 00 00  	nop
+800001b8: 13 00 00 00  	nop
+800001bc: 13 00 00 00  	nop
+
+800001c0 <barrier_end>:
+800001c0: 00 00        	<unknown>
+800001c2: 00 00        	<unknown>
+800001c4: 13 00 00 00  	nop
+800001c8: 13 00 00 00  	nop
+800001cc: 13 00 00 00  	nop
+800001d0: 13 00 00 00  	nop
+800001d4: 13 00 00 00  	nop
+800001d8: 13 00 00 00  	nop
+800001dc: 13 00 00 00  	nop
+800001e0: 13 00 00 00  	nop
+800001e4: 13 00 00 00  	nop
+800001e8: 13 00 00 00  	nop
+800001ec: 13 00 00 00  	nop
+800001f0: 13 00 00 00  	nop
+800001f4: 13 00 00 00  	nop
+800001f8: 13 00 00 00  	nop
+800001fc: 13 00 00 00  	nop
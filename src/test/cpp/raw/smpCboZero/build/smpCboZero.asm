@@ -0,0 +1,267 @@
+
+build/smpCboZero.elf:	file format elf32-littleriscv
+
+Disassembly of section .crt_section:
+
+80000000 <_start>:
+80000000: 73 24 40 f1  	csrr	s0, mhartid
+80000004: b7 02 00 f8  	lui	t0, 1015808
+80000008: 73 23 40 f1  	csrr	t1, mhartid
+8000000c: 13 13 03 01  	slli	t1, t1, 16
+80000010: b3 82 62 00  	add	t0, t0, t1
+80000014: 23 a0 82 00  	sw	s0, 0(t0)
+
+80000018 <count_thread_start>:
+80000018: 13 05 10 00  	li	a0, 1
+8000001c: 97 05 00 00  	auipc	a1, 0
+80000020: 93 85 05 19  	addi	a1, a1, 400
+80000024: 2f a0 a5 00  	<unknown>
+
+80000028 <count_thread_wait>:
+80000028: 17 04 00 00  	auipc	s0, 0
+8000002c: 03 24 44 18  	lw	s0, 388(s0)
+80000030: 13 05 00 19  	li	a0, 400
+80000034: 97 00 00 00  	auipc	ra, 0
+80000038: e7 80 c0 16  	jalr	364(ra)
+8000003c: 97 04 00 00  	auipc	s1, 0
+80000040: 83 a4 04 17  	lw	s1, 368(s1)
+80000044: e3 92 84 fe  	bne	s1, s0, 0x80000028 <count_thread_wait>
+80000048: b7 02 00 f8  	lui	t0, 1015808
+8000004c: 93 82 42 00  	addi	t0, t0, 4
+80000050: 73 23 40 f1  	csrr	t1, mhartid
+80000054: 13 13 03 01  	slli	t1, t1, 16
+80000058: b3 82 62 00  	add	t0, t0, t1
+8000005c: 23 a0 92 00  	sw	s1, 0(t0)
+80000060: 73 24 40 f1  	csrr	s0, mhartid
+80000064: 93 02 20 00  	li	t0, 2
+80000068: 63 72 54 0e  	bgeu	s0, t0, 0x8000014c <success>
+8000006c: 93 04 20 00  	li	s1, 2
+
+80000070 <test1>:
+80000070: 13 09 10 00  	li	s2, 1
+80000074: 63 18 04 00  	bnez	s0, 0x80000084 <test1_hart1>
+80000078: 17 05 00 00  	auipc	a0, 0
+8000007c: 13 05 85 24  	addi	a0, a0, 584
+80000080: 0f 20 45 00  	<unknown>
+
+80000084 <test1_hart1>:
+80000084: 17 05 00 00  	auipc	a0, 0
+80000088: 13 05 c5 13  	addi	a0, a0, 316
+8000008c: 97 00 00 00  	auipc	ra, 0
+80000090: e7 80 00 10  	jalr	256(ra)
+80000094: 63 0c 04 00  	beqz	s0, 0x800000ac <test1_check>
+80000098: 97 03 00 00  	auipc	t2, 0
+8000009c: 93 83 83 22  	addi	t2, t2, 552
+800000a0: 37 5e 34 12  	lui	t3, 74565
+800000a4: 13 0e 8e 67  	addi	t3, t3, 1656
+800000a8: 23 a4 c3 01  	sw	t3, 8(t2)
+
+800000ac <test1_check>:
+800000ac: 17 05 00 00  	auipc	a0, 0
+800000b0: 13 05 45 15  	addi	a0, a0, 340
+800000b4: 97 00 00 00  	auipc	ra, 0
+800000b8: e7 80 80 0d  	jalr	216(ra)
+800000bc: 63 12 04 02  	bnez	s0, 0x800000e0 <test2>
+800000c0: 97 03 00 00  	auipc	t2, 0
+800000c4: 93 83 03 20  	addi	t2, t2, 512
+800000c8: 03 ae 83 00  	lw	t3, 8(t2)
+800000cc: b7 5e 34 12  	lui	t4, 74565
+800000d0: 93 8e 8e 67  	addi	t4, t4, 1656
+800000d4: 63 1c de 09  	bne	t3, t4, 0x8000016c <failure>
+800000d8: 03 ae 03 00  	lw	t3, 0(t2)
+800000dc: 63 18 0e 08  	bnez	t3, 0x8000016c <failure>
+
+800000e0 <test2>:
+800000e0: 13 09 20 00  	li	s2, 2
+800000e4: 63 0e 04 00  	beqz	s0, 0x80000100 <test2_hart0>
+800000e8: 97 03 00 00  	auipc	t2, 0
+800000ec: 93 83 83 21  	addi	t2, t2, 536
+800000f0: 03 ae 43 00  	lw	t3, 4(t2)
+800000f4: b7 0e fe ca  	lui	t4, 831456
+800000f8: 93 8e 1e 00  	addi	t4, t4, 1
+800000fc: 63 18 de 07  	bne	t3, t4, 0x8000016c <failure>
+
+80000100 <test2_hart0>:
+80000100: 17 05 00 00  	auipc	a0, 0
+80000104: 13 05 05 14  	addi	a0, a0, 320
+80000108: 97 00 00 00  	auipc	ra, 0
+8000010c: e7 80 40 08  	jalr	132(ra)
+80000110: 63 18 04 00  	bnez	s0, 0x80000120 <test2_check>
+80000114: 17 05 00 00  	auipc	a0, 0
+80000118: 13 05 c5 1e  	addi	a0, a0, 492
+8000011c: 0f 20 45 00  	<unknown>
+
+80000120 <test2_check>:
+80000120: 17 05 00 00  	auipc	a0, 0
+80000124: 13 05 05 16  	addi	a0, a0, 352
+80000128: 97 00 00 00  	auipc	ra, 0
+8000012c: e7 80 40 06  	jalr	100(ra)
+80000130: 63 0e 04 00  	beqz	s0, 0x8000014c <success>
+80000134: 97 03 00 00  	auipc	t2, 0
+80000138: 93 83 c3 1c  	addi	t2, t2, 460
+8000013c: 03 ae 43 00  	lw	t3, 4(t2)
+80000140: 63 16 0e 02  	bnez	t3, 0x8000016c <failure>
+80000144: 03 ae c3 03  	lw	t3, 60(t2)
+80000148: 63 12 0e 02  	bnez	t3, 0x8000016c <failure>
+
+8000014c <success>:
+8000014c: 13 04 00 00  	li	s0, 0
+80000150: b7 02 00 f8  	lui	t0, 1015808
+80000154: 93 82 82 00  	addi	t0, t0, 8
+80000158: 73 23 40 f1  	csrr	t1, mhartid
+8000015c: 13 13 03 01  	slli	t1, t1, 16
+80000160: b3 82 62 00  	add	t0, t0, t1
+80000164: 23 a0 82 00  	sw	s0, 0(t0)
+80000168: 6f 00 00 02  	j	0x80000188 <end>
+
+8000016c <failure>:
+8000016c: b7 02 00 f8  	lui	t0, 1015808
+80000170: 93 82 82 00  	addi	t0, t0, 8
+80000174: 73 23 40 f1  	csrr	t1, mhartid
+80000178: 13 13 03 01  	slli	t1, t1, 16
+8000017c: b3 82 62 00  	add	t0, t0, t1
+80000180: 23 a0 22 01  	sw	s2, 0(t0)
+80000184: 6f 00 40 00  	j	0x80000188 <end>
+
+80000188 <end>:
+80000188: 6f 00 00 00  	j	0x80000188 <end>
+
+8000018c <barrier>:
+8000018c: 93 02 10 00  	li	t0, 1
+80000190: 2f 20 55 00  	<unknown>
+
+80000194 <barrier_wait>:
+80000194: 83 22 05 00  	lw	t0, 0(a0)
+80000198: e3 9e 92 fe  	bne	t0, s1, 0x80000194 <barrier_wait>
+8000019c: 67 80 00 00  	ret
+
+800001a0 <sleep>:
+800001a0: 13 05 f5 ff  	addi	a0, a0, -1
+800001a4: e3 1e 05 fe  	bnez	a0, 0x800001a0 <sleep>
+800001a8: 67 80 00 00  	ret
+
+800001ac <thread_count>:
+800001ac: 00 00        	<unknown>
+800001ae: 00 00        	<unknown>
+800001b0: 13 00 00 00  	nop
+800001b4: 13 00 00 00  	nop
+800001b8: 13 00 00 00  	nop
+800001bc: 13 00 00 00  	nop
+
+800001c0 <barrier_1>:
+800001c0: 00 00        	<unknown>
+800001c2: 00 00        	<unknown>
+800001c4: 13 00 00 00  	nop
+800001c8: 13 00 00 00  	nop
+800001cc: 13 00 00 00  	nop
+800001d0: 13 00 00 00  	nop
+800001d4: 13 00 00 00  	nop
+800001d8: 13 00 00 00  	nop
+800001dc: 13 00 00 00  	nop
+800001e0: 13 00 00 00  	nop
+800001e4: 13 00 00 00  	nop
+800001e8: 13 00 00 00  	nop
+800001ec: 13 00 00 00  	nop
+800001f0: 13 00 00 00  	nop
+800001f4: 13 00 00 00  	nop
+800001f8: 13 00 00 00  	nop
+800001fc: 13 00 00 00  	nop
+
+80000200 <barrier_2>:
+80000200: 00 00        	<unknown>
+80000202: 00 00        	<unknown>
+80000204: 13 00 00 00  	nop
+80000208: 13 00 00 00  	nop
+8000020c: 13 00 00 00  	nop
+80000210: 13 00 00 00  	nop
+80000214: 13 00 00 00  	nop
+80000218: 13 00 00 00  	nop
+8000021c: 13 00 00 00  	nop
+80000220: 13 00 00 00  	nop
+80000224: 13 00 00 00  	nop
+80000228: 13 00 00 00  	nop
+8000022c: 13 00 00 00  	nop
+80000230: 13 00 00 00  	nop
+80000234: 13 00 00 00  	nop
+80000238: 13 00 00 00  	nop
+8000023c: 13 00 00 00  	nop
+
+80000240 <barrier_3>:
+80000240: 00 00        	<unknown>
+80000242: 00 00        	<unknown>
+80000244: 13 00 00 00  	nop
+80000248: 13 00 00 00  	nop
+8000024c: 13 00 00 00  	nop
+80000250: 13 00 00 00  	nop
+80000254: 13 00 00 00  	nop
+80000258: 13 00 00 00  	nop
+8000025c: 13 00 00 00  	nop
+80000260: 13 00 00 00  	nop
+80000264: 13 00 00 00  	nop
+80000268: 13 00 00 00  	nop
+8000026c: 13 00 00 00  	nop
+80000270: 13 00 00 00  	nop
+80000274: 13 00 00 00  	nop
+80000278: 13 00 00 00  	nop
+8000027c: 13 00 00 00  	nop
+
+80000280 <barrier_4>:
+80000280: 00 00        	<unknown>
+80000282: 00 00        	<unknown>
+80000284: 13 00 00 00  	nop
+80000288: 13 00 00 00  	nop
+8000028c: 13 00 00 00  	nop
+80000290: 13 00 00 00  	nop
+80000294: 13 00 00 00  	nop
+80000298: 13 00 00 00  	nop
+8000029c: 13 00 00 00  	nop
+800002a0: 13 00 00 00  	nop
+800002a4: 13 00 00 00  	nop
+800002a8: 13 00 00 00  	nop
+800002ac: 13 00 00 00  	nop
+800002b0: 13 00 00 00  	nop
+800002b4: 13 00 00 00  	nop
+800002b8: 13 00 00 00  	nop
+800002bc: 13 00 00 00  	nop
+
+800002c0 <line_a>:
+800002c0: 00 00        	<unknown>
+800002c2: fe ca        	<unknown>
+800002c4: 01 00        	<unknown>
+800002c6: fe ca        	<unknown>
+800002c8: 02 00        	<unknown>
+800002ca: fe ca        	<unknown>
+800002cc: 03 00 fe ca  	lb	zero, -849(t3)
+800002d0: ff 00 fe ca  	<unknown>
+800002d4: ff 00 fe ca  	<unknown>
+800002d8: ff 00 fe ca  	<unknown>
+800002dc: ff 00 fe ca  	<unknown>
+800002e0: ff 00 fe ca  	<unknown>
+800002e4: ff 00 fe ca  	<unknown>
+800002e8: ff 00 fe ca  	<unknown>
+800002ec: ff 00 fe ca  	<unknown>
+800002f0: ff 00 fe ca  	<unknown>
+800002f4: ff 00 fe ca  	<unknown>
+800002f8: ff 00 fe ca  	<unknown>
+800002fc: ff 00 fe ca  	<unknown>
+
+80000300 <line_b>:
+80000300: 00 00        	<unknown>
+80000302: fe ca        	<unknown>
+80000304: 01 00        	<unknown>
+80000306: fe ca        	<unknown>
+80000308: 02 00        	<unknown>
+8000030a: fe ca        	<unknown>
+8000030c: 03 00 fe ca  	lb	zero, -849(t3)
+80000310: ff 00 fe ca  	<unknown>
+80000314: ff 00 fe ca  	<unknown>
+80000318: ff 00 fe ca  	<unknown>
+8000031c: ff 00 fe ca  	<unknown>
+80000320: ff 00 fe ca  	<unknown>
+80000324: ff 00 fe ca  	<unknown>
+80000328: ff 00 fe ca  	<unknown>
+8000032c: ff 00 fe ca  	<unknown>
+80000330: ff 00 fe ca  	<unknown>
+80000334: ff 00 fe ca  	<unknown>
+80000338: ff 00 fe ca  	<unknown>
+8000033c: ff 00 fe ca  	<unknown>
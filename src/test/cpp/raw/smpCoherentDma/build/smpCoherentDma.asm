@@ -0,0 +1,75 @@
+
+build/smpCoherentDma.elf:	file format elf32-littleriscv
+
+Disassembly of section .crt_section:
+
+80000000 <_start>:
+80000000: 73 24 40 f1  	csrr	s0, mhartid
+80000004: b7 02 00 f8  	lui	t0, 1015808
+80000008: 73 23 40 f1  	csrr	t1, mhartid
+8000000c: 13 13 03 01  	slli	t1, t1, 16
+80000010: b3 82 62 00  	add	t0, t0, t1
+80000014: 23 a0 82 00  	sw	s0, 0(t0)
+80000018: 13 19 64 00  	slli	s2, s0, 6
+8000001c: b7 02 10 80  	lui	t0, 524544
+80000020: 33 09 59 00  	add	s2, s2, t0
+80000024: b7 19 11 11  	lui	s3, 69905
+80000028: 93 89 19 11  	addi	s3, s3, 273
+8000002c: 37 3a 33 33  	lui	s4, 209715
+80000030: 13 0a 3a 33  	addi	s4, s4, 819
+80000034: 23 20 39 01  	sw	s3, 0(s2)
+80000038: 23 22 49 01  	sw	s4, 4(s2)
+
+8000003c <test1>:
+8000003c: 93 0a 10 00  	li	s5, 1
+80000040: 83 23 09 00  	lw	t2, 0(s2)
+80000044: 63 9c 33 07  	bne	t2, s3, 0x800000bc <failure>
+80000048: 83 23 49 00  	lw	t2, 4(s2)
+8000004c: 63 98 43 07  	bne	t2, s4, 0x800000bc <failure>
+
+80000050 <test2>:
+80000050: 93 0a 20 00  	li	s5, 2
+80000054: b7 02 00 f8  	lui	t0, 1015808
+80000058: 93 82 c2 00  	addi	t0, t0, 12
+8000005c: 73 23 40 f1  	csrr	t1, mhartid
+80000060: 13 13 03 01  	slli	t1, t1, 16
+80000064: b3 82 62 00  	add	t0, t0, t1
+80000068: 23 a0 22 01  	sw	s2, 0(t0)
+8000006c: 37 5e 00 00  	lui	t3, 5
+80000070: 13 0e 0e e2  	addi	t3, t3, -480
+80000074: b7 2e 22 22  	lui	t4, 139810
+80000078: 93 8e 2e 22  	addi	t4, t4, 546
+
+8000007c <test2_wait>:
+8000007c: 83 23 09 00  	lw	t2, 0(s2)
+80000080: 63 88 d3 01  	beq	t2, t4, 0x80000090 <test3>
+80000084: 13 0e fe ff  	addi	t3, t3, -1
+80000088: e3 1a 0e fe  	bnez	t3, 0x8000007c <test2_wait>
+8000008c: 6f 00 00 03  	j	0x800000bc <failure>
+
+80000090 <test3>:
+80000090: 93 0a 30 00  	li	s5, 3
+80000094: 83 23 49 00  	lw	t2, 4(s2)
+80000098: 63 92 43 03  	bne	t2, s4, 0x800000bc <failure>
+
+8000009c <success>:
+8000009c: 13 04 00 00  	li	s0, 0
+800000a0: b7 02 00 f8  	lui	t0, 1015808
+800000a4: 93 82 82 00  	addi	t0, t0, 8
+800000a8: 73 23 40 f1  	csrr	t1, mhartid
+800000ac: 13 13 03 01  	slli	t1, t1, 16
+800000b0: b3 82 62 00  	add	t0, t0, t1
+800000b4: 23 a0 82 00  	sw	s0, 0(t0)
+800000b8: 6f 00 00 02  	j	0x800000d8 <end>
+
+800000bc <failure>:
+800000bc: b7 02 00 f8  	lui	t0, 1015808
+800000c0: 93 82 82 00  	addi	t0, t0, 8
+800000c4: 73 23 40 f1  	csrr	t1, mhartid
+800000c8: 13 13 03 01  	slli	t1, t1, 16
+800000cc: b3 82 62 00  	add	t0, t0, t1
+800000d0: 23 a0 52 01  	sw	s5, 0(t0)
+800000d4: 6f 00 40 00  	j	0x800000d8 <end>
+
+800000d8 <end>:
+800000d8: 6f 00 00 00  	j	0x800000d8 <end>
@@ -0,0 +1,213 @@
+
+build/vector.elf:	file format elf32-littleriscv
+
+Disassembly of section .crt_section:
+
+80000000 <_start>:
+80000000: 6f 00 c0 03  	j	0x8000003c <init>
+80000004: 13 00 00 00  	nop
+80000008: 13 00 00 00  	nop
+8000000c: 13 00 00 00  	nop
+80000010: 13 00 00 00  	nop
+80000014: 13 00 00 00  	nop
+80000018: 13 00 00 00  	nop
+8000001c: 13 00 00 00  	nop
+
+80000020 <trap_entry>:
+80000020: f3 2e 20 34  	csrr	t4, mcause
+80000024: 73 2f 10 34  	csrr	t5, mepc
+80000028: f3 2f 30 34  	csrr	t6, mtval
+8000002c: 93 8d 02 00  	mv	s11, t0
+80000030: 13 0d 4f 00  	addi	s10, t5, 4
+80000034: 73 10 1d 34  	csrw	mepc, s10
+80000038: 73 00 20 30  	mret	
+
+8000003c <init>:
+8000003c: 97 00 00 00  	auipc	ra, 0
+80000040: 93 80 40 fe  	addi	ra, ra, -28
+80000044: 73 90 50 30  	csrw	mtvec, ra
+
+80000048 <test1>:
+80000048: 13 0e 10 00  	li	t3, 1
+8000004c: d7 72 02 cd  	<unknown>
+80000050: 93 00 40 00  	li	ra, 4
+80000054: 63 9c 12 1e  	bne	t0, ra, 0x8000024c <fail>
+80000058: 17 05 00 00  	auipc	a0, 0
+8000005c: 13 05 85 22  	addi	a0, a0, 552
+80000060: 97 05 00 00  	auipc	a1, 0
+80000064: 93 85 05 23  	addi	a1, a1, 560
+80000068: 87 60 05 02  	<unknown>
+8000006c: a7 e0 05 02  	<unknown>
+80000070: 13 01 00 00  	li	sp, 0
+
+80000074 <test1_check>:
+80000074: b3 01 25 00  	add	gp, a0, sp
+80000078: 33 82 25 00  	add	tp, a1, sp
+8000007c: 83 a1 01 00  	lw	gp, 0(gp)
+80000080: 03 22 02 00  	lw	tp, 0(tp)
+80000084: 63 94 41 1c  	bne	gp, tp, 0x8000024c <fail>
+80000088: 13 01 41 00  	addi	sp, sp, 4
+8000008c: 93 00 00 01  	li	ra, 16
+80000090: e3 12 11 fe  	bne	sp, ra, 0x80000074 <test1_check>
+
+80000094 <test2>:
+80000094: 13 0e 20 00  	li	t3, 2
+80000098: d7 26 10 42  	<unknown>
+8000009c: 83 20 05 00  	lw	ra, 0(a0)
+800000a0: 63 96 16 1a  	bne	a3, ra, 0x8000024c <fail>
+
+800000a4 <test3>:
+800000a4: 13 0e 30 00  	li	t3, 3
+800000a8: d7 72 82 cc  	<unknown>
+800000ac: 97 05 00 00  	auipc	a1, 0
+800000b0: 93 85 45 1e  	addi	a1, a1, 484
+800000b4: 13 06 40 00  	li	a2, 4
+800000b8: 07 51 c5 0a  	<unknown>
+800000bc: 27 d1 05 02  	<unknown>
+800000c0: 83 d0 05 00  	lhu	ra, 0(a1)
+800000c4: 03 51 05 00  	lhu	sp, 0(a0)
+800000c8: 63 92 20 18  	bne	ra, sp, 0x8000024c <fail>
+800000cc: 83 d0 25 00  	lhu	ra, 2(a1)
+800000d0: 03 51 45 00  	lhu	sp, 4(a0)
+800000d4: 63 9c 20 16  	bne	ra, sp, 0x8000024c <fail>
+800000d8: 83 d0 45 00  	lhu	ra, 4(a1)
+800000dc: 03 51 85 00  	lhu	sp, 8(a0)
+800000e0: 63 96 20 16  	bne	ra, sp, 0x8000024c <fail>
+800000e4: 83 d0 65 00  	lhu	ra, 6(a1)
+800000e8: 03 51 c5 00  	lhu	sp, 12(a0)
+800000ec: 63 90 20 16  	bne	ra, sp, 0x8000024c <fail>
+
+800000f0 <test4>:
+800000f0: 13 0e 40 00  	li	t3, 4
+800000f4: d7 72 02 cd  	<unknown>
+800000f8: 97 05 00 00  	auipc	a1, 0
+800000fc: 93 85 85 19  	addi	a1, a1, 408
+80000100: 13 06 80 00  	li	a2, 8
+80000104: 23 a2 05 00  	sw	zero, 4(a1)
+80000108: a7 e0 c5 0a  	<unknown>
+8000010c: 83 a0 05 00  	lw	ra, 0(a1)
+80000110: 03 21 05 00  	lw	sp, 0(a0)
+80000114: 63 9c 20 12  	bne	ra, sp, 0x8000024c <fail>
+80000118: 83 a0 85 00  	lw	ra, 8(a1)
+8000011c: 03 21 45 00  	lw	sp, 4(a0)
+80000120: 63 96 20 12  	bne	ra, sp, 0x8000024c <fail>
+80000124: 83 a0 05 01  	lw	ra, 16(a1)
+80000128: 03 21 85 00  	lw	sp, 8(a0)
+8000012c: 63 90 20 12  	bne	ra, sp, 0x8000024c <fail>
+80000130: 83 a0 85 01  	lw	ra, 24(a1)
+80000134: 03 21 c5 00  	lw	sp, 12(a0)
+80000138: 63 9a 20 10  	bne	ra, sp, 0x8000024c <fail>
+8000013c: 83 a0 45 00  	lw	ra, 4(a1)
+80000140: 63 96 00 10  	bnez	ra, 0x8000024c <fail>
+
+80000144 <test5>:
+80000144: 13 0e 50 00  	li	t3, 5
+80000148: 93 0e 00 00  	li	t4, 0
+8000014c: d7 72 80 0d  	<unknown>
+80000150: 63 9e 02 0e  	bnez	t0, 0x8000024c <fail>
+80000154: 97 00 00 00  	auipc	ra, 0
+80000158: 93 80 80 00  	addi	ra, ra, 8
+
+8000015c <test5_vector>:
+8000015c: d7 81 10 02  	<unknown>
+80000160: 13 01 20 00  	li	sp, 2
+80000164: 63 94 2e 0e  	bne	t4, sp, 0x8000024c <fail>
+80000168: 63 12 1f 0e  	bne	t5, ra, 0x8000024c <fail>
+
+8000016c <test6>:
+8000016c: 13 0e 60 00  	li	t3, 6
+80000170: 93 0e 00 00  	li	t4, 0
+80000174: 93 02 00 00  	li	t0, 0
+80000178: d7 72 02 cd  	<unknown>
+8000017c: 37 05 10 f0  	lui	a0, 983296
+80000180: 13 05 85 f5  	addi	a0, a0, -168
+80000184: 97 00 00 00  	auipc	ra, 0
+80000188: 93 80 80 00  	addi	ra, ra, 8
+
+8000018c <test6_vector>:
+8000018c: 07 62 05 02  	<unknown>
+80000190: 93 82 12 00  	addi	t0, t0, 1
+80000194: 13 01 50 00  	li	sp, 5
+80000198: 63 9a 2e 0a  	bne	t4, sp, 0x8000024c <fail>
+8000019c: 63 18 1f 0a  	bne	t5, ra, 0x8000024c <fail>
+800001a0: 37 01 10 f0  	lui	sp, 983296
+800001a4: 13 01 01 f6  	addi	sp, sp, -160
+800001a8: 63 92 2f 0a  	bne	t6, sp, 0x8000024c <fail>
+800001ac: 63 90 0d 0a  	bnez	s11, 0x8000024c <fail>
+800001b0: 13 01 10 00  	li	sp, 1
+800001b4: 63 9c 22 08  	bne	t0, sp, 0x8000024c <fail>
+
+800001b8 <test7>:
+800001b8: 13 0e 70 00  	li	t3, 7
+800001bc: 93 0e 00 00  	li	t4, 0
+800001c0: 17 05 00 00  	auipc	a0, 0
+800001c4: 13 05 05 0c  	addi	a0, a0, 192
+800001c8: 13 05 25 00  	addi	a0, a0, 2
+800001cc: 97 00 00 00  	auipc	ra, 0
+800001d0: 93 80 80 00  	addi	ra, ra, 8
+
+800001d4 <test7_vector>:
+800001d4: 07 62 05 02  	<unknown>
+800001d8: 13 01 40 00  	li	sp, 4
+800001dc: 63 98 2e 06  	bne	t4, sp, 0x8000024c <fail>
+800001e0: 63 16 1f 06  	bne	t5, ra, 0x8000024c <fail>
+800001e4: 63 94 af 06  	bne	t6, a0, 0x8000024c <fail>
+
+800001e8 <test8>:
+800001e8: 13 0e 80 00  	li	t3, 8
+800001ec: 93 0e 00 00  	li	t4, 0
+800001f0: 17 05 00 00  	auipc	a0, 0
+800001f4: 13 05 05 0a  	addi	a0, a0, 160
+800001f8: 37 51 34 12  	lui	sp, 74565
+800001fc: 13 01 81 67  	addi	sp, sp, 1656
+80000200: 23 20 25 00  	sw	sp, 0(a0)
+80000204: 23 22 25 00  	sw	sp, 4(a0)
+80000208: 13 05 15 00  	addi	a0, a0, 1
+8000020c: 97 00 00 00  	auipc	ra, 0
+80000210: 93 80 80 00  	addi	ra, ra, 8
+
+80000214 <test8_vector>:
+80000214: 27 62 05 02  	<unknown>
+80000218: 13 01 60 00  	li	sp, 6
+8000021c: 63 98 2e 02  	bne	t4, sp, 0x8000024c <fail>
+80000220: 63 16 1f 02  	bne	t5, ra, 0x8000024c <fail>
+80000224: 63 94 af 02  	bne	t6, a0, 0x8000024c <fail>
+80000228: 17 05 00 00  	auipc	a0, 0
+8000022c: 13 05 85 06  	addi	a0, a0, 104
+80000230: 37 51 34 12  	lui	sp, 74565
+80000234: 13 01 81 67  	addi	sp, sp, 1656
+80000238: 83 20 05 00  	lw	ra, 0(a0)
+8000023c: 63 98 20 00  	bne	ra, sp, 0x8000024c <fail>
+80000240: 83 20 45 00  	lw	ra, 4(a0)
+80000244: 63 94 20 00  	bne	ra, sp, 0x8000024c <fail>
+80000248: 6f 00 00 01  	j	0x80000258 <pass>
+
+8000024c <fail>:
+8000024c: 37 01 10 f0  	lui	sp, 983296
+80000250: 13 01 41 f2  	addi	sp, sp, -220
+80000254: 23 20 c1 01  	sw	t3, 0(sp)
+
+80000258 <pass>:
+80000258: 37 01 10 f0  	lui	sp, 983296
+8000025c: 13 01 01 f2  	addi	sp, sp, -224
+80000260: 23 20 01 00  	sw	zero, 0(sp)
+80000264: 13 00 00 00  	nop
+80000268: 13 00 00 00  	nop
+8000026c: 13 00 00 00  	nop
+80000270: 13 00 00 00  	nop
+80000274: 13 00 00 00  	nop
+80000278: 13 00 00 00  	nop
+8000027c: 13 00 00 00  	nop
+
+80000280 <source>:
+80000280: 44 33        	<unknown>
+80000282: 22 11        	<unknown>
+80000284: 88 77        	<unknown>
+80000286: 66 55        	<unknown>
+80000288: cc bb        	<unknown>
+8000028a: aa 99        	<unknown>
+8000028c: 00 ff        	<unknown>
+8000028e: ee dd        	<unknown>
+
+80000290 <destination>:
+		...
@@ -0,0 +1,310 @@
+#pragma once
+
+#include <stdint.h>
+#include <unistd.h>
+#include <atomic>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+// Thrown to the client waiting on an access which was aborted
+class DmiAborted : public std::runtime_error{
+public:
+	DmiAborted() : std::runtime_error("DMI aborted") {}
+};
+
+// In process transactor of the RISC-V Debug Module Interface. Accesses are queued by a client thread and executed by the
+// simulation thread, one at the time. Batched accesses are queued without waiting, the client only waits on the last one.
+class Dmi{
+public:
+	enum Kind {WRITE, READ, WAIT_ABSTRACT, WAIT_SYSTEM_BUS};
+	enum State {IDLE, CMD, RSP};
+
+	static const uint32_t DATA0 = 0x04, DMCONTROL = 0x10, DMSTATUS = 0x11, ABSTRACTCS = 0x16, COMMAND = 0x17, ABSTRACTAUTO = 0x18;
+	static const uint32_t PROGBUF0 = 0x20, PROGBUF1 = 0x21, SBCS = 0x38, SBADDRESS0 = 0x39, SBDATA0 = 0x3C;
+
+	struct Access{
+		Kind kind;
+		uint32_t address, data;
+		std::promise<uint32_t> *result;
+	};
+
+	std::mutex mutex;
+	std::deque<Access> accesses;
+	State state = IDLE;
+	uint64_t accessCount = 0, errors = 0;
+	std::atomic<bool> aborted{false};
+
+	~Dmi(){
+		abort();
+	}
+
+	// Drop the pending accesses, their client and the later accesses get a DmiAborted exception
+	void abort(){
+		std::lock_guard<std::mutex> guard(mutex);
+		aborted = true;
+		state = IDLE;
+		for(Access &access : accesses) if(access.result){
+			access.result->set_exception(std::make_exception_ptr(DmiAborted()));
+			delete access.result;
+		}
+		accesses.clear();
+	}
+
+	void write(uint32_t address, uint32_t data){
+		push({WRITE, address, data, NULL});
+	}
+
+	std::future<uint32_t> readAsync(uint32_t address){
+		return push({READ, address, 0, new std::promise<uint32_t>()});
+	}
+
+	uint32_t read(uint32_t address){
+		return readAsync(address).get();
+	}
+
+	// Poll abstractcs until the abstract command is done, give its final value
+	std::future<uint32_t> waitAbstract(){
+		return push({WAIT_ABSTRACT, ABSTRACTCS, 0, new std::promise<uint32_t>()});
+	}
+
+	// Poll sbcs until the system bus access is done, give its final value
+	std::future<uint32_t> waitSystemBus(){
+		return push({WAIT_SYSTEM_BUS, SBCS, 0, new std::promise<uint32_t>()});
+	}
+
+	// Simulation side
+	bool cmdValid(){
+		std::lock_guard<std::mutex> guard(mutex);
+		if(state == IDLE && !accesses.empty()) state = CMD;
+		return state == CMD;
+	}
+
+	Access& current(){
+		std::lock_guard<std::mutex> guard(mutex);
+		return accesses.front();
+	}
+
+	void cycle(bool cmdFire, bool rspValid, bool rspError, uint32_t rspData){
+		if(state == CMD && cmdFire) state = RSP;
+		if(state != RSP || !rspValid) return;
+
+		std::lock_guard<std::mutex> guard(mutex);
+		Access &access = accesses.front();
+		accessCount++;
+		if(rspError) errors++;
+		state = IDLE;
+		if(access.kind == WAIT_ABSTRACT && (rspData & (1 << 12))) return;
+		if(access.kind == WAIT_SYSTEM_BUS && (rspData & (1 << 21))) return;
+		if(access.result){
+			access.result->set_value(rspData);
+			delete access.result;
+		}
+		accesses.pop_front();
+	}
+
+private:
+	std::future<uint32_t> push(Access access){
+		std::future<uint32_t> future;
+		if(access.result) future = access.result->get_future();
+		std::lock_guard<std::mutex> guard(mutex);
+		if(aborted){
+			if(access.result){
+				access.result->set_exception(std::make_exception_ptr(DmiAborted()));
+				delete access.result;
+			}
+			return future;
+		}
+		accesses.push_back(access);
+		return future;
+	}
+};
+
+// Debugger built over the Dmi : run control, abstract register accesses and memory accesses.
+// Memory goes through the system bus access when the debug module has one, else through the program buffer.
+class DmiDebugger{
+public:
+	static const uint32_t S0 = 0x1008, S1 = 0x1009, DCSR = 0x7B0, DPC = 0x7B1;
+
+	Dmi *dmi;
+	bool impebreak = false, systemBus = false;
+	uint32_t progbufSize = 0;
+
+	DmiDebugger(Dmi *dmi) : dmi(dmi) {}
+
+	bool init(){
+		dmi->write(Dmi::DMCONTROL, 1);
+		uint32_t dmstatus = dmi->read(Dmi::DMSTATUS);
+		if((dmstatus & 0xF) == 0) return false;
+		impebreak = (dmstatus >> 22) & 1;
+		progbufSize = (dmi->read(Dmi::ABSTRACTCS) >> 24) & 0x1F;
+		uint32_t sbcs = dmi->read(Dmi::SBCS);
+		systemBus = ((sbcs >> 5) & 0x7F) != 0 && (sbcs & (1 << 2));
+		return systemBus || progbufSize >= 2 || (progbufSize == 1 && impebreak);
+	}
+
+	void halt(){
+		dmi->write(Dmi::DMCONTROL, 1 | 1u << 31);
+		waitHalted();
+		dmi->write(Dmi::DMCONTROL, 1);
+	}
+
+	void resume(){
+		dmi->write(Dmi::DMCONTROL, 1 | 1 << 30);
+		while((dmi->read(Dmi::DMSTATUS) & (1 << 17)) == 0) usleep(10);
+		dmi->write(Dmi::DMCONTROL, 1);
+	}
+
+	void waitHalted(){
+		while((dmi->read(Dmi::DMSTATUS) & (1 << 9)) == 0) usleep(10);
+	}
+
+	// Return false and clear the error if the abstract command failed
+	bool checkAbstract(){
+		uint32_t abstractcs = dmi->waitAbstract().get();
+		if((abstractcs >> 8) & 7){
+			dmi->write(Dmi::ABSTRACTCS, 7 << 8);
+			return false;
+		}
+		return true;
+	}
+
+	bool readRegister(uint32_t regno, uint32_t *value){
+		dmi->write(Dmi::COMMAND, 0x00220000 | regno);
+		if(!checkAbstract()) return false;
+		*value = dmi->read(Dmi::DATA0);
+		return true;
+	}
+
+	bool writeRegister(uint32_t regno, uint32_t value){
+		dmi->write(Dmi::DATA0, value);
+		dmi->write(Dmi::COMMAND, 0x00230000 | regno);
+		return checkAbstract();
+	}
+
+	bool readRegisters(std::vector<uint32_t> &regnos, std::vector<uint32_t> &values){
+		std::vector<std::future<uint32_t>> futures;
+		for(uint32_t regno : regnos){
+			dmi->write(Dmi::COMMAND, 0x00220000 | regno);
+			dmi->waitAbstract();
+			futures.push_back(dmi->readAsync(Dmi::DATA0));
+		}
+		values.clear();
+		for(auto &future : futures) values.push_back(future.get());
+		return checkAbstract();
+	}
+
+	bool fenceI(){
+		dmi->write(Dmi::PROGBUF0, 0x0000100F); //fence.i
+		if(progbufSize >= 2) dmi->write(Dmi::PROGBUF1, 0x00100073); //ebreak
+		dmi->write(Dmi::COMMAND, 0x00240000);
+		return checkAbstract();
+	}
+
+	bool writeMemory(uint32_t address, const std::vector<uint32_t> &data){
+		if(data.empty()) return true;
+		if(systemBus){
+			dmi->write(Dmi::SBCS, 2 << 17 | 1 << 16);
+			dmi->write(Dmi::SBADDRESS0, address);
+			for(uint32_t word : data){
+				dmi->write(Dmi::SBDATA0, word);
+				dmi->waitSystemBus();
+			}
+			return checkSystemBus();
+		}
+
+		uint32_t s0, s1;
+		if(!readRegister(S0, &s0) || !readRegister(S1, &s1)) return false;
+		dmi->write(Dmi::PROGBUF0, 0x0084A023); //sw s0, 0(s1)
+		if(autoIncrement()){
+			dmi->write(Dmi::PROGBUF1, 0x00448493); //addi s1, s1, 4
+			if(!writeRegister(S1, address)) return false;
+			dmi->write(Dmi::DATA0, data[0]);
+			dmi->write(Dmi::COMMAND, 0x00270000 | S0);
+			dmi->waitAbstract();
+			dmi->write(Dmi::ABSTRACTAUTO, 1);
+			for(size_t i = 1;i < data.size();i++){
+				dmi->write(Dmi::DATA0, data[i]);
+				dmi->waitAbstract();
+			}
+			dmi->write(Dmi::ABSTRACTAUTO, 0);
+		} else {
+			if(progbufSize >= 2) dmi->write(Dmi::PROGBUF1, 0x00100073); //ebreak
+			for(size_t i = 0;i < data.size();i++){
+				dmi->write(Dmi::DATA0, address + i*4);
+				dmi->write(Dmi::COMMAND, 0x00230000 | S1);
+				dmi->waitAbstract();
+				dmi->write(Dmi::DATA0, data[i]);
+				dmi->write(Dmi::COMMAND, 0x00270000 | S0);
+				dmi->waitAbstract();
+			}
+		}
+		bool success = checkAbstract();
+		return writeRegister(S0, s0) && writeRegister(S1, s1) && success;
+	}
+
+	bool readMemory(uint32_t address, uint32_t count, std::vector<uint32_t> &data){
+		data.clear();
+		if(count == 0) return true;
+		std::vector<std::future<uint32_t>> futures;
+		if(systemBus){
+			dmi->write(Dmi::SBCS, 1 << 20 | 2 << 17 | 1 << 16 | 1 << 15);
+			dmi->write(Dmi::SBADDRESS0, address);
+			for(uint32_t i = 0;i < count;i++){
+				dmi->waitSystemBus();
+				futures.push_back(dmi->readAsync(Dmi::SBDATA0));
+			}
+			for(auto &future : futures) data.push_back(future.get());
+			return checkSystemBus();
+		}
+
+		uint32_t s0, s1;
+		if(!readRegister(S0, &s0) || !readRegister(S1, &s1)) return false;
+		dmi->write(Dmi::PROGBUF0, 0x0004A403); //lw s0, 0(s1)
+		if(autoIncrement()){
+			dmi->write(Dmi::PROGBUF1, 0x00448493); //addi s1, s1, 4
+			if(!writeRegister(S1, address)) return false;
+			dmi->write(Dmi::COMMAND, 0x00240000);
+			dmi->waitAbstract();
+			dmi->write(Dmi::COMMAND, 0x00260000 | S0);
+			dmi->waitAbstract();
+			dmi->write(Dmi::ABSTRACTAUTO, 1);
+			for(uint32_t i = 0;i + 1 < count;i++){
+				futures.push_back(dmi->readAsync(Dmi::DATA0));
+				dmi->waitAbstract();
+			}
+			dmi->write(Dmi::ABSTRACTAUTO, 0);
+			futures.push_back(dmi->readAsync(Dmi::DATA0));
+		} else {
+			if(progbufSize >= 2) dmi->write(Dmi::PROGBUF1, 0x00100073); //ebreak
+			for(uint32_t i = 0;i < count;i++){
+				dmi->write(Dmi::DATA0, address + i*4);
+				dmi->write(Dmi::COMMAND, 0x00270000 | S1);
+				dmi->waitAbstract();
+				dmi->write(Dmi::COMMAND, 0x00220000 | S0);
+				dmi->waitAbstract();
+				futures.push_back(dmi->readAsync(Dmi::DATA0));
+			}
+		}
+		for(auto &future : futures) data.push_back(future.get());
+		bool success = checkAbstract();
+		return writeRegister(S0, s0) && writeRegister(S1, s1) && success;
+	}
+
+private:
+	// The two instructions program buffer (access + increment) needs the implicit ebreak
+	bool autoIncrement(){
+		return impebreak && progbufSize >= 2;
+	}
+
+	bool checkSystemBus(){
+		uint32_t sbcs = dmi->waitSystemBus().get();
+		if(sbcs & (7 << 12 | 1 << 22)){
+			dmi->write(Dmi::SBCS, 7 << 12 | 1 << 22);
+			return false;
+		}
+		return true;
+	}
+};
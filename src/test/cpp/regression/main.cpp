@@ -17,6 +17,14 @@
 #include <mutex>
 #include <iomanip>
 #include <queue>
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <random>
+#include <deque>
+#include <thread>
+#include <condition_variable>
+#include <sstream>
 #include <time.h>
 #include "encoding.h"
 
@@ -24,6 +32,19 @@
 
 using namespace std;
 
+// Read at runtime, so the simulation binary doesn't depend on the seed value (0 when SEED is unset)
+static long regressionSeed = getenv("SEED") ? strtol(getenv("SEED"), NULL, 0) : 0;
+
+#ifndef DEBUG_PLUGIN_PORT
+#define DEBUG_PLUGIN_PORT 7893
+#endif
+
+uint64_t thread_time(){
+    struct timespec time;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+    return time.tv_sec*1000000000ull + time.tv_nsec;
+}
+
 struct timespec timer_get(){
     struct timespec start_time;
     clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &start_time);
@@ -65,6 +86,17 @@ public:
 		for(int i = 0;i < length;i++){
 			(*this)[address + i] = data[i];
 		}
+		if(length == 0) return;
+		for(uint64_t page = address >> 12;page <= (uint64_t(address) + length - 1) >> 12;page++){
+			markDirty(page << 12);
+		}
+	}
+
+	// One bit per 4 KiB page written since the last clear, used by the memory consistency scan
+	vector<uint64_t> dirty;
+	void markDirty(uint32_t address){
+		if(dirty.empty()) dirty.resize(1 << 14);
+		dirty[address >> 18] |= 1ull << ((address >> 12) & 63);
 	}
 
 	uint8_t& operator [](uint32_t address) {
@@ -491,29 +523,113 @@ public:
 	virtual void dWrite(int32_t address, int32_t size, uint8_t *data) = 0;
 
 	enum AccessKind {READ,WRITE,EXECUTE,READ_WRITE};
+
+	// Functional coverage, as hit counts per bin. The bin kind is in the 8 MSB of the key, see coverageBinName
+	enum CoverageKind {COVER_INSTRUCTION, COVER_CSR, COVER_TRAP, COVER_MMU};
+	enum OperandClass {OPERAND_NONE, OPERAND_ZERO, OPERAND_ONE, OPERAND_MINUS_ONE, OPERAND_MIN, OPERAND_MAX, OPERAND_POSITIVE, OPERAND_NEGATIVE};
+	enum MmuOutcome {MMU_BARE, MMU_INVALID_L1, MMU_INVALID_L0, MMU_USER_PAGE, MMU_SUPERVISOR_PAGE, MMU_MISALIGNED_SUPERPAGE, MMU_NOT_ACCESSED, MMU_READ_DENIED, MMU_WRITE_DENIED, MMU_EXECUTE_DENIED, MMU_SUPERPAGE, MMU_PAGE};
+	#ifdef COVERAGE
+	unordered_map<uint64_t, uint64_t> coverage;
+	#endif
+
+	void cover(CoverageKind kind, uint64_t bin){
+		#ifdef COVERAGE
+		coverage[(uint64_t(kind) << 56) | bin]++;
+		#endif
+	}
+
+	static uint32_t operandClass(int32_t value){
+		switch(value){
+		case 0: return OPERAND_ZERO;
+		case 1: return OPERAND_ONE;
+		case -1: return OPERAND_MINUS_ONE;
+		case INT32_MIN: return OPERAND_MIN;
+		case INT32_MAX: return OPERAND_MAX;
+		}
+		return value > 0 ? OPERAND_POSITIVE : OPERAND_NEGATIVE;
+	}
+
+	// Instruction form (opcode and the funct fields which select the operation) x operands corner classes.
+	// The RVC forms are only covered by their encoding.
+	void coverInstruction(uint32_t i){
+		#ifdef COVERAGE
+		uint32_t form, rs1 = OPERAND_NONE, rs2 = OPERAND_NONE;
+		bool withRs1 = true, withRs2 = false;
+		if((i & 3) != 3){
+			form = i & 0xE003;
+			withRs1 = false;
+		} else switch(i & 0x7F){
+		case 0x37: case 0x17: case 0x6F: form = i & 0x7F; withRs1 = false; break;
+		case 0x33: form = i & 0xFE00707F; withRs2 = true; break;
+		case 0x63: case 0x23: form = i & 0x707F; withRs2 = true; break;
+		case 0x2F: form = i & 0xF800707F; withRs2 = true; break;
+		case 0x13: form = (i & 0x3000) == 0x1000 ? i & 0xFE00707F : i & 0x707F; break;
+		case 0x73: form = (i & 0x7000) ? i & 0x707F : i & 0xFFF07FFF; withRs1 = (i & 0x3000) && !(i & 0x4000); break;
+		default: form = i & 0x707F; break;
+		}
+		if(withRs1) rs1 = operandClass(regs[(i >> 15) & 0x1F]);
+		if(withRs2) rs2 = operandClass(regs[(i >> 20) & 0x1F]);
+		bool equal = withRs1 && withRs2 && regs[(i >> 15) & 0x1F] == regs[(i >> 20) & 0x1F];
+		cover(COVER_INSTRUCTION, (uint64_t(form) << 8) | (equal << 6) | (rs1 << 3) | rs2);
+		#endif
+	}
+
+	bool coverMmu(MmuOutcome outcome, AccessKind kind, bool fault){
+		cover(COVER_MMU, (outcome << 2) | kind);
+		return fault;
+	}
+
+	static string coverageBinName(uint64_t key){
+		static const char *operands[] = {"none", "zero", "one", "minusOne", "min", "max", "positive", "negative"};
+		static const char *privileges[] = {"U", "S", "H", "M"};
+		static const char *accesses[] = {"read", "write", "execute", "readWrite"};
+		static const char *outcomes[] = {"bare", "invalidL1", "invalidL0", "userPage", "supervisorPage", "misalignedSuperpage", "notAccessed", "readDenied", "writeDenied", "executeDenied", "superpage", "page"};
+		static const char *csrAccesses[] = {"", "csrrw", "csrrs", "csrrc", "", "csrrwi", "csrrsi", "csrrci"};
+		uint64_t bin = key & 0xFFFFFFFFFFFFFFull;
+		stringstream s;
+		switch(key >> 56){
+		case COVER_INSTRUCTION:
+			s << "insn_" << hex << setw(8) << setfill('0') << (bin >> 8) << dec << "_" << operands[(bin >> 3) & 7] << "_" << operands[bin & 7] << ((bin >> 6) & 1 ? "_equal" : "");
+			break;
+		case COVER_CSR:
+			s << "csr_" << hex << setw(3) << setfill('0') << (bin >> 8) << dec << "_" << csrAccesses[(bin >> 2) & 7] << ((bin >> 1) & 1 ? "_write" : "_read") << (bin & 1 ? "_illegal" : "");
+			break;
+		case COVER_TRAP:
+			s << ((bin >> 16) ? "interrupt_" : "exception_") << ((bin >> 4) & 0xFFF) << "_" << privileges[(bin >> 2) & 3] << "_to_" << privileges[bin & 3];
+			break;
+		case COVER_MMU:
+			s << "mmu_" << outcomes[bin >> 2] << "_" << accesses[bin & 3];
+			break;
+		}
+		return s.str();
+	}
+
 	virtual bool isMmuRegion(uint32_t v) = 0;
 	bool v2p(uint32_t v, uint32_t *p, AccessKind kind){
 	    uint32_t effectivePrivilege = status.mprv && kind != EXECUTE ? status.mpp : privilege;
 		if(effectivePrivilege == 3 || satp.mode == 0 || !isMmuRegion(v)){
 			*p = v;
+			coverMmu(MMU_BARE, kind, false);
 		} else {
 			Tlb tlb;
 			dRead((satp.ppn << 12) | ((v >> 22) << 2), 4, (uint8_t*)&tlb.raw);
-			if(!tlb.v) return true;
+			if(!tlb.v) return coverMmu(MMU_INVALID_L1, kind, true);
 			bool superPage = true;
 			if(!tlb.x && !tlb.r && !tlb.w){
 				dRead((tlb.ppn << 12) | (((v >> 12) & 0x3FF) << 2), 4, (uint8_t*)&tlb.raw);
-				if(!tlb.v) return true;
+				if(!tlb.v) return coverMmu(MMU_INVALID_L0, kind, true);
 				superPage = false;
 			}
-			if(!tlb.u && effectivePrivilege == 0) return true;
-			if( tlb.u && effectivePrivilege == 1 && !status.sum) return true;
-			if(superPage && tlb.ppn0 != 0 || !tlb.a) return true;
-			if(kind == READ || kind == READ_WRITE) if(!tlb.r && !(status.mxr && tlb.x)) return true;
-			if(kind == WRITE || kind == READ_WRITE) if(!tlb.w || !tlb.d) return true;
-			if(kind == EXECUTE) if(!tlb.x) return true;
+			if(!tlb.u && effectivePrivilege == 0) return coverMmu(MMU_SUPERVISOR_PAGE, kind, true);
+			if( tlb.u && effectivePrivilege == 1 && !status.sum) return coverMmu(MMU_USER_PAGE, kind, true);
+			if(superPage && tlb.ppn0 != 0) return coverMmu(MMU_MISALIGNED_SUPERPAGE, kind, true);
+			if(!tlb.a) return coverMmu(MMU_NOT_ACCESSED, kind, true);
+			if(kind == READ || kind == READ_WRITE) if(!tlb.r && !(status.mxr && tlb.x)) return coverMmu(MMU_READ_DENIED, kind, true);
+			if(kind == WRITE || kind == READ_WRITE) if(!tlb.w || !tlb.d) return coverMmu(MMU_WRITE_DENIED, kind, true);
+			if(kind == EXECUTE) if(!tlb.x) return coverMmu(MMU_EXECUTE_DENIED, kind, true);
 
 			*p = (tlb.ppn1 << 22) | (superPage ? v & 0x3FF000 : tlb.ppn0 << 12) | (v & 0xFFF);
+			coverMmu(superPage ? MMU_SUPERPAGE : MMU_PAGE, kind, false);
 		}
 		return false;
 	}
@@ -550,6 +666,7 @@ public:
 		uint32_t targetPrivilege = 3;
 		if(deleg & (1 << cause)) targetPrivilege = 1;
 		targetPrivilege = max(targetPrivilege, privilege);
+		cover(COVER_TRAP, (uint64_t(interrupt) << 16) | ((cause & 0xFFF) << 4) | (privilege << 2) | targetPrivilege);
 		Xtvec xtvec = targetPrivilege == 3 ? mtvec : stvec;
 
 
@@ -702,12 +819,15 @@ public:
     int livenessInterrupt = 0;
     uint32_t pendingInterruptsPtr = 0;
     uint32_t pendingInterrupts[5] = {0,0,0,0,0};
-    virtual void liveness(bool inWfi){
+    // cycles > 1 account for that many cycles with the same inputs, used by the sampled lockstep
+    virtual void liveness(bool inWfi, uint64_t cycles = 1){
     	uint32_t pendingInterrupt = getPendingInterrupt();
-    	pendingInterrupts[pendingInterruptsPtr++] = getPendingInterrupt();
-    	if(pendingInterruptsPtr >= 5) pendingInterruptsPtr = 0;
-        if(pendingInterrupt) livenessInterrupt++; else livenessInterrupt = 0;
-        if(!inWfi) livenessStep++; else livenessStep = 0;
+    	for(uint64_t c = 0;c < cycles && c < 5;c++){
+    	    pendingInterrupts[pendingInterruptsPtr++] = pendingInterrupt;
+    	    if(pendingInterruptsPtr >= 5) pendingInterruptsPtr = 0;
+    	}
+        if(pendingInterrupt) livenessInterrupt += cycles; else livenessInterrupt = 0;
+        if(!inWfi) livenessStep += cycles; else livenessStep = 0;
 
         if(livenessStep > 10000){
             cout << "Liveness step failure" << endl;
@@ -828,6 +948,7 @@ public:
 		}
 		lastInstruction = i;
 		currentInstruction = i;
+		coverInstruction(i);
 		if ((i & 0x3) == 0x3) {
 			//32 bit
 			switch (i & 0x7F) {
@@ -1076,8 +1197,10 @@ public:
 					}
 					uint32_t csrAddress = i32_csr;
 					uint32_t old;
-					if(csrRead(i32_csr, &old)) { ilegalInstruction();return; }
-					if(write) if(csrWrite(i32_csr, (csrReadToWriteOverride(i32_csr, old) & ~clear) | set)) { ilegalInstruction();return; }
+					uint64_t csrBin = (csrAddress << 8) | (i32_func3 << 2) | (write << 1);
+					if(csrRead(i32_csr, &old)) { cover(COVER_CSR, csrBin | 1); ilegalInstruction();return; }
+					if(write) if(csrWrite(i32_csr, (csrReadToWriteOverride(i32_csr, old) & ~clear) | set)) { cover(COVER_CSR, csrBin | 1); ilegalInstruction();return; }
+					cover(COVER_CSR, csrBin);
 					rfWrite(rd32, old);
 					pcWrite(pc + 4);
 				}
@@ -1295,6 +1418,10 @@ public:
 	static mutex staticMutex;
 	static uint32_t testsCounter, successCounter;
 	static uint64_t cycles;
+	static map<string, pair<uint64_t, uint64_t>> perfRefs;
+	static map<string, map<uint64_t, uint64_t>> coverageTests;
+	static set<string> skippedTests;
+	static uint64_t setupTime, modelTime, setupCount;
 	uint64_t instanceCycles = 0;
 	vector<SimElement*> simElements;
 	Memory mem;
@@ -1303,6 +1430,8 @@ public:
 	uint64_t mTimeCmp = 0;
 	uint64_t mTime = 0;
 	VVexRiscv* top;
+	bool modelReused = false;
+	uint64_t setupStart;
 	bool resetDone = false;
 	bool riscvRefEnable = false;
 	uint64_t i;
@@ -1310,6 +1439,11 @@ public:
 	double allowedCycles = 0.0;
 	uint32_t bootPc = -1;
 	uint32_t iStall = STALL,dStall = STALL;
+	uint32_t debugPluginPort = DEBUG_PLUGIN_PORT; // 0 binds a free port, written back by the DebugPlugin
+	uint32_t dCacheRefills = 0;
+	uint32_t iCacheRefills = 0;
+	uint64_t instret = 0;
+	bool traceCheck = true;
 	#ifdef TRACE
 	VerilatedFstC* tfp;
 	#endif
@@ -1344,6 +1478,16 @@ public:
     		bool error;
     	};
 
+        // Memory writes since the last sampled lockstep checkpoint, undone to replay its window
+        struct Undo {
+            uint32_t address, size;
+            uint8_t data[8];
+        };
+        vector<Undo> undoLog;
+        bool undoEnable = false;
+        uint64_t lockstepCycle = 0;
+        bool lockstepInWfi = false;
+
         uint32_t periphWriteTimer = 0;
     	queue<MemWrite> periphWritesGolden;
     	queue<MemWrite> periphWrites;
@@ -1355,6 +1499,34 @@ public:
 
     	virtual void fail() { ws->fail(); }
 
+        // Copy everything but the memory
+        void copyState(CpuRef &that){
+            RiscvGolden::operator=(that);
+            periphWriteTimer = that.periphWriteTimer;
+            periphWritesGolden = that.periphWritesGolden;
+            periphWrites = that.periphWrites;
+            periphRead = that.periphRead;
+            rfWriteValid = that.rfWriteValid;
+            rfWriteAddress = that.rfWriteAddress;
+            rfWriteData = that.rfWriteData;
+            lockstepCycle = that.lockstepCycle;
+            lockstepInWfi = that.lockstepInWfi;
+        }
+
+        void rewind(CpuRef &checkpoint){
+            for(auto undo = undoLog.rbegin();undo != undoLog.rend();undo++) mem.write(undo->address, undo->size, undo->data);
+            undoLog.clear();
+            copyState(checkpoint);
+        }
+
+        // Account the liveness of the DUT cycles up to the given one
+        void livenessUntil(uint64_t cycle){
+            #ifdef CSR
+            if(cycle > lockstepCycle) liveness(lockstepInWfi, cycle - lockstepCycle);
+            #endif
+            lockstepCycle = max(lockstepCycle, cycle);
+        }
+
 
 	    virtual bool isMmuRegion(uint32_t v) {return ws->isMmuRegion(v);}
 
@@ -1371,6 +1543,11 @@ public:
 
         virtual bool iRead(int32_t address, uint32_t *data){
         	bool error;
+        	if(ws->lockstepSampled){
+        	    //The DUT memory is ahead of the golden model, so it fetches from its own copy
+        	    mem.read(address, 4, (uint8_t*)data);
+        	    return false;
+        	}
         	ws->iBusAccess(address, data, &error);
 //    		ws->iBusAccessPatch(address,data,&error);
     		return error;
@@ -1407,6 +1584,13 @@ public:
             	cout << "Ref did a unaligned write" << endl;
 
     		if(!ws->isPerifRegion(address)){
+    			if(undoEnable){
+    			    Undo undo;
+    			    undo.address = address;
+    			    undo.size = min(size, 8);
+    			    mem.read(address, undo.size, undo.data);
+    			    undoLog.push_back(undo);
+    			}
     			mem.write(address, size, data);
     		}
     		if(ws->isDBusCheckedRegion(address)){
@@ -1456,6 +1640,240 @@ public:
     };
 
 	CpuRef riscvRef = CpuRef(this);
+
+	// Sampled lockstep : the golden model runs in its own thread from the commit stream of the DUT, and only compares
+	// a hash every lockstepSampling instructions. The hash covers the PC and register file write of each instruction and
+	// the register file at the end of the window. On a missmatch the golden model rewinds to the start of the window
+	// and replays it with the per instruction checks to report the first divergence.
+	enum LockstepEventKind {LOCKSTEP_IP, LOCKSTEP_INTERRUPT, LOCKSTEP_STEP, LOCKSTEP_EXCEPTION, LOCKSTEP_PERIPH_READ, LOCKSTEP_PERIPH_WRITE};
+	struct LockstepEvent{
+		uint8_t kind;
+		bool flag;         // inWfi or the register file write valid
+		uint32_t address;  // interrupt code or the register file write address
+		uint32_t pc, data; // data is the ipInput or the register file write data
+		uint64_t cycle;
+	};
+	struct LockstepWindow{
+		vector<LockstepEvent> events;
+		vector<CpuRef::MemRead> reads;
+		vector<CpuRef::MemWrite> writes;
+		uint64_t instretStart, instretEnd;
+		uint64_t hash;
+		bool last;
+	};
+	uint64_t lockstepSampling = 0;
+	bool lockstepSampled = false;
+	LockstepWindow lockstepWindow;
+	uint32_t lockstepIpInput = 0;
+	bool lockstepInWfi = false;
+	deque<LockstepWindow> lockstepWindows;
+	mutex lockstepMutex;
+	condition_variable lockstepCondition;
+	bool lockstepStop = false, lockstepFailed = false;
+	thread lockstepThread;
+
+	Workspace* withSampledLockstep(uint64_t period){
+		lockstepSampling = period;
+		return this;
+	}
+
+	void checkCommit(uint32_t pc, bool rfWriteValid, int32_t rfWriteAddress, int32_t rfWriteData){
+		if(pc != riscvRef.lastPc){
+			cout << hex << " pc missmatch " << pc << " should be " << riscvRef.lastPc << dec << endl;
+			fail();
+		}
+		if(rfWriteValid != riscvRef.rfWriteValid ||
+			(rfWriteValid && (rfWriteAddress!= riscvRef.rfWriteAddress || rfWriteData!= riscvRef.rfWriteData))){
+			cout << "regFile write missmatch :" << endl;
+			if(rfWriteValid) cout << " REF: RF[" << riscvRef.rfWriteAddress << "] = 0x" << hex << riscvRef.rfWriteData << dec << endl;
+			if(rfWriteValid) cout << " DUT: RF[" << rfWriteAddress << "] = 0x" << hex << rfWriteData << dec << endl;
+			fail();
+		}
+	}
+
+	static const uint64_t lockstepHashInit = 0xcbf29ce484222325ull;
+	static uint64_t lockstepHash(uint64_t hash, uint32_t value){
+		for(int b = 0;b < 4;b++){
+			hash ^= (value >> b*8) & 0xFF;
+			hash *= 0x100000001b3ull;
+		}
+		return hash;
+	}
+	static uint64_t lockstepHash(uint64_t hash, uint32_t pc, bool rfWriteValid, uint32_t rfWriteAddress, uint32_t rfWriteData){
+		hash = lockstepHash(hash, pc);
+		if(rfWriteValid) hash = lockstepHash(lockstepHash(hash, rfWriteAddress), rfWriteData);
+		return hash;
+	}
+
+	void lockstepPush(uint8_t kind, bool flag, uint32_t address, uint32_t pc, uint32_t data){
+		lockstepWindow.events.push_back({kind, flag, address, pc, data, instanceCycles + 1});
+	}
+
+	void lockstepSend(bool last){
+		lockstepWindow.instretEnd = instret;
+		lockstepWindow.last = last;
+		unique_lock<mutex> lock(lockstepMutex);
+		lockstepCondition.wait(lock, [&]{ return lockstepWindows.size() < 4 || lockstepFailed; });
+		if(lockstepFailed) fail();
+		lockstepWindows.push_back(std::move(lockstepWindow));
+		lockstepCondition.notify_all();
+		lockstepWindow = LockstepWindow();
+		lockstepWindow.instretStart = instret;
+		lockstepWindow.hash = lockstepHashInit;
+	}
+
+	// Called on each DUT retired instruction, the register file write isn't yet in RegFilePlugin_regFile
+	void lockstepCommit(){
+		VVexRiscv_VexRiscv *cpu = top->VexRiscv;
+		bool rfWriteValid = cpu->lastStageRegFileWrite_valid && cpu->lastStageRegFileWrite_payload_address != 0;
+		lockstepPush(LOCKSTEP_STEP, rfWriteValid, cpu->lastStageRegFileWrite_payload_address, cpu->lastStagePc, cpu->lastStageRegFileWrite_payload_data);
+		lockstepWindow.hash = lockstepHash(lockstepWindow.hash, cpu->lastStagePc, rfWriteValid, cpu->lastStageRegFileWrite_payload_address, cpu->lastStageRegFileWrite_payload_data);
+		if(instret - lockstepWindow.instretStart < lockstepSampling) return;
+		for(int i = 1;i < 32;i++){
+			bool written = rfWriteValid && cpu->lastStageRegFileWrite_payload_address == i;
+			lockstepWindow.hash = lockstepHash(lockstepWindow.hash, written ? cpu->lastStageRegFileWrite_payload_data : cpu->RegFilePlugin_regFile[i]);
+		}
+		lockstepSend(false);
+	}
+
+	// Return the hash of the window as seen by the golden model
+	uint64_t lockstepReplay(LockstepWindow &window, bool check){
+		uint64_t hash = lockstepHashInit;
+		size_t readPtr = 0, writePtr = 0;
+		for(LockstepEvent &e : window.events){
+			switch(e.kind){
+			case LOCKSTEP_IP:
+				riscvRef.livenessUntil(e.cycle - 1);
+				riscvRef.ipInput = e.data;
+				riscvRef.lockstepInWfi = e.flag;
+				break;
+			case LOCKSTEP_INTERRUPT:
+				riscvRef.livenessUntil(e.cycle);
+				riscvRef.trap(true, e.address);
+				break;
+			case LOCKSTEP_STEP:
+				riscvRef.livenessUntil(e.cycle);
+				riscvRef.dutRfWriteValue = e.data;
+				riscvRef.step();
+				if(check) checkCommit(e.pc, e.flag, e.address, e.data);
+				hash = lockstepHash(hash, riscvRef.lastPc, riscvRef.rfWriteValid, riscvRef.rfWriteAddress, riscvRef.rfWriteData);
+				break;
+			case LOCKSTEP_EXCEPTION:
+				riscvRef.livenessUntil(e.cycle);
+				riscvRef.step();
+				break;
+			case LOCKSTEP_PERIPH_READ: riscvRef.periphRead.push(window.reads[readPtr++]); break;
+			case LOCKSTEP_PERIPH_WRITE: riscvRef.periphWrites.push(window.writes[writePtr++]); break;
+			}
+		}
+		for(int i = 1;i < 32;i++) hash = lockstepHash(hash, riscvRef.regs[i]);
+		return hash;
+	}
+
+	// Golden model thread, the last window has no hash and is always replayed with the per instruction checks
+	void lockstepRun(){
+		CpuRef checkpoint(this);
+		while(true){
+			LockstepWindow window;
+			{
+				unique_lock<mutex> lock(lockstepMutex);
+				lockstepCondition.wait(lock, [&]{ return !lockstepWindows.empty() || lockstepStop; });
+				if(lockstepWindows.empty()) return;
+				window = std::move(lockstepWindows.front());
+				lockstepWindows.pop_front();
+				lockstepCondition.notify_all();
+			}
+
+			bool replay = window.last;
+			if(!replay){
+				checkpoint.copyState(riscvRef);
+				riscvRef.undoLog.clear();
+				riscvRef.undoEnable = true;
+				try {
+					replay = lockstepReplay(window, false) != window.hash;
+				} catch (const std::exception& e) {
+					replay = true;
+				}
+				riscvRef.undoEnable = false;
+				if(replay){
+					cout << "Sampled lockstep missmatch in the instructions " << window.instretStart << " to " << window.instretEnd << ", replay them in lockstep" << endl;
+					riscvRef.rewind(checkpoint);
+				}
+			}
+			if(replay){
+				try {
+					if(lockstepReplay(window, true) != window.hash && !window.last){
+						cout << "Register file missmatch at the instruction " << window.instretEnd << endl;
+						fail();
+					}
+				} catch (const std::exception& e) {
+					unique_lock<mutex> lock(lockstepMutex);
+					lockstepFailed = true;
+					lockstepCondition.notify_all();
+					return;
+				}
+			}
+		}
+	}
+
+	// Wait on the golden model to check the instructions already retired, or discard them
+	void lockstepJoin(bool drain){
+		if(!lockstepThread.joinable()) return;
+		{
+			unique_lock<mutex> lock(lockstepMutex);
+			if(!drain) lockstepWindows.clear();
+			lockstepStop = true;
+			lockstepCondition.notify_all();
+		}
+		lockstepThread.join();
+	}
+
+	// Memory consistency scan : every MEMORY_SCAN cycles, the 4 KiB pages written in the DUT or golden model memory
+	// since the previous scan are compared. The DUT stores aren't synchronous with their retirement, so a difference is
+	// only reported when the same word still holds the same values on the next scan.
+	struct MemoryScanSuspect{
+		uint32_t address, dutValue, refValue;
+		uint64_t since;
+	};
+	map<uint32_t, MemoryScanSuspect> memoryScanSuspects;
+	uint64_t memoryScanLast = 0;
+
+	void memoryScan(){
+		set<uint32_t> pages;
+		for(auto &suspect : memoryScanSuspects) pages.insert(suspect.first);
+		for(Memory *memory : {&mem, &riscvRef.mem}){
+			for(uint32_t idx = 0;idx < memory->dirty.size();idx++){
+				for(uint64_t bits = memory->dirty[idx];bits;bits &= bits - 1){
+					pages.insert((idx << 18) | (__builtin_ctzll(bits) << 12));
+				}
+				memory->dirty[idx] = 0;
+			}
+		}
+
+		for(uint32_t page : pages){
+			uint32_t *dut = (uint32_t*)mem.get(page), *ref = (uint32_t*)riscvRef.mem.get(page);
+			if(memcmp(dut, ref, 4096) == 0){
+				memoryScanSuspects.erase(page);
+				continue;
+			}
+			uint32_t word = 0;
+			while(dut[word] == ref[word]) word++;
+			MemoryScanSuspect suspect = {page + word*4, dut[word], ref[word], memoryScanLast};
+			auto previous = memoryScanSuspects.find(page);
+			if(previous != memoryScanSuspects.end()){
+				MemoryScanSuspect &p = previous->second;
+				if(p.address == suspect.address && p.dutValue == suspect.dutValue && p.refValue == suspect.refValue){
+					cout << hex << "Memory missmatch at 0x" << p.address << " DUT=0x" << p.dutValue << " REF=0x" << p.refValue << dec;
+					cout << ", written between the cycles " << p.since << " and " << memoryScanLast << endl;
+					fail();
+				}
+				suspect.since = p.since;
+			}
+			memoryScanSuspects[page] = suspect;
+		}
+		memoryScanLast = instanceCycles;
+	}
+
     string vcdName;
     Workspace* setVcdName(string name){
         vcdName = name;
@@ -1467,11 +1885,25 @@ public:
 	    //srand48(seed);
     //    setIStall(false);
    //     setDStall(false);
+		setupStart = thread_time();
 		staticMutex.lock();
 		testsCounter++;
 		staticMutex.unlock();
 		this->name = name;
+		uint64_t modelStart = thread_time();
+		#if defined(MODEL_POOL) && !defined(TRACE)
+		if(!modelPool().empty()){
+			top = modelPool().back();
+			modelPool().pop_back();
+			modelReused = true;
+		} else
+		#endif
 		top = new VVexRiscv;
+		// Before the test constructors, which may set some registers of their own
+		if(modelReused) randomizeModel();
+		staticMutex.lock();
+		modelTime += thread_time() - modelStart;
+		staticMutex.unlock();
 		#ifdef TRACE_ACCESS
 			regTraces.open (name + ".regTrace");
 			memTraces.open (name + ".memTrace");
@@ -1483,7 +1915,15 @@ public:
 	}
 
 	virtual ~Workspace(){
+		uint64_t modelStart = thread_time();
+		#if defined(MODEL_POOL) && !defined(TRACE)
+		modelPool().push_back(top);
+		#else
 		delete top;
+		#endif
+		staticMutex.lock();
+		modelTime += thread_time() - modelStart;
+		staticMutex.unlock();
 		#ifdef TRACE
 		delete tfp;
 		#endif
@@ -1493,6 +1933,27 @@ public:
 		}
 	}
 
+	// Verilated models are slow to build, with MODEL_POOL they are reused by the following tests of the same thread.
+	// They aren't traceable twice, so TRACE disables it.
+	struct ModelPool : public vector<VVexRiscv*> {
+		~ModelPool(){ for(VVexRiscv* model : *this) delete model; }
+	};
+	static ModelPool& modelPool(){
+		static thread_local ModelPool pool;
+		return pool;
+	}
+
+	// A reused model starts from the state of the previous test. The reset of the CPU and the flush of its caches don't
+	// depend on it, but the register file is randomized again from the test name, to not depend on the tests order.
+	void randomizeModel(){
+		uint32_t state = 2166136261u;
+		for(char c : name) state = (state ^ uint8_t(c)) * 16777619u;
+		for(int i = 0;i < 32;i++){
+			state ^= state << 13; state ^= state >> 17; state ^= state << 5;
+			top->VexRiscv->RegFilePlugin_regFile[i] = state;
+		}
+	}
+
 	Workspace* loadHex(string path){
 		loadHexImpl(path,&mem);
 		loadHexImpl(path,&riscvRef.mem);
@@ -1560,6 +2021,7 @@ public:
 				for(uint32_t b = 0;b < size;b++){
                     *mem.get(addr + b) = ((uint8_t*)data)[b];
 				}
+				mem.markDirty(addr);
 
 			}else{
                 uint32_t innerOffset = addr & (DBUS_LOAD_DATA_WIDTH/8-1);
@@ -1578,7 +2040,12 @@ public:
 				for(uint32_t b = 0;b < size;b++){
 				    w.data42[b] = data[b];
 				}
-				riscvRef.periphWrites.push(w);
+				if(lockstepSampled) {
+				    lockstepWindow.writes.push_back(w);
+				    lockstepPush(LOCKSTEP_PERIPH_WRITE, false, 0, 0, 0);
+				} else {
+				    riscvRef.periphWrites.push(w);
+				}
 			}
 		} else {
 			if(isPerifRegion(addr)){
@@ -1589,7 +2056,12 @@ public:
 				    r.data42[b] = data[b];
 				}
 				r.error = *error;
-				riscvRef.periphRead.push(r);
+				if(lockstepSampled) {
+				    lockstepWindow.reads.push_back(r);
+				    lockstepPush(LOCKSTEP_PERIPH_READ, false, 0, 0, 0);
+				} else {
+				    riscvRef.periphRead.push(r);
+				}
 			}
 		}
 	}
@@ -1613,7 +2085,15 @@ public:
 
 	virtual void postReset() {}
 	virtual void checks(){}
-	virtual void pass(){ throw success();}
+	virtual void pass(){
+		if(lockstepSampled){
+			lockstepSend(true);
+			lockstepJoin(true);
+			if(lockstepFailed) fail();
+		}
+		checkPerformance();
+		throw success();
+	}
 	virtual void fail(){ throw std::exception();}
     virtual void fillSimELements();
 	void dump(uint64_t i){
@@ -1627,9 +2107,126 @@ public:
 	}
 
 	uint64_t privilegeCounters[4] = {0,0,0,0};
+
+	// Benchmark regions, measured from the previous start (or from the reset) to their end
+	struct BenchRegion{
+		string name;
+		uint64_t cycles, instret;
+	};
+	vector<BenchRegion> benchRegions;
+	uint64_t benchRegionCycles = 0, benchRegionInstret = 0;
+	uint32_t benchRegionId = 0;
+
+	// Latency from the rise of the timer interrupt line to the interrupt jump
+	bool timerInterruptPending = false;
+	uint64_t timerInterruptAt = 0;
+	uint64_t irqCount = 0, irqLatencySum = 0, irqLatencyMax = 0;
+
+	virtual string benchRegionName(uint32_t id){ return "region" + to_string(id); }
+	void benchRegionStart(uint32_t id){
+		benchRegionId = id;
+		benchRegionCycles = instanceCycles;
+		benchRegionInstret = instret;
+	}
+	void benchRegionEnd(string name){
+		benchRegions.push_back({name, instanceCycles - benchRegionCycles, instret - benchRegionInstret});
+	}
+
+	// One JSON object per line, to be collected by the benchmark runners
+	void printBenchStats(){
+		cout << "BENCH_STATS {\"test\": \"" << name << "\", \"cycles\": " << instanceCycles << ", \"instret\": " << instret;
+		cout << ", \"cpi\": " << (instret ? double(instanceCycles)/instret : 0.0);
+		cout << ", \"iCacheRefills\": " << iCacheRefills << ", \"dCacheRefills\": " << dCacheRefills;
+		cout << ", \"irqCount\": " << irqCount << ", \"irqLatencyMax\": " << irqLatencyMax;
+		cout << ", \"irqLatencyAvg\": " << (irqCount ? double(irqLatencySum)/irqCount : 0.0) << ", \"regions\": {";
+		for(size_t idx = 0;idx < benchRegions.size();idx++){
+			BenchRegion &r = benchRegions[idx];
+			cout << (idx ? ", " : "") << "\"" << r.name << "\": {\"cycles\": " << r.cycles << ", \"instret\": " << r.instret << "}";
+		}
+		cout << "}}" << endl;
+	}
+
+	// Load the expected cycles of each test, one "name cycles" or "name minCycles maxCycles" line per test
+	static void loadPerfRefs(string path){
+		ifstream file(path);
+		if(!file.is_open()){
+			cout << "Can't open the performance reference " << path << endl;
+			exit(1);
+		}
+		string line;
+		while(getline(file, line)){
+			istringstream fields(line);
+			string testName;
+			uint64_t min, max;
+			if(!(fields >> testName >> min)) continue;
+			if(!(fields >> max)) max = min;
+			perfRefs[testName] = make_pair(min, max);
+		}
+	}
+
+	// Accumulate the golden model coverage of a passing test, the REDO runs of a test are merged together
+	void mergeCoverage(){
+		#ifdef COVERAGE
+		if(!riscvRefEnable) return;
+		map<uint64_t, uint64_t> &test = coverageTests[name];
+		for(auto &bin : riscvRef.coverage) test[bin.first] += bin.second;
+		#endif
+	}
+
+	// Write one "bin hits" file per test and their union in merged.cov
+	static void writeCoverage(string directory){
+		map<string, uint64_t> merged;
+		for(auto &test : coverageTests){
+			ofstream file(directory + "/" + test.first + ".cov");
+			for(auto &bin : test.second){
+				string binName = RiscvGolden::coverageBinName(bin.first);
+				file << binName << " " << bin.second << endl;
+				merged[binName] += bin.second;
+			}
+		}
+		ofstream file(directory + "/merged.cov");
+		for(auto &bin : merged) file << bin.first << " " << bin.second << endl;
+		cout << "COVERAGE " << merged.size() << " bins hit by " << coverageTests.size() << " tests" << endl;
+	}
+
+	// Tests listed in the file (one name per line) are not run, used to run a minimized regression
+	static void loadSkippedTests(string path){
+		ifstream file(path);
+		if(!file.is_open()){
+			cout << "Can't open the skipped tests list " << path << endl;
+			exit(1);
+		}
+		string testName;
+		while(file >> testName) skippedTests.insert(testName);
+	}
+
+	// Fail the tests which ran out of their expected cycles band, widened by the tolerance.
+	// The randomly stalled tests aren't checked, their cycles depend on the random generator state shared by the threads.
+	void checkPerformance(){
+		#ifdef PERF_REF
+		if(iStall || dStall) return;
+		auto ref = perfRefs.find(name);
+		if(ref == perfRefs.end()) return;
+		if(instanceCycles > ref->second.second*(1+PERF_TOLERANCE)){
+			cout << "performance regression: " << instanceCycles << " cycles vs " << ref->second.second << endl;
+			fail();
+		}
+		if(instanceCycles < ref->second.first*(1-PERF_TOLERANCE)){
+			cout << "performance improvement, the reference should be updated: " << instanceCycles << " cycles vs " << ref->second.first << endl;
+			fail();
+		}
+		#endif
+	}
+
 	Workspace* run(uint64_t timeout = 5000){
 //		cout << "Start " << name << endl;
 		if(timeout == 0) timeout = 0x7FFFFFFFFFFFFFFF;
+		if(skippedTests.count(name)){
+			staticMutex.lock();
+			testsCounter--;
+			staticMutex.unlock();
+			return this;
+		}
 
 		currentTime = 4;
 		// init trace dump
@@ -1679,6 +2276,17 @@ public:
         for(int i = 1;i < 32;i++){
             riscvRef.regs[i] = top->VexRiscv->RegFilePlugin_regFile[i];
         }
+        if(riscvRefEnable && lockstepSampling != 0){
+            lockstepSampled = true;
+            lockstepWindow.instretStart = instret;
+            lockstepWindow.hash = lockstepHashInit;
+            lockstepThread = thread(&Workspace::lockstepRun, this);
+        }
+        #ifdef MEMORY_SCAN
+        //Only the writes done by the simulation are scanned
+        mem.dirty.clear();
+        riscvRef.mem.dirty.clear();
+        #endif
 		resetDone = true;
 
 		#ifdef  REF
@@ -1700,6 +2308,11 @@ public:
 		#endif
 
 
+        staticMutex.lock();
+        setupTime += thread_time() - setupStart;
+        setupCount++;
+        staticMutex.unlock();
+
         bool failed = false;
 		try {
 			// run simulation for 100 clock periods
@@ -1726,6 +2339,8 @@ public:
 				#ifdef TIMER_INTERRUPT
 				top->timerInterrupt = mTime >= mTimeCmp ? 1 : 0;
 				//if(mTime == mTimeCmp) printf("SIM timer tick\n");
+				if(top->timerInterrupt && !timerInterruptPending) timerInterruptAt = instanceCycles;
+				timerInterruptPending = top->timerInterrupt;
 				#endif
 
 
@@ -1749,26 +2364,47 @@ public:
 
 				#ifdef CSR
 				    if(riscvRefEnable) {
-                        riscvRef.ipInput = 0;
+                        uint32_t ipInput = 0;
     #ifdef TIMER_INTERRUPT
-                        riscvRef.ipInput |= top->timerInterrupt << 7;
+                        ipInput |= top->timerInterrupt << 7;
     #endif
     #ifdef EXTERNAL_INTERRUPT
-                        riscvRef.ipInput |= top->externalInterrupt << 11;
+                        ipInput |= top->externalInterrupt << 11;
     #endif
     #ifdef CSR
-                        riscvRef.ipInput |= top->softwareInterrupt << 3;
+                        ipInput |= top->softwareInterrupt << 3;
     #endif
     #ifdef SUPERVISOR
-    //					riscvRef.ipInput |= top->timerInterruptS << 5;
-                        riscvRef.ipInput |= top->externalInterruptS << 9;
+    //					ipInput |= top->timerInterruptS << 5;
+                        ipInput |= top->externalInterruptS << 9;
     #endif
 
-                        riscvRef.liveness(top->VexRiscv->CsrPlugin_inWfi);
-                        if(top->VexRiscv->CsrPlugin_interruptJump){
-                            if(riscvRefEnable) riscvRef.trap(true, top->VexRiscv->CsrPlugin_interrupt_code);
+                        if(lockstepSampled) {
+                            bool inWfi = top->VexRiscv->CsrPlugin_inWfi;
+                            if(ipInput != lockstepIpInput || inWfi != lockstepInWfi){
+                                lockstepIpInput = ipInput;
+                                lockstepInWfi = inWfi;
+                                lockstepPush(LOCKSTEP_IP, inWfi, 0, 0, ipInput);
+                            }
+                            if(top->VexRiscv->CsrPlugin_interruptJump){
+                                lockstepPush(LOCKSTEP_INTERRUPT, false, top->VexRiscv->CsrPlugin_interrupt_code, 0, 0);
+                            }
+                        } else {
+                            riscvRef.ipInput = ipInput;
+                            riscvRef.liveness(top->VexRiscv->CsrPlugin_inWfi);
+                            if(top->VexRiscv->CsrPlugin_interruptJump){
+                                riscvRef.trap(true, top->VexRiscv->CsrPlugin_interrupt_code);
+                            }
                         }
                     }
+                    #ifdef TIMER_INTERRUPT
+                    if(top->VexRiscv->CsrPlugin_interruptJump && top->VexRiscv->CsrPlugin_interrupt_code == 7 && timerInterruptPending){
+                        uint64_t latency = instanceCycles - timerInterruptAt;
+                        irqCount++;
+                        irqLatencySum += latency;
+                        if(latency > irqLatencyMax) irqLatencyMax = latency;
+                    }
+                    #endif
 				#endif
 
                 #ifdef RVF
@@ -1802,7 +2438,8 @@ public:
 
 
                 if(top->VexRiscv->lastStageIsFiring){
-                   	if(riscvRefEnable) {
+                    instret++;
+                   	if(riscvRefEnable && !lockstepSampled) {
 //                        privilegeCounters[riscvRef.privilege]++;
 //                        if((riscvRef.stepCounter & 0xFFFFF) == 0){
 //                            cout << "privilege report" << endl;
@@ -1816,12 +2453,6 @@ public:
                    	    bool mIntExt = false;
                    	}
 
-                   	if(riscvRefEnable && top->VexRiscv->lastStagePc != riscvRef.lastPc){
-						cout << hex << " pc missmatch " << top->VexRiscv->lastStagePc << " should be " << riscvRef.lastPc << dec << endl;
-						fail();
-					}
-
-
                 	bool rfWriteValid = false;
                 	int32_t rfWriteAddress;
                 	int32_t rfWriteData;
@@ -1846,18 +2477,18 @@ public:
                                  " PC " << hex << setw(8) <<  top->VexRiscv->lastStagePc << dec << endl;
                         #endif
                     }
-					if(riscvRefEnable) if(rfWriteValid != riscvRef.rfWriteValid ||
-						(rfWriteValid && (rfWriteAddress!= riscvRef.rfWriteAddress || rfWriteData!= riscvRef.rfWriteData))){
-                    	cout << "regFile write missmatch :" << endl;
-                    	if(rfWriteValid) cout << " REF: RF[" << riscvRef.rfWriteAddress << "] = 0x" << hex << riscvRef.rfWriteData << dec << endl;
-                    	if(rfWriteValid) cout << " DUT: RF[" << rfWriteAddress << "] = 0x" << hex << rfWriteData << dec << endl;
-                    	fail();
-                    }
+					if(lockstepSampled) {
+					    lockstepCommit();
+					} else if(riscvRefEnable) {
+					    checkCommit(top->VexRiscv->lastStagePc, rfWriteValid, rfWriteAddress, rfWriteData);
+					}
                 }
 
                 #ifdef CSR
                     if(top->VexRiscv->CsrPlugin_hadException){
-                        if(riscvRefEnable) {
+                        if(lockstepSampled) {
+                            lockstepPush(LOCKSTEP_EXCEPTION, false, 0, 0, 0);
+                        } else if(riscvRefEnable) {
                             riscvRef.step();
                         }
                     }
@@ -1874,6 +2505,10 @@ public:
 
 				instanceCycles += 1;
 
+				#ifdef MEMORY_SCAN
+				if(riscvRefEnable && !lockstepSampled && instanceCycles % MEMORY_SCAN == 0) memoryScan();
+				#endif
+
 				for(SimElement* simElement : simElements) simElement->postCycle();
 				#ifdef RVF
 				top->fpuCmdHalt = VL_RANDOM_I_WIDTH(1);
@@ -1891,10 +2526,21 @@ public:
 		} catch (const success e) {
 			staticMutex.lock();
 			cout <<"SUCCESS " << name <<  endl;
+			#ifdef DCACHE_STATS
+			cout << "DCACHE_STATS " << name << " refills=" << dCacheRefills << " instret=" << instret << " mpki=" << (instret ? 1000.0*dCacheRefills/instret : 0.0) << " cycles=" << instanceCycles << endl;
+			#endif
+			#ifdef BENCH_STATS
+			printBenchStats();
+			#endif
+			#ifdef PERF_RECORD
+			if(!iStall && !dStall) cout << "PERF_REF " << name << " " << instanceCycles << endl;
+			#endif
+			mergeCoverage();
 			successCounter++;
 			cycles += instanceCycles;
 			staticMutex.unlock();
 		} catch (const std::exception& e) {
+			lockstepJoin(false);
 			staticMutex.lock();
 
 			cout << "FAIL " <<  name << " at PC=" << hex << setw(8) << top->VexRiscv->lastStagePc << dec; //<<  " seed : " << seed <<
@@ -1982,7 +2628,8 @@ public:
 			#endif
 			case 0xF00FFF48u: mTimeCmp = (mTimeCmp & 0xFFFFFFFF00000000) | *data;break;
 			case 0xF00FFF4Cu: mTimeCmp = (mTimeCmp & 0x00000000FFFFFFFF) | (((uint64_t)*data) << 32); break;
-			case 0xF00FFF50u: cout << "mTime " << *data << " : " << mTime << endl;
+			case 0xF00FFF50u: cout << "mTime " << *data << " : " << mTime << endl; break;
+			case 0xF00FFF54u: if(*data) benchRegionStart(*data); else benchRegionEnd(benchRegionName(benchRegionId)); break;
 			}
 			if((addr & 0xFFFFF000) == 0xF5670000){
 			    uint32_t t = 0x900FF000 | (addr & 0xFFF);
@@ -2043,6 +2690,341 @@ public:
 };
 
 
+#if defined(CSR) && !defined(CSR_SKIP_TEST)
+#define RANDOM_PROGRAM_EXCEPTIONS
+#endif
+
+// Constrained random program, generated straight in the simulation memories. The body mixes ALU, MUL/DIV, branch,
+// load/store, CSR and trapping instructions, with their RVC forms on RVC configurations. It only branches forward, so
+// it always ends. With the MMU, the body runs in supervisor mode, with the code identity mapped by a superpage and the
+// data behind two pages of random permissions. The trap handler skips the trapping instruction.
+// x2 is the data pointer, x29 the exit flag, x30 and x31 are used by the trap handler, the other registers are random.
+class RandomProgramGenerator{
+public:
+	enum PatchKind {PATCH_NONE, PATCH_B, PATCH_JAL, PATCH_PCREL_I, PATCH_CB, PATCH_CJ};
+	struct Instruction{
+		uint32_t bits;
+		uint32_t size;
+		PatchKind patch;
+		uint32_t target; // Index of the targeted instruction, PATCH_PCREL_I is relative to the previous instruction (auipc)
+	};
+
+	static const uint32_t codeBase = 0x80000000, handlerBase = 0x80010000;
+	static const uint32_t dataBase = 0x80100000, pageTableBase = 0x80200000;
+	#ifdef MMU
+	static const uint32_t dataVirtualBase = 0x90000000;
+	#else
+	static const uint32_t dataVirtualBase = dataBase;
+	#endif
+
+	mt19937 rand;
+	vector<Instruction> code, handler;
+	vector<pair<uint32_t, uint32_t>> words;
+
+	RandomProgramGenerator(uint32_t seed) : rand(seed) {}
+
+	static uint32_t rType(uint32_t funct7, uint32_t rs2, uint32_t rs1, uint32_t funct3, uint32_t rd, uint32_t opcode){ return (funct7 << 25) | (rs2 << 20) | (rs1 << 15) | (funct3 << 12) | (rd << 7) | opcode; }
+	static uint32_t iType(int32_t imm, uint32_t rs1, uint32_t funct3, uint32_t rd, uint32_t opcode){ return ((imm & 0xFFF) << 20) | (rs1 << 15) | (funct3 << 12) | (rd << 7) | opcode; }
+	static uint32_t sType(int32_t imm, uint32_t rs2, uint32_t rs1, uint32_t funct3){ return (((imm >> 5) & 0x7F) << 25) | (rs2 << 20) | (rs1 << 15) | (funct3 << 12) | ((imm & 0x1F) << 7) | 0x23; }
+	static uint32_t bType(int32_t imm, uint32_t rs2, uint32_t rs1, uint32_t funct3){ return (((imm >> 12) & 1) << 31) | (((imm >> 5) & 0x3F) << 25) | (rs2 << 20) | (rs1 << 15) | (funct3 << 12) | (((imm >> 1) & 0xF) << 8) | (((imm >> 11) & 1) << 7) | 0x63; }
+	static uint32_t jType(int32_t imm, uint32_t rd){ return (((imm >> 20) & 1) << 31) | (((imm >> 1) & 0x3FF) << 21) | (((imm >> 11) & 1) << 20) | (((imm >> 12) & 0xFF) << 12) | (rd << 7) | 0x6F; }
+	static uint32_t ciType(uint32_t funct3, int32_t imm, uint32_t rd, uint32_t op){ return (funct3 << 13) | (((imm >> 5) & 1) << 12) | (rd << 7) | ((imm & 0x1F) << 2) | op; }
+	static uint32_t cjType(uint32_t funct3, int32_t imm){ return (funct3 << 13) | (((imm >> 11) & 1) << 12) | (((imm >> 4) & 1) << 11) | (((imm >> 8) & 3) << 9) | (((imm >> 10) & 1) << 8) | (((imm >> 6) & 1) << 7) | (((imm >> 7) & 1) << 6) | (((imm >> 1) & 7) << 3) | (((imm >> 5) & 1) << 2) | 1; }
+	static uint32_t cbType(uint32_t funct3, int32_t imm, uint32_t rs1){ return (funct3 << 13) | (((imm >> 8) & 1) << 12) | (((imm >> 3) & 3) << 10) | ((rs1 - 8) << 7) | (((imm >> 6) & 3) << 5) | (((imm >> 1) & 3) << 3) | (((imm >> 5) & 1) << 2) | 1; }
+
+	uint32_t random(uint32_t count){ return rand() % count; }
+	bool chance(double rate){ return (rand() & 0xFFFF) < rate*0x10000; }
+	uint32_t randomRd(){ uint32_t r = 1 + random(27); return r == 2 ? 28 : r; }
+	uint32_t randomRs(){ return random(32); }
+	uint32_t randomCompressedReg(){ return 8 + random(8); }
+	int32_t randomValue(){
+		switch(random(8)){
+		case 0: return 0;
+		case 1: return 1;
+		case 2: return -1;
+		case 3: return INT32_MIN;
+		case 4: return INT32_MAX;
+		}
+		return rand();
+	}
+
+	void emit(vector<Instruction> &list, uint32_t bits, PatchKind patch = PATCH_NONE, uint32_t target = 0){
+		list.push_back({bits, (bits & 3) == 3 ? 4u : 2u, patch, target});
+	}
+	void li(vector<Instruction> &list, uint32_t rd, int32_t value){
+		int32_t lo = int32_t(uint32_t(value) << 20) >> 20;
+		uint32_t upper = (uint32_t(value) - uint32_t(lo)) & 0xFFFFF000;
+		if(upper){
+			emit(list, upper | (rd << 7) | 0x37);
+			if(lo) emit(list, iType(lo, rd, 0, rd, 0x13));
+		} else {
+			emit(list, iType(lo, 0, 0, rd, 0x13));
+		}
+	}
+
+	// Index of an instruction a few slots ahead, clamped on the end sequence once the body is generated
+	uint32_t forwardTarget(uint32_t index){ return index + 2 + random(6); }
+
+	void alu(){
+		uint32_t rd = randomRd(), rs1 = randomRs(), rs2 = chance(0.1) ? rs1 : randomRs();
+		#ifdef COMPRESSED
+		if(chance(0.3)){
+			uint32_t crd = randomCompressedReg(), crs2 = randomCompressedReg();
+			int32_t imm = int32_t(rand()) >> 26;
+			switch(random(10)){
+			case 0: emit(code, ciType(0, imm ? imm : 1, rd, 1)); break; //C.ADDI
+			case 1: emit(code, ciType(2, imm, rd, 1)); break; //C.LI
+			case 2: emit(code, ciType(3, imm ? imm : 1, rd, 1)); break; //C.LUI
+			case 3: emit(code, ciType(0, 1 + random(31), rd, 2)); break; //C.SLLI
+			case 4: emit(code, ciType(4, 1 + random(31), crd - 8, 1) | (random(2) << 10)); break; //C.SRLI C.SRAI
+			case 5: emit(code, ciType(4, imm, crd - 8, 1) | (2 << 10)); break; //C.ANDI
+			case 6: emit(code, (0x4 << 13) | (3 << 10) | ((crd - 8) << 7) | (random(4) << 5) | ((crs2 - 8) << 2) | 1); break; //C.SUB C.XOR C.OR C.AND
+			case 7: emit(code, (0x4 << 13) | (rd << 7) | ((rs2 ? rs2 : 1) << 2) | 2); break; //C.MV
+			case 8: emit(code, (0x4 << 13) | (1 << 12) | (rd << 7) | ((rs2 ? rs2 : 1) << 2) | 2); break; //C.ADD
+			case 9: { //C.ADDI4SPN
+				uint32_t imm = (1 + random(255)) << 2;
+				emit(code, (((imm >> 4) & 3) << 11) | (((imm >> 6) & 0xF) << 7) | (((imm >> 2) & 1) << 6) | (((imm >> 3) & 1) << 5) | ((crd - 8) << 2));
+			} break;
+			}
+			return;
+		}
+		#endif
+		switch(random(5)){
+		case 0: case 1: { //Register register
+			static const uint32_t ops[][2] = {{0,0},{0x20,0},{0,1},{0,2},{0,3},{0,4},{0,5},{0x20,5},{0,6},{0,7}};
+			uint32_t op = random(10);
+			emit(code, rType(ops[op][0], rs2, rs1, ops[op][1], rd, 0x33));
+		} break;
+		case 2: { //Register immediate
+			uint32_t funct3 = random(8);
+			if(funct3 == 1 || funct3 == 5){
+				emit(code, rType(funct3 == 5 && random(2) ? 0x20 : 0, random(32), rs1, funct3, rd, 0x13));
+			} else {
+				emit(code, iType(randomValue(), rs1, funct3, rd, 0x13));
+			}
+		} break;
+		case 3: emit(code, (rand() & 0xFFFFF000) | (rd << 7) | (random(2) ? 0x37 : 0x17)); break; //LUI AUIPC
+		case 4: li(code, rd, randomValue()); break; //Corner values
+		}
+	}
+
+	void mulDiv(){
+		uint32_t funct3 = 0;
+		#if defined(MUL) && defined(DIV)
+		funct3 = random(8);
+		#elif defined(MUL)
+		funct3 = random(4);
+		#elif defined(DIV)
+		funct3 = 4 + random(4);
+		#endif
+		uint32_t rs1 = randomRs();
+		emit(code, rType(1, chance(0.1) ? rs1 : randomRs(), rs1, funct3, randomRd(), 0x33));
+	}
+
+	void loadStore(){
+		static const uint32_t loads[] = {0, 1, 2, 4, 5};
+		bool store = random(2);
+		uint32_t funct3 = store ? random(3) : loads[random(5)];
+		uint32_t size = 1 << (funct3 & 3);
+		int32_t offset = int32_t(random(4096)) - 2048;
+		#ifdef COMPRESSED
+		if(chance(0.3)){
+			uint32_t uoffset = random(64) << 2;
+			if(store) emit(code, (6 << 13) | (((uoffset >> 2) & 0xF) << 9) | (((uoffset >> 6) & 3) << 7) | (randomRs() << 2) | 2); //C.SWSP
+			else emit(code, (2 << 13) | (((uoffset >> 5) & 1) << 12) | (randomRd() << 7) | (((uoffset >> 2) & 7) << 4) | (((uoffset >> 6) & 3) << 2) | 2); //C.LWSP
+			return;
+		}
+		#endif
+		bool aligned = true;
+		#ifdef RANDOM_PROGRAM_EXCEPTIONS
+		aligned = !chance(0.05);
+		#endif
+		if(aligned) offset &= ~(size-1);
+		if(store) emit(code, sType(offset, randomRs(), 2, funct3));
+		else emit(code, iType(offset, 2, funct3, randomRd(), 0x03));
+	}
+
+	void branch(){
+		uint32_t index = code.size(), target = forwardTarget(index);
+		uint32_t rs1 = randomRs(), rs2 = chance(0.2) ? rs1 : randomRs();
+		#ifdef COMPRESSED
+		if(chance(0.3)){
+			switch(random(3)){
+			case 0: emit(code, cbType(6 + random(2), 0, randomCompressedReg()), PATCH_CB, target); break; //C.BEQZ C.BNEZ
+			case 1: emit(code, cjType(5, 0), PATCH_CJ, target); break; //C.J
+			case 2: emit(code, cjType(1, 0), PATCH_CJ, target); break; //C.JAL
+			}
+			return;
+		}
+		#endif
+		static const uint32_t funct3s[] = {0, 1, 4, 5, 6, 7};
+		switch(random(4)){
+		case 0: case 1: emit(code, bType(0, rs2, rs1, funct3s[random(6)]), PATCH_B, target); break;
+		case 2: emit(code, jType(0, random(2) ? randomRd() : 0), PATCH_JAL, target); break;
+		case 3: { //AUIPC + JALR
+			uint32_t base = randomRd();
+			emit(code, (base << 7) | 0x17);
+			emit(code, iType(0, base, 0, random(2) ? randomRd() : 0, 0x67), PATCH_PCREL_I, target);
+		} break;
+		}
+	}
+
+	void csr(){
+		vector<uint32_t> csrs = {0x340}; //MSCRATCH
+		#ifdef SUPERVISOR
+		csrs.push_back(0x140); //SSCRATCH
+		#endif
+		#ifdef RANDOM_PROGRAM_EXCEPTIONS
+		csrs.push_back(0x8FF); //Not implemented
+		#endif
+		static const uint32_t funct3s[] = {1, 2, 3, 5, 6, 7};
+		emit(code, iType(csrs[random(csrs.size())], chance(0.2) ? 0 : randomRs(), funct3s[random(6)], randomRd(), 0x73));
+	}
+
+	void trap(){
+		#ifdef RANDOM_PROGRAM_EXCEPTIONS
+		if(random(2)){
+			emit(code, 0xFFFFFFFF); //Illegal instruction
+			return;
+		}
+		#endif
+		emit(code, 0x00000073); //ECALL
+	}
+
+	void generate(uint32_t length){
+		//Random data
+		for(uint32_t offset = 0;offset < 0x2000;offset += 4) words.push_back(make_pair(dataBase + offset, uint32_t(rand())));
+
+		//Prologue
+		#ifdef CSR
+		li(code, 30, handlerBase);
+		emit(code, iType(0x305, 30, 1, 0, 0x73)); //MTVEC
+		li(code, 30, randomValue());
+		emit(code, iType(0x340, 30, 1, 0, 0x73)); //MSCRATCH, its reset value is undefined
+		#ifdef SUPERVISOR
+		li(code, 30, randomValue());
+		emit(code, iType(0x140, 30, 1, 0, 0x73)); //SSCRATCH
+		#endif
+		#endif
+		for(uint32_t reg = 1;reg < 32;reg++) li(code, reg, reg == 29 ? 0 : randomValue());
+		li(code, 2, dataVirtualBase + 0x1000);
+		#ifdef MMU
+		//Root table, the code is identity mapped by a superpage, the data are behind a second level table
+		static const uint32_t permissions[] = {0xC7, 0xC7, 0xC7, 0x43, 0x87, 0x47, 0x00, 0xD7, 0x49};
+		words.push_back(make_pair(pageTableBase + ((codeBase >> 22) << 2), ((codeBase >> 12) << 10) | 0xCF));
+		words.push_back(make_pair(pageTableBase + ((dataVirtualBase >> 22) << 2), (((pageTableBase + 0x1000) >> 12) << 10) | 0x01));
+		for(uint32_t page = 0;page < 2;page++){
+			words.push_back(make_pair(pageTableBase + 0x1000 + (((dataVirtualBase >> 12) & 0x3FF) + page)*4, (((dataBase >> 12) + page) << 10) | permissions[random(9)]));
+		}
+		li(code, 30, 0x80000000 | (pageTableBase >> 12));
+		emit(code, iType(0x180, 30, 1, 0, 0x73)); //SATP
+		emit(code, 0x12000073); //SFENCE.VMA
+		li(code, 30, 0x800 | (random(4) << 18)); //MPP=S, random SUM MXR
+		emit(code, iType(0x300, 30, 1, 0, 0x73)); //MSTATUS
+		uint32_t mepcIndex = code.size();
+		emit(code, (30 << 7) | 0x17);
+		emit(code, iType(0, 30, 0, 30, 0x13), PATCH_PCREL_I, 0);
+		emit(code, iType(0x341, 30, 1, 0, 0x73)); //MEPC
+		emit(code, 0x30200073); //MRET
+		code[mepcIndex + 1].target = code.size();
+		#endif
+
+		//Body, the slot count is an upper bound for the branch targets as some slots emit two instructions
+		uint32_t bodyStart = code.size();
+		uint32_t bodyEnd = bodyStart + length;
+		while(code.size() < bodyEnd){
+			uint32_t kind = random(100);
+			if(kind < 45) alu();
+			#if defined(MUL) || defined(DIV)
+			else if(kind < 55) mulDiv();
+			#endif
+			else if(kind < 75) loadStore();
+			else if(kind < 90) branch();
+			#ifdef CSR
+			else if(kind < 96) csr();
+			else trap();
+			#endif
+		}
+		//Never jump on the JALR of an AUIPC + JALR pair, its AUIPC is targeted instead
+		for(Instruction &instruction : code){
+			instruction.target = min(instruction.target, uint32_t(code.size()));
+			if(instruction.target < code.size() && code[instruction.target].patch == PATCH_PCREL_I) instruction.target--;
+		}
+
+		//End, through the trap handler when there is one
+		#ifdef CSR
+		li(code, 29, 1);
+		emit(code, 0x00000073);
+		#else
+		li(code, 30, 0xF00FFF20);
+		emit(code, sType(0, 0, 30, 2));
+		#endif
+		emit(code, jType(0, 0));
+
+		//Trap handler, skip the trapping instruction
+		emit(handler, bType(0, 0, 29, 1), PATCH_B, 10); //BNEZ x29, exit
+		emit(handler, iType(0x341, 0, 2, 30, 0x73)); //CSRR x30, MEPC
+		emit(handler, iType(0, 30, 5, 31, 0x03)); //LHU x31, 0(x30)
+		emit(handler, iType(3, 31, 7, 31, 0x13)); //ANDI x31, x31, 3
+		emit(handler, iType(4, 30, 0, 30, 0x13)); //ADDI x30, x30, 4
+		emit(handler, iType(-3, 31, 0, 31, 0x13)); //ADDI x31, x31, -3
+		emit(handler, bType(0, 0, 31, 0), PATCH_B, 8); //BEQZ x31, 1f
+		emit(handler, iType(-2, 30, 0, 30, 0x13)); //ADDI x30, x30, -2
+		emit(handler, iType(0x341, 30, 1, 0, 0x73)); //1: CSRW MEPC, x30
+		emit(handler, 0x30200073); //MRET
+		li(handler, 30, 0xF00FFF20); //exit:
+		emit(handler, sType(0, 0, 30, 2));
+		emit(handler, jType(0, 0));
+	}
+
+	static void assemble(vector<Instruction> &list, uint32_t base, vector<uint8_t> &bytes){
+		vector<uint32_t> addresses;
+		uint32_t address = base;
+		for(Instruction &instruction : list){
+			addresses.push_back(address);
+			address += instruction.size;
+		}
+		addresses.push_back(address);
+		for(uint32_t idx = 0;idx < list.size();idx++){
+			Instruction &instruction = list[idx];
+			int32_t offset = addresses[instruction.target] - addresses[idx];
+			uint32_t bits = instruction.bits;
+			switch(instruction.patch){
+			case PATCH_NONE: break;
+			case PATCH_B: bits |= bType(offset, 0, 0, 0) & ~0x7F; break;
+			case PATCH_JAL: bits |= jType(offset, 0) & ~0x7F; break;
+			case PATCH_PCREL_I: bits |= iType(addresses[instruction.target] - addresses[idx - 1], 0, 0, 0, 0); break;
+			case PATCH_CB: bits |= cbType(0, offset, 8) & 0x1C7C; break;
+			case PATCH_CJ: bits |= cjType(0, offset) & 0x1FFC; break;
+			}
+			for(uint32_t byte = 0;byte < instruction.size;byte++) bytes.push_back(bits >> byte*8);
+		}
+	}
+
+	void writeTo(Memory &mem){
+		vector<uint8_t> bytes;
+		assemble(code, codeBase, bytes);
+		mem.write(codeBase, bytes.size(), bytes.data());
+		bytes.clear();
+		assemble(handler, handlerBase, bytes);
+		mem.write(handlerBase, bytes.size(), bytes.data());
+		for(auto &word : words) mem.write(word.first, 4, (uint8_t*)&word.second);
+	}
+};
+
+class RandomProgram : public WorkspaceRegression{
+public:
+	RandomProgram(uint32_t seed, uint32_t length) : WorkspaceRegression("random_" + to_string(seed)) {
+		RandomProgramGenerator generator(seed);
+		generator.generate(length);
+		generator.writeTo(mem);
+		generator.writeTo(riscvRef.mem);
+		withRiscvRef();
+		bootAt(RandomProgramGenerator::codeBase);
+	}
+};
+
+
 
 
 
@@ -2232,6 +3214,7 @@ public:
 	bool error_next = false;
 	uint32_t pendingCount = 0;
 	uint32_t address;
+	uint32_t lineBase, lineSize;
 
 	Workspace *ws;
 	VVexRiscv* top;
@@ -2249,8 +3232,11 @@ public:
 	virtual void preCycle(){
 		if (top->iBus_cmd_valid && top->iBus_cmd_ready && pendingCount == 0) {
 			assertEq((top->iBus_cmd_payload_address & 3),0);
+			ws->iCacheRefills++;
 			pendingCount = (1 << top->iBus_cmd_payload_size)/4;
 			address = top->iBus_cmd_payload_address;
+			lineSize = 1 << top->iBus_cmd_payload_size;
+			lineBase = address & ~(lineSize-1); //Wrapped bursts start at the critical word
 		}
 	}
 
@@ -2272,7 +3258,7 @@ public:
             }
 			top->iBus_rsp_payload_error = error;
 			pendingCount-=IBUS_DATA_WIDTH/32;
-			address = address + IBUS_DATA_WIDTH/8;
+			address = lineBase + ((address + IBUS_DATA_WIDTH/8 - lineBase) & (lineSize-1));
 			top->iBus_rsp_valid = 1;
 		}
 		if(ws->iStall) top->iBus_cmd_ready = VL_RANDOM_I_WIDTH(7) < 100 && pendingCount == 0;
@@ -2654,16 +3640,20 @@ public:
             } else {
                 bool error = false;
                 uint32_t beatCount = (((1 << top->dBus_cmd_payload_size)*8+DBUS_LOAD_DATA_WIDTH-1) / DBUS_LOAD_DATA_WIDTH)-1;
+                uint32_t size = 1 << top->dBus_cmd_payload_size;
                 uint32_t startAt = top->dBus_cmd_payload_address;
-                uint32_t endAt = top->dBus_cmd_payload_address + (1 << top->dBus_cmd_payload_size);
+                if(beatCount != 0) startAt &= ~(size-1); //Wrapped bursts start at the critical word
+                uint32_t endAt = startAt + size;
                 uint32_t address = top->dBus_cmd_payload_address & ~(DBUS_LOAD_DATA_WIDTH/8-1);
                 uint8_t buffer[64];
-                ws->dBusAccess(top->dBus_cmd_payload_address,0,1 << top->dBus_cmd_payload_size,buffer, &error);
+                if(!top->dBus_cmd_payload_uncached) ws->dCacheRefills++;
+                ws->dBusAccess(startAt,0,size,buffer, &error);
                 for(int beat = 0;beat <= beatCount;beat++){
                     for(int i = 0;i < DBUS_LOAD_DATA_WIDTH/8;i++){
-                        rsp.data[i] = (address >= startAt && address < endAt) ? buffer[address-top->dBus_cmd_payload_address] : VL_RANDOM_I_WIDTH(8);
+                        rsp.data[i] = (address >= startAt && address < endAt) ? buffer[address-startAt] : VL_RANDOM_I_WIDTH(8);
                         address += 1;
                     }
+                    if(address == endAt && beatCount != 0) address = startAt;
                     rsp.last = beat == beatCount;
                     #ifdef DBUS_EXCLUSIVE
                         if(top->dBus_cmd_payload_exclusive){
@@ -2782,9 +3772,10 @@ public:
 					beatCounter = 0;
 				}
 			} else {
+				uint32_t burstMask = top->dBusAvalon_burstCount*4-1; //Line wrap bursts start at the critical word
 				for(int beat = 0;beat < top->dBusAvalon_burstCount;beat++){
 					DBusCachedAvalonTask rsp;
-					ws->dBusAccess(top->dBusAvalon_address  + beat * 4 ,0,4,((uint8_t*)&rsp.data),&rsp.error);
+					ws->dBusAccess((top->dBusAvalon_address & ~burstMask) + ((top->dBusAvalon_address + beat * 4) & burstMask),0,4,((uint8_t*)&rsp.data),&rsp.error);
 					rsps.push(rsp);
 				}
 			}
@@ -2885,7 +3876,7 @@ public:
 		// Address family = Internet //
 		serverAddr.sin_family = AF_INET;
 		// Set port number, using htons function to use proper byte order //
-		serverAddr.sin_port = htons(7893);
+		serverAddr.sin_port = htons(ws->debugPluginPort);
 		// Set IP address to localhost //
 		serverAddr.sin_addr.s_addr = inet_addr("127.0.0.1");
 		// Set all bits of the padding field to 0 //
@@ -2893,6 +3884,8 @@ public:
 
 		//---- Bind the address struct to the socket ----//
 		bind(serverSocket, (struct sockaddr *) &serverAddr, sizeof(serverAddr));
+		socklen_t serverAddrSize = sizeof(serverAddr);
+		if(getsockname(serverSocket, (struct sockaddr *) &serverAddr, &serverAddrSize) == 0) ws->debugPluginPort = ntohs(serverAddr.sin_port);
 
 		//---- Listen on the socket, with 5 max connection requests queued ----//
 		listen(serverSocket,1);
@@ -3119,6 +4112,61 @@ public:
 };
 #endif
 
+#ifdef TRACE_ENCODER
+#include "../common/trace.h"
+
+// Rebuild the PC stream from the TracePlugin output and the memory content, and check it against lastStagePc
+class TraceChecker : public SimElement{
+public:
+	Workspace *ws;
+	VVexRiscv* top;
+	TraceDecoder decoder;
+	queue<uint32_t> retired;
+
+	TraceChecker(Workspace* ws) : decoder([ws](uint32_t address) { return (uint16_t)(ws->mem[address] | (ws->mem[address + 1] << 8)); }){
+		this->ws = ws;
+		this->top = ws->top;
+	}
+
+	virtual ~TraceChecker(){
+		#ifdef TRACE_STATS
+		if(decoder.decoded != 0) cout << "TRACE_STATS " << ws->name << " words=" << decoder.words << " checked=" << decoder.decoded << " bits/instruction=" << 32.0*decoder.words/decoder.decoded << endl;
+		#endif
+	}
+
+	virtual void onReset(){
+		top->trace_ready = 0;
+	}
+
+	virtual void preCycle(){
+		if(!ws->traceCheck) return;
+		if(top->VexRiscv->lastStageIsFiring) retired.push(top->VexRiscv->lastStagePc);
+		if(top->trace_valid && top->trace_ready) decoder.push(top->trace_payload);
+
+		uint32_t pc;
+		while(decoder.next(&pc)){
+			if(retired.empty()){
+				cout << "TRACE ahead of the CPU at " << hex << pc << dec << endl;
+				ws->fail();
+			}
+			if(pc != retired.front()){
+				cout << "TRACE missmatch " << hex << pc << " should be " << retired.front() << dec << endl;
+				ws->fail();
+			}
+			retired.pop();
+		}
+		if(decoder.error){
+			cout << "TRACE decoding error after " << hex << decoder.pc << dec << endl;
+			ws->fail();
+		}
+	}
+
+	virtual void postCycle(){
+		top->trace_ready = VL_RANDOM_I_WIDTH(7) < 100;
+	}
+};
+#endif
+
 void Workspace::fillSimELements(){
 	#ifdef IBUS_SIMPLE
 		simElements.push_back(new IBusSimple(this));
@@ -3177,11 +4225,18 @@ void Workspace::fillSimELements(){
         simElements.push_back(new Jtag(&top->jtag_tms, &top->jtag_tdi, &top->jtag_tdo, &top->jtag_tck, 4));
         simElements.push_back(new VexRiscvJtag(this));
     #endif
+	#ifdef TRACE_ENCODER
+		simElements.push_back(new TraceChecker(this));
+	#endif
 }
 
 mutex Workspace::staticMutex;
 uint64_t Workspace::cycles = 0;
+map<string, pair<uint64_t, uint64_t>> Workspace::perfRefs;
+map<string, map<uint64_t, uint64_t>> Workspace::coverageTests;
+set<string> Workspace::skippedTests;
 uint32_t Workspace::testsCounter = 0, Workspace::successCounter = 0;
+uint64_t Workspace::setupTime = 0, Workspace::modelTime = 0, Workspace::setupCount = 0;
 
 #ifndef REF
 #define testA1ReagFileWriteRef {1,10},{2,20},{3,40},{4,60}
@@ -3287,44 +4342,72 @@ public:
 	}
 };
 #endif
+// Reference output loaded once, and compared while the DUT produces it to fail at the first wrong byte
+class ReferenceOutput{
+public:
+	const string *ref;
+	string path;
+	size_t offset = 0;
+	bool missing = false;
+
+	ReferenceOutput(string path) : path(path) {
+		static map<string, string> cache;
+		static mutex cacheMutex;
+		lock_guard<mutex> guard(cacheMutex);
+		auto entry = cache.find(path);
+		if(entry == cache.end()){
+			ifstream file(path, ios::binary);
+			stringstream content;
+			if(file.is_open()) content << file.rdbuf();
+			else missing = true;
+			entry = cache.emplace(path, content.str()).first;
+		}
+		ref = &entry->second;
+		missing |= ref->empty();
+	}
+
+	// Return false at the first mismatch, after printing the surrounding context
+	bool push(char c){
+		if(offset >= ref->size()) return true;
+		if((*ref)[offset] == c) {
+			offset++;
+			return true;
+		}
+		size_t from = offset < 64 ? 0 : offset - 64;
+		cout << "Reference mismatch at byte " << offset << " of " << path << " : got 0x" << hex << (uint32_t)(uint8_t)c << " instead of 0x" << (uint32_t)(uint8_t)(*ref)[offset] << dec << endl;
+		cout << "Matching output :" << endl << ref->substr(from, offset - from) << endl;
+		cout << "Expected next :" << endl << ref->substr(offset, 64) << endl;
+		return false;
+	}
+
+	bool done(){
+		if(missing) cout << "Missing reference " << path << endl;
+		else if(offset < ref->size()) cout << "Output stopped at byte " << offset << " of the " << ref->size() << " of " << path << endl;
+		return !missing && offset >= ref->size();
+	}
+};
+
 class Dhrystone : public WorkspaceRegression{
 public:
-	string hexName;
-	Dhrystone(string name,string hexName,bool iStall, bool dStall) : WorkspaceRegression(name) {
+	ReferenceOutput reference;
+	Dhrystone(string name,string hexName,bool iStall, bool dStall) : WorkspaceRegression(name), reference(hexName + ".logRef") {
 		setIStall(iStall);
 		setDStall(dStall);
 		withRiscvRef();
 		loadHex(string(REGRESSION_PATH) + "../../resources/hex/" + hexName + ".hex");
-		this->hexName = hexName;
 	}
 
 	virtual void checks(){
 
 	}
 
+	virtual void dutPutChar(char c){
+		if(!reference.push(c)) fail();
+	}
+
 	virtual void pass(){
-		FILE *refFile = fopen((hexName + ".logRef").c_str(), "r");
-    	fseek(refFile, 0, SEEK_END);
-    	uint32_t refSize = ftell(refFile);
-    	fseek(refFile, 0, SEEK_SET);
-    	char* ref = new char[refSize];
-    	fread(ref, 1, refSize, refFile);
-    	fclose(refFile);
-    	
-
-    	logTraces.flush();
-    	logTraces.close();
-
-		FILE *logFile = fopen((name + ".logTrace").c_str(), "r");
-    	fseek(logFile, 0, SEEK_END);
-    	uint32_t logSize = ftell(logFile);
-    	fseek(logFile, 0, SEEK_SET);
-    	char* log = new char[logSize];
-    	fread(log, 1, logSize, logFile);
-    	fclose(logFile);
-    	
-    	if(refSize > logSize || memcmp(log,ref,refSize))
-    		fail();
+		if(!reference.done())
+			fail();
 		else
 			Workspace::pass();
 	}
@@ -3335,7 +4418,8 @@ public:
 	string name;
 	ofstream out32;
 	int out32Counter = 0;
-	Compliance(string name) : WorkspaceRegression(name) {
+	ReferenceOutput reference;
+	Compliance(string name) : WorkspaceRegression(name), reference(string(REGRESSION_PATH) + "../../resources/ref/" + name + ".reference_output") {
 		withRiscvRef();
 		loadHex(string(REGRESSION_PATH) + "../../resources/hex/" + name + ".elf.hex");
 		out32.open (name + ".out32");
@@ -3349,8 +4433,16 @@ public:
     virtual void dBusAccess(uint32_t addr,bool wr, uint32_t size, uint8_t *dataBytes, bool *error) {
         if(wr && addr == 0xF00FFF2C){
             uint32_t *data = (uint32_t*)dataBytes;
-            out32 << hex << setw(8) << std::setfill('0') << *data << dec;
-            if(++out32Counter % 4 == 0) out32 << "\n";
+            stringstream word;
+            word << hex << setw(8) << std::setfill('0') << *data;
+            if(++out32Counter % 4 == 0) word << "\n";
+            out32 << word.str();
+            for(char c : word.str()){
+                if(!reference.push(c)) {
+                    cout << "Bad compliance check" << endl;
+                    fail();
+                }
+            }
         }
     	WorkspaceRegression::dBusAccess(addr,wr,size,dataBytes,error);
     }
@@ -3362,27 +4454,8 @@ public:
 
 
 	virtual void pass(){
-		FILE *refFile = fopen((string(REGRESSION_PATH) + string("../../resources/ref/") + name + ".reference_output").c_str(), "r");
-    	fseek(refFile, 0, SEEK_END);
-    	uint32_t refSize = ftell(refFile);
-    	fseek(refFile, 0, SEEK_SET);
-    	char* ref = new char[refSize];
-    	fread(ref, 1, refSize, refFile);
-    	fclose(refFile);
-
-
-    	out32.flush();
     	out32.close();
-
-		FILE *logFile = fopen((name + ".out32").c_str(), "r");
-    	fseek(logFile, 0, SEEK_END);
-    	uint32_t logSize = ftell(logFile);
-    	fseek(logFile, 0, SEEK_SET);
-    	char* log = new char[logSize];
-    	fread(log, 1, logSize, logFile);
-    	fclose(logFile);
-
-    	if(refSize > logSize || memcmp(log,ref,refSize)){
+    	if(!reference.done()){
     	    cout << "Bad compliance check" << endl;
     		fail();
 		} else
@@ -3390,6 +4463,23 @@ public:
 	}
 };
 
+// memcpy/memset/strcmp kernels and timer interrupt round trips, each one measured as a benchmark region
+class Bench : public WorkspaceRegression{
+public:
+	Bench(string name) : WorkspaceRegression(name) {
+		withRiscvRef();
+		loadHex(string(REGRESSION_PATH) + "../raw/bench/build/bench.hex");
+		bootAt(0x80000000u);
+		#if defined(CSR) && defined(TIMER_INTERRUPT)
+		writeWord(0x80000004u, 1); //irq_enable
+		#endif
+	}
+
+	virtual string benchRegionName(uint32_t id){
+		const char* names[] = {"", "memcpy", "memset", "strcmp", "irq"};
+		return id < 5 ? names[id] : WorkspaceRegression::benchRegionName(id);
+	}
+};
 
 #ifdef DEBUG_PLUGIN
 
@@ -3467,7 +4557,7 @@ public:
 		// Address family = Internet //
 		serverAddr.sin_family = AF_INET;
 		// Set port number, using htons function to use proper byte order //
-		serverAddr.sin_port = htons(7893);
+		serverAddr.sin_port = htons(debugPluginPort);
 		// Set IP address to localhost //
 		serverAddr.sin_addr.s_addr = inet_addr("127.0.0.1");
 		// Set all bits of the padding field to 0 //
@@ -3546,12 +4636,30 @@ public:
 			clientFail = true; return;
 		}
 
+		#ifdef DEBUG_PLUGIN_MEMORY
+		//Stream a buffer through the auto incremented memory port, then read it back
+		writeCmd(2, debugAddress + 8, 0x80001000);
+		for(uint32_t i = 0;i < 256;i++) writeCmd(2, debugAddress + 12, i*0x01010101 ^ 0xA5A55A5A);
+		writeCmd(2, debugAddress + 8, 0x80001000);
+		for(uint32_t i = 0;i < 256;i++){
+			if((readValue = readCmd(2,debugAddress + 12)) != (i*0x01010101 ^ 0xA5A55A5A)){
+				printf("wrong memory word %d %x\n", i, readValue);
+				clientFail = true; return;
+			}
+		}
+		if((readValue = readCmd(2,debugAddress + 8)) != 0x80001400 || (readCmd(2,debugAddress) & 0x20)){
+			printf("wrong memory port state %x\n", readValue);
+			clientFail = true; return;
+		}
+		#endif
+
 
 		clientSuccess = true;
 	}
 
 
 	DebugPluginTest() : WorkspaceRegression("DebugPluginTest") {
+		traceCheck = false; //Injected instructions aren't in the binary
 		loadHex(string(REGRESSION_PATH) + "../../resources/hex/debugPlugin.hex");
 		 pthread_create(&clientThreadId, NULL, &clientThreadWrapper, this);
 	}
@@ -3573,6 +4681,132 @@ public:
 
 #endif
 
+#ifdef RISCV_DMI
+#include "dmi.h"
+
+class DmiDriver : public SimElement{
+public:
+	Workspace *ws;
+	VVexRiscv* top;
+	Dmi *dmi;
+
+	DmiDriver(Workspace* ws, Dmi *dmi){
+		this->ws = ws;
+		this->top = ws->top;
+		this->dmi = dmi;
+	}
+
+	virtual void onReset(){
+		top->dmi_cmd_valid = 0;
+	}
+
+	virtual void preCycle(){
+		dmi->cycle(top->dmi_cmd_valid && top->dmi_cmd_ready, top->dmi_rsp_valid, top->dmi_rsp_payload_error, top->dmi_rsp_payload_data);
+	}
+
+	virtual void postCycle(){
+		top->dmi_cmd_valid = dmi->cmdValid();
+		if(top->dmi_cmd_valid){
+			Dmi::Access &access = dmi->current();
+			top->dmi_cmd_payload_write = access.kind == Dmi::WRITE;
+			top->dmi_cmd_payload_address = access.address;
+			top->dmi_cmd_payload_data = access.data;
+		}
+	}
+};
+
+// Drive the official debug module directly through its DMI : halt, batched program download and readback, run to an ebreak, register dump
+class RiscvDmiTest : public WorkspaceRegression{
+public:
+	pthread_t clientThreadId;
+	Dmi dmi;
+	bool clientSuccess = false, clientFail = false;
+
+	static void* clientThreadWrapper(void *test){
+		try {
+			((RiscvDmiTest*)test)->clientThread();
+		} catch (const DmiAborted &e) {} //The test ended before the client
+		return NULL;
+	}
+
+	bool check(bool ok, const char *what){
+		if(!ok) {
+			printf("DMI %s failed\n", what);
+			clientFail = true;
+		}
+		return ok;
+	}
+
+	void clientThread(){
+		while(resetDone != true){
+			if(dmi.aborted) return;
+			usleep(100);
+		}
+
+		DmiDebugger debugger(&dmi);
+		if(!check(debugger.init(), "init")) return;
+		debugger.halt();
+
+		uint32_t dcsr;
+		if(!check(debugger.readRegister(DmiDebugger::DCSR, &dcsr), "dcsr read")) return;
+		if(!check(debugger.writeRegister(DmiDebugger::DCSR, dcsr | 1 << 15), "dcsr write")) return; //ebreakm
+
+		//Sum 100 down to 1 in a0, then ebreak
+		vector<uint32_t> program = {0x00000513, 0x06400593, 0x00b50533, 0xfff58593, 0xfe059ce3, 0x00100073};
+		vector<uint32_t> blob(1024), readback;
+		for(uint32_t &word : blob) word = VL_RANDOM_I_WIDTH(32);
+
+		struct timespec start = timer_get();
+		uint64_t startCycle = instanceCycles;
+		if(!check(debugger.writeMemory(0x80001000, program), "program download")) return;
+		if(!check(debugger.writeMemory(0x80002000, blob), "blob download")) return;
+		if(!check(debugger.readMemory(0x80002000, blob.size(), readback), "blob readback")) return;
+		if(!check(readback == blob, "blob compare")) return;
+		struct timespec end = timer_get();
+		printf("DMI %d words written and %d read in %ld us host time, %ld cycles, %ld DMI accesses, %s\n",
+			(int)(program.size() + blob.size()), (int)blob.size(),
+			(long)((end.tv_sec - start.tv_sec)*1000000 + (end.tv_nsec - start.tv_nsec)/1000),
+			(long)(instanceCycles - startCycle), (long)dmi.accessCount,
+			debugger.systemBus ? "system bus" : "program buffer");
+
+		if(!check(debugger.fenceI(), "fence.i")) return;
+		if(!check(debugger.writeRegister(DmiDebugger::DPC, 0x80001000), "dpc write")) return;
+		debugger.resume();
+		debugger.waitHalted();
+
+		vector<uint32_t> regnos, regs;
+		for(uint32_t i = 1;i < 32;i++) regnos.push_back(0x1000 + i);
+		if(!check(debugger.readRegisters(regnos, regs), "register dump")) return;
+		if(!check(regs[10-1] == 5050 && regs[11-1] == 0, "program result")) return;
+
+		uint32_t dpc;
+		if(!check(debugger.readRegister(DmiDebugger::DPC, &dpc), "dpc read")) return;
+		if(!check(dpc == 0x80001014, "ebreak dpc")) return;
+		if(!check(dmi.errors == 0, "DMI error free")) return;
+		clientSuccess = true;
+	}
+
+	RiscvDmiTest() : WorkspaceRegression("RiscvDmiTest") {
+		traceCheck = false;
+		writeWord(0x80000000, 0x0000006f); //j .
+		bootAt(0x80000000u);
+		simElements.push_back(new DmiDriver(this, &dmi));
+		pthread_create(&clientThreadId, NULL, &clientThreadWrapper, this);
+	}
+
+	//On timeout or failure the client may still wait on accesses, release it before the workspace is destroyed
+	virtual ~RiscvDmiTest(){
+		dmi.abort();
+		pthread_join(clientThreadId, NULL);
+	}
+
+	virtual void checks(){
+		if(clientSuccess) pass();
+		if(clientFail) fail();
+	}
+};
+#endif
+
 
 //#ifdef LITEX
 //class LitexSoC : public Workspace{
@@ -3680,6 +4914,9 @@ public:
     }
 
 	LinuxSoc(string name) : Workspace(name) {
+	    #if defined(LOCKSTEP_SAMPLING) && !defined(RVF) //The FPU queues aren't part of the commit stream
+	    withSampledLockstep(LOCKSTEP_SAMPLING);
+	    #endif
 	    #ifdef WITH_USER_IO
 		stdinNonBuffered();
 		captureCtrlC();
@@ -3762,7 +4999,7 @@ public:
     virtual void onStdout(char c){
         pendingLine += c;
         switch(state){
-        case LOGIN: if (pendingLineContain("buildroot login:")) { pushCin("root\n"); state = ECHO_FILE; } break;
+        case LOGIN: if (pendingLineContain("buildroot login:")) { benchRegionEnd("bootToPrompt"); pushCin("root\n"); state = ECHO_FILE; } break;
         case ECHO_FILE: if (pendingLineContain("# ")) { pushCin("echo \"miaou\" > test.txt\n"); state = HEXDUMP; pendingLine = "";} break;
         case HEXDUMP: if (pendingLineContain("# ")) { pushCin("hexdump -C test.txt\n"); state = HEXDUMP_CHECK; pendingLine = "";} break;
         case HEXDUMP_CHECK: if (pendingLineContain("00000000  6d 69 61 6f 75 0a  ")) { pushCin(""); state = PASS; pendingLine = "";} break;
@@ -4162,6 +5399,13 @@ int main(int argc, char **argv, char **env) {
 	printf("BOOT\n");
 	timespec startedAt = timer_start();
 
+	#ifdef PERF_REF
+	Workspace::loadPerfRefs(PERF_REF);
+	#endif
+	#ifdef TEST_SKIP
+	Workspace::loadSkippedTests(TEST_SKIP);
+	#endif
+
 
 #ifdef LINUX_SOC_SMP
     {
@@ -4377,9 +5621,15 @@ int main(int argc, char **argv, char **env) {
             #ifdef IBUS_CACHED
                 redo(REDO,WorkspaceRegression("icache").withRiscvRef()->loadHex(string(REGRESSION_PATH) + "../raw/icache/build/icache.hex")->bootAt(0x80000000u)->run(50e3););
             #endif
+            #ifdef ICACHE_LOCK
+                redo(REDO,WorkspaceRegression("icacheLock").loadHex(string(REGRESSION_PATH) + "../raw/icacheLock/build/icacheLock.hex")->bootAt(0x80000000u)->run(100e3););
+            #endif
             #ifdef DBUS_CACHED
                 redo(REDO,WorkspaceRegression("dcache").loadHex(string(REGRESSION_PATH) + "../raw/dcache/build/dcache.hex")->bootAt(0x80000000u)->run(2500e3););
             #endif
+            #ifdef CBO
+                redo(REDO,WorkspaceRegression("cbo").loadHex(string(REGRESSION_PATH) + "../raw/cbo/build/cbo.hex")->bootAt(0x80000000u)->run(50e3););
+            #endif
 
             #ifdef MMU
                 redo(REDO,WorkspaceRegression("mmu").withRiscvRef()->loadHex(string(REGRESSION_PATH) + "../raw/mmu/build/mmu.hex")->bootAt(0x80000000u)->run(50e3););
@@ -4393,6 +5643,9 @@ int main(int argc, char **argv, char **env) {
 				redo(REDO,DebugPluginTest().run(1e6););
             #endif
 			#endif
+			#ifdef RISCV_DMI
+				redo(REDO,RiscvDmiTest().run(1e6););
+			#endif
 		#endif
 
 		#ifdef CUSTOM_SIMD_ADD
@@ -4416,6 +5669,10 @@ int main(int argc, char **argv, char **env) {
 			redo(REDO,WorkspaceRegression("amo").withRiscvRef()->loadHex(string(REGRESSION_PATH) + "../raw/amo/build/amo.hex")->bootAt(0x00000000u)->run(10e3););
 		#endif
 
+		#ifdef VECTOR
+			redo(REDO,WorkspaceRegression("vector").loadHex(string(REGRESSION_PATH) + "../raw/vector/build/vector.hex")->bootAt(0x80000000u)->run(50e3););
+		#endif
+
         #ifdef RVF
         for(const string &name : riscvTestFloat){
             redo(REDO,RiscvTest(name).withRiscvRef()->bootAt(0x80000188u)->writeWord(0x80000184u, 0x00305073)->run();)
@@ -4427,6 +5684,17 @@ int main(int argc, char **argv, char **env) {
         }
         #endif
 
+		#ifdef RANDOM_PROGRAMS
+		{
+			queue <std::function<void()>> tasks;
+			for(uint32_t idx = 0;idx < RANDOM_PROGRAMS;idx++){
+				uint32_t seed = regressionSeed + idx;
+				tasks.push([=]() { RandomProgram(seed, RANDOM_PROGRAM_LENGTH).run(RANDOM_PROGRAM_LENGTH*100 + 50e3); });
+			}
+			multiThreadedExecute(tasks);
+		}
+		#endif
+
 		#ifdef DHRYSTONE
 			Dhrystone("dhrystoneO3_Stall","dhrystoneO3",true,true).run(1.5e6);
 			#if defined(COMPRESSED)
@@ -4450,6 +5718,11 @@ int main(int argc, char **argv, char **env) {
 			#endif
 		#endif
 
+        #ifdef BENCH
+            Bench("bench_stall").setIStall(true)->setDStall(true)->run(1e6);
+            Bench("bench_nostall").setIStall(false)->setDStall(false)->run(1e6);
+        #endif
+
         #ifdef COREMARK
             for(int withStall = 1; true ;withStall--){
                 string rv = "rv32i";
@@ -4562,9 +5835,16 @@ int main(int argc, char **argv, char **env) {
 
 	}
 
+	#ifdef COVERAGE
+	Workspace::writeCoverage(COVERAGE);
+	#endif
+
 	uint64_t duration = timer_end(startedAt);
 	cout << endl << "****************************************************************" << endl;
 	cout << "Had simulate " << Workspace::cycles << " clock cycles in " << duration*1e-9 << " s (" << Workspace::cycles / (duration*1e-6) << " Khz)" << endl;
+	#ifdef SETUP_STATS
+	if(Workspace::setupCount) cout << "SETUP_STATS " << Workspace::setupCount << " tests, setup " << Workspace::setupTime*1e-3/Workspace::setupCount << " us per test, model construction and destruction " << Workspace::modelTime*1e-3/Workspace::setupCount << " us per test" << endl;
+	#endif
 	if(Workspace::successCounter == Workspace::testsCounter)
 		cout << "REGRESSION SUCCESS " << Workspace::successCounter << "/" << Workspace::testsCounter << endl;
 	else
@@ -0,0 +1,64 @@
+// Offline decoder of a TracePlugin dump (little endian 32 bits words), print the retired PC stream
+// Usage : traceDecoder program.elf trace.bin
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <elf.h>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <vector>
+#include "../common/trace.h"
+
+using namespace std;
+
+static vector<uint8_t> readFile(const char *path){
+	ifstream file(path, ios::binary);
+	if(!file) {
+		cerr << "Can't open " << path << endl;
+		exit(1);
+	}
+	return vector<uint8_t>(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+}
+
+int main(int argc, char **argv){
+	if(argc != 3){
+		cerr << "Usage : " << argv[0] << " program.elf trace.bin" << endl;
+		return 1;
+	}
+
+	vector<uint8_t> elf = readFile(argv[1]);
+	Elf32_Ehdr *ehdr = (Elf32_Ehdr*) elf.data();
+	if(elf.size() < sizeof(Elf32_Ehdr) || memcmp(ehdr->e_ident, ELFMAG, SELFMAG) != 0 || ehdr->e_ident[EI_CLASS] != ELFCLASS32){
+		cerr << argv[1] << " isn't a 32 bits ELF" << endl;
+		return 1;
+	}
+
+	map<uint32_t, uint8_t> memory;
+	for(int i = 0;i < ehdr->e_phnum;i++){
+		Elf32_Phdr *phdr = (Elf32_Phdr*)(elf.data() + ehdr->e_phoff + i*ehdr->e_phentsize);
+		if(phdr->p_type != PT_LOAD) continue;
+		for(uint32_t b = 0;b < phdr->p_filesz;b++) memory[phdr->p_paddr + b] = elf[phdr->p_offset + b];
+	}
+
+	TraceDecoder decoder([&memory](uint32_t address) {
+		auto low = memory.find(address), high = memory.find(address + 1);
+		return (uint16_t)((low == memory.end() ? 0 : low->second) | (high == memory.end() ? 0 : high->second) << 8);
+	});
+
+	vector<uint8_t> trace = readFile(argv[2]);
+	uint32_t pc;
+	for(size_t i = 0;i + 3 < trace.size();i += 4){
+		decoder.push(trace[i] | trace[i+1] << 8 | trace[i+2] << 16 | trace[i+3] << 24);
+		while(decoder.next(&pc)) printf("%08x\n", pc);
+		if(decoder.error) {
+			cerr << "Decoding error after " << hex << decoder.pc << dec << endl;
+			return 1;
+		}
+	}
+
+	cerr << decoder.decoded << " instructions from " << decoder.words << " words, " << decoder.traps << " traps" << endl;
+	return 0;
+}
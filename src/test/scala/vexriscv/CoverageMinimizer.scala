@@ -0,0 +1,77 @@
+package vexriscv
+
+import java.io.File
+
+import org.apache.commons.io.FileUtils
+
+import scala.collection.mutable
+
+/**
+ * Select a minimal subset of the regression tests which keeps the golden model coverage of the full regression.
+ *
+ * The coverage directory is the one written by a full regression run with COVERAGE=<dir>, one <test>.cov file per
+ * passing test. Only the candidate tests (riscv-tests, compliance, FreeRTOS and Zephyr by default) can be dropped, the
+ * other tests always run and their bins are considered as covered. The selection is a greedy set cover followed by the
+ * removal of the redundant tests. It writes tier.txt with the selected candidates and skip.txt with the dropped ones,
+ * to be given to the regression with TEST_SKIP=<dir>/skip.txt. The coverage depends on the CPU configuration, so the
+ * lists are only valid for the configuration which generated them.
+ *
+ * Arguments :
+ * --coverage PATH       Coverage directory, default coverage
+ * --candidates REGEX    Names of the tests which can be dropped
+ */
+object CoverageMinimizer {
+  val defaultCandidates = "rv32u[icm]-p-.*|I-.*|C\\..*|MUL.*|DIV.*|REM.*|.*_O[03]|tests_.*"
+
+  def loadCoverage(directory : File) : Map[String, Set[String]] = {
+    val files = directory.listFiles().filter(f => f.getName.endsWith(".cov") && f.getName != "merged.cov")
+    files.map(f => f.getName.stripSuffix(".cov") -> FileUtils.readFileToString(f).split("\n").map(_.split(" ").head).filter(_.nonEmpty).toSet).toMap
+  }
+
+  // Return the selected candidates, in the order of the greedy selection
+  def minimize(candidates : Map[String, Set[String]], covered : Set[String]) : List[String] = {
+    val uncovered = mutable.HashSet[String]()
+    uncovered ++= candidates.values.flatten
+    uncovered --= covered
+    val selected = mutable.ArrayBuffer[String]()
+    while(uncovered.nonEmpty){
+      val (name, bins) = candidates.toList.filter(c => !selected.contains(c._1)).sortBy(_._1).maxBy(_._2.count(uncovered.contains))
+      selected += name
+      uncovered --= bins
+    }
+
+    //The greedy selection can leave tests whose bins were all picked up by the tests selected after them
+    for(name <- selected.reverse.toList){
+      val others = selected.filter(_ != name).flatMap(candidates(_)).toSet ++ covered
+      if(candidates(name).subsetOf(others)) selected -= name
+    }
+    selected.toList
+  }
+
+  def main(args: Array[String]) {
+    var coveragePath = "coverage"
+    var candidatesRegex = defaultCandidates
+
+    def parse(list : List[String]) : Unit = list match {
+      case "--coverage" :: value :: tail => coveragePath = value; parse(tail)
+      case "--candidates" :: value :: tail => candidatesRegex = value; parse(tail)
+      case Nil =>
+      case unknown :: _ => throw new Exception(s"Unknown argument $unknown")
+    }
+    parse(args.toList)
+
+    val directory = new File(coveragePath)
+    val coverage = loadCoverage(directory)
+    val (candidates, kept) = coverage.partition(_._1.matches(candidatesRegex))
+    val keptBins = kept.values.flatten.toSet
+    val selected = minimize(candidates, keptBins)
+    val skipped = candidates.keys.toList.sorted.filterNot(selected.contains)
+
+    println(s"${coverage.values.flatten.toSet.size} bins, ${kept.size} tests always run covering ${keptBins.size} of them")
+    for(name <- selected) println(s"  $name")
+    println(s"${selected.size} of the ${candidates.size} candidate tests keep the full coverage, ${skipped.size} skipped")
+
+    FileUtils.writeStringToFile(new File(directory, "tier.txt"), selected.map(_ + "\n").mkString)
+    FileUtils.writeStringToFile(new File(directory, "skip.txt"), skipped.map(_ + "\n").mkString)
+  }
+}
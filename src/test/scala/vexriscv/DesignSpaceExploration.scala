@@ -0,0 +1,181 @@
+package vexriscv
+
+import java.io.File
+import java.security.MessageDigest
+import java.util.concurrent.ForkJoinPool
+
+import org.apache.commons.io.FileUtils
+import org.yaml.snakeyaml.Yaml
+import spinal.core._
+import spinal.lib.eda.yosys.YosysNextpnrFlow
+
+import scala.collection.mutable
+import scala.concurrent.duration.Duration
+import scala.concurrent.{Await, ExecutionContext, Future}
+import scala.sys.process._
+import scala.util.Random
+
+/**
+ * Design space exploration over the TestIndividualFeatures dimensions.
+ *
+ * Random configurations are sampled as in the regression, each one is benchmarked (Dhrystone, Coremark) in verilator and
+ * synthesised with yosys + nextpnr. The results are cached in the cache directory by hash of the generated RTL and of the
+ * target, so a configuration is evaluated again when its RTL changes. The Pareto frontier of the Coremark/MHz against the LUT count is printed and written
+ * with all the results in the workspace.
+ *
+ * Arguments :
+ * --count N          Number of sampled configurations, default 20
+ * --seed N           Sampling seed, random by default
+ * --threads N        Concurrent evaluations, default 4
+ * --target NAME      ecp5 or ice40, default ecp5
+ * --rvc-rate R       Chance to sample a RVC configuration, default 0.5
+ * --workspace PATH   Workspace directory (directly under the repository root), default dseWorkspace
+ * --cache PATH       Results cache directory, default dseCache
+ */
+object DesignSpaceExploration {
+  case class Result(name : String, hash : String, dmipsPerMhz : Double, coremarkPerMhz : Double, luts : Int, ffs : Int, fmax : Double){
+    def fmaxMhz = BigDecimal(fmax / 1e6).setScale(2, BigDecimal.RoundingMode.HALF_UP)
+    def toJson = s"""{"name": "$name", "hash": "$hash", "dmipsPerMhz": $dmipsPerMhz, "coremarkPerMhz": $coremarkPerMhz, "luts": $luts, "ffs": $ffs, "fmax": $fmaxMhz}"""
+    def dominates(that : Result) = coremarkPerMhz >= that.coremarkPerMhz && luts <= that.luts && (coremarkPerMhz > that.coremarkPerMhz || luts < that.luts)
+  }
+
+  def hash(value : String) = MessageDigest.getInstance("SHA-1").digest(value.getBytes("UTF-8")).map("%02x".format(_)).mkString.take(16)
+
+  //Hash of the generated verilog and its memory initialisation files, without the generation date
+  def rtlHash(project : String, target : String) : String = {
+    val files = new File(project).listFiles().filter(_.getName.startsWith("VexRiscv.v")).sortBy(_.getName)
+    val rtl = files.map(f => f.getName + "\n" + FileUtils.readFileToString(f).split("\n").filterNot(_.startsWith("// Date")).mkString("\n"))
+    hash(rtl.mkString("\n") + " " + target)
+  }
+
+  def loadResult(file : File) : Result = {
+    val r = new Yaml().load(FileUtils.readFileToString(file)).asInstanceOf[java.util.Map[String, Any]]
+    Result(
+      name = r.get("name").toString,
+      hash = r.get("hash").toString,
+      dmipsPerMhz = r.get("dmipsPerMhz").toString.toDouble,
+      coremarkPerMhz = r.get("coremarkPerMhz").toString.toDouble,
+      luts = r.get("luts").toString.toInt,
+      ffs = r.get("ffs").toString.toInt,
+      fmax = r.get("fmax").toString.toDouble * 1e6
+    )
+  }
+
+  def paretoFrontier(results : Seq[Result]) : Seq[Result] = results.filter(r => !results.exists(_.dominates(r))).sortBy(_.luts)
+
+  def doCmd(cmd : String, path : String) : String = {
+    val stdOut = new StringBuilder()
+    val logger = ProcessLogger(s => stdOut ++= s + "\n", s => stdOut ++= s + "\n")
+    Process(cmd, new File(path)).!(logger)
+    stdOut.toString()
+  }
+
+  def generate(positions : List[VexRiscvPosition], universe : mutable.HashSet[VexRiscvUniverse], project : String) : Unit = {
+    FileUtils.deleteDirectory(new File(project))
+    FileUtils.forceMkdir(new File(project))
+    TestIndividualFeatures.generateRtl(positions, universe, project)
+  }
+
+  //The RTL has to be generated in the project first. Return None if the simulation or the synthesis failed
+  def evaluate(positions : List[VexRiscvPosition], name : String, key : String, project : String, family : YosysNextpnrFlow.Family, nextpnrArgs : Seq[String], frequencyTarget : HertzNumber) : Option[Result] = {
+    TestIndividualFeatures.setupRegressionWorkspace(project)
+
+    val testCmd = "make run REGRESSION_PATH=../../src/test/cpp/regression VEXRISCV_FILE=VexRiscv.v WITH_USER_IO=no REDO=1 TRACE=no DHRYSTONE=yes COREMARK=yes THREAD_COUNT=1 " + positions.map(_.testParam).mkString(" ")
+    val str = doCmd(testCmd, project)
+    if(!str.contains("REGRESSION SUCCESS")) {
+      println(s"$name simulation failed, see $project")
+      return None
+    }
+    val intFind = "(\\d+\\.?)+".r
+    val dmips = intFind.findFirstIn("DMIPS per Mhz\\:                              (\\d+.?)+".r.findAllIn(str).toList.last).get.toDouble
+    val coremarkTicks = intFind.findFirstIn("Total ticks      \\: (\\d+.?)+".r.findAllIn(str).toList.last).get.toDouble
+    val coremarkIterations = intFind.findFirstIn("Iterations       \\: (\\d+.?)+".r.findAllIn(str).toList.last).get.toDouble
+
+    val report = YosysNextpnrFlow(
+      workspacePath = s"$project/synthesis",
+      toplevelPath = s"$project/VexRiscv.v",
+      family = family,
+      nextpnrArgs = nextpnrArgs,
+      frequencyTarget = frequencyTarget
+    )
+    if(report.getLuts() < 0) {
+      println(s"$name synthesis failed, see $project/synthesis")
+      return None
+    }
+    Some(Result(name, key, dmips, 1e6 * coremarkIterations / coremarkTicks, report.getLuts(), report.getFfs(), report.getFMax()))
+  }
+
+  def main(args: Array[String]) {
+    var count = 20
+    var seed = Random.nextLong()
+    var threads = 4
+    var target = "ecp5"
+    var rvcRate = 0.5
+    var workspace = "dseWorkspace"
+    var cachePath = "dseCache"
+
+    def parse(list : List[String]) : Unit = list match {
+      case "--count" :: value :: tail => count = value.toInt; parse(tail)
+      case "--seed" :: value :: tail => seed = value.toLong; parse(tail)
+      case "--threads" :: value :: tail => threads = value.toInt; parse(tail)
+      case "--target" :: value :: tail => target = value; parse(tail)
+      case "--rvc-rate" :: value :: tail => rvcRate = value.toDouble; parse(tail)
+      case "--workspace" :: value :: tail => workspace = value; parse(tail)
+      case "--cache" :: value :: tail => cachePath = value; parse(tail)
+      case Nil =>
+      case unknown :: _ => throw new Exception(s"Unknown argument $unknown")
+    }
+    parse(args.toList)
+
+    val (family, nextpnrArgs, frequencyTarget) = target match {
+      case "ecp5" => (YosysNextpnrFlow.ecp5, List("--25k", "--package", "CABGA381", "--out-of-context"), 200 MHz)
+      case "ice40" => (YosysNextpnrFlow.ice40, List("--hx8k", "--package", "ct256", "--pcf-allow-unconstrained"), 100 MHz)
+      case _ =>
+        println(s"Unknown target $target, expected --target ecp5 or --target ice40")
+        sys.exit(1)
+    }
+
+    //The OS tests don't change the benchmarks, so they are disabled
+    println(s"Seed=$seed")
+    val rand = new Random(seed)
+    val dimensions = TestIndividualFeatures.dimensions(rvcRate, "0", "0", "no")
+    val rates = TestIndividualFeatures.UniverseRates()
+    val configs = for(i <- 0 until count) yield {
+      val universe = TestIndividualFeatures.randomUniverse(rand, rates)
+      val positions = TestIndividualFeatures.randomPositions(dimensions, universe, rand)
+      (positions, universe)
+    }
+
+    implicit val ec = ExecutionContext.fromExecutorService(
+      new ForkJoinPool(threads, ForkJoinPool.defaultForkJoinWorkerThreadFactory, null, true)
+    )
+    FileUtils.forceMkdir(new File(cachePath))
+    val names = mutable.HashSet[String]()
+    val uniqueConfigs = configs.filter(c => names.add(TestIndividualFeatures.configName(c._1, c._2)))
+    val futures = for((positions, universe) <- uniqueConfigs) yield Future {
+      val name = TestIndividualFeatures.configName(positions, universe)
+      val project = s"$workspace/${hash(name)}"
+      generate(positions, universe, project)
+      val key = rtlHash(project, target)
+      val cacheFile = new File(cachePath, s"$key.json")
+      if(cacheFile.exists()) {
+        Some(loadResult(cacheFile))
+      } else {
+        val result = evaluate(positions, name, key, project, family, nextpnrArgs, frequencyTarget)
+        result.foreach(r => FileUtils.writeStringToFile(cacheFile, r.toJson + "\n"))
+        result
+      }
+    }
+    val results = futures.flatMap(Await.result(_, Duration.Inf)).toList
+    ec.shutdown()
+
+    val frontier = paretoFrontier(results)
+    println(f"${"Hash"}%-16s ${"Coremark/MHz"}%12s ${"DMIPS/MHz"}%9s ${"LUT"}%6s ${"FF"}%6s ${"Fmax"}%8s  Configuration")
+    for(r <- frontier) println(f"${r.hash}%-16s ${r.coremarkPerMhz}%12.3f ${r.dmipsPerMhz}%9.3f ${r.luts}%6d ${r.ffs}%6d ${r.fmaxMhz}%8s  ${r.name}")
+    println(s"${frontier.size} Pareto optimal configurations out of ${results.size} evaluated (${configs.size - results.size} duplicated or failed)")
+
+    def toJson(list : Seq[Result]) = list.map("  " + _.toJson).mkString("[\n", ",\n", "\n]\n")
+    FileUtils.writeStringToFile(new File(workspace, "results.json"), toJson(results.sortBy(_.luts)))
+    FileUtils.writeStringToFile(new File(workspace, "pareto.json"), toJson(frontier))
+  }
+}
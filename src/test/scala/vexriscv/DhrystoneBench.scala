@@ -2,6 +2,7 @@ package vexriscv
 
 import java.io.File
 
+import org.apache.commons.io.FileUtils
 import org.scalatest.funsuite.AnyFunSuite
 import spinal.core.SpinalVerilog
 import vexriscv.demo._
@@ -18,7 +19,7 @@ class DhrystoneBench extends AnyFunSuite {
 
       override def out(s: => String): Unit = {
         println(s)
-        stdOut ++= s
+        stdOut ++= s + "\n"
       }
 
       override def buffer[T](f: => T) = f
@@ -29,6 +30,15 @@ class DhrystoneBench extends AnyFunSuite {
 
   val report = new StringBuilder()
 
+  //Each configuration also run the memcpy/memset/strcmp/interrupt bench and write all its tests stats as JSON in that directory
+  val resultsPath = sys.env.getOrElse("VEXRISCV_BENCH_RESULTS", "benchResults")
+  val linux = sys.env.getOrElse("VEXRISCV_BENCH_LINUX", "no") == "yes"
+
+  //Expected cycles bands of the benchmark tests, one file per configuration, checked by the simulation when it exists
+  val perfRefPath = "src/test/cpp/regression/perfRef"
+  val perfRecord = sys.env.getOrElse("VEXRISCV_BENCH_PERF_RECORD", "no") == "yes"
+  val perfTolerance = sys.env.getOrElse("VEXRISCV_BENCH_PERF_TOLERANCE", "0.02")
+
   def getDmips(name: String, gen: => Unit, testCmd: String): Unit = {
     var genPassed = false
     test(name + "_gen") {
@@ -37,7 +47,11 @@ class DhrystoneBench extends AnyFunSuite {
     }
     test(name + "_test") {
       assert(genPassed)
-      val str = doCmd(testCmd)
+      val perfRef = new File(perfRefPath, name + ".ref")
+      assert(perfRecord || perfRef.exists(), s"No cycle reference $perfRef, record it with VEXRISCV_BENCH_PERF_RECORD=yes")
+      //Without random stalls, so the cycles of a test are the same on every run
+      val perfArgs = if(perfRecord) " PERF_RECORD=yes NO_STALL=yes" else s" PERF_REF=perfRef/$name.ref PERF_TOLERANCE=$perfTolerance NO_STALL=yes"
+      val str = doCmd(testCmd + " BENCH=yes BENCH_STATS=yes" + perfArgs)
       assert(!str.contains("FAIL"))
       val intFind = "(\\d+\\.?)+".r
       val dmips = intFind.findFirstIn("DMIPS per Mhz\\:                              (\\d+.?)+".r.findAllIn(str).toList.last).get.toDouble
@@ -46,6 +60,15 @@ class DhrystoneBench extends AnyFunSuite {
       val coremarkHzs = intFind.findFirstIn("DCLOCKS_PER_SEC=(\\d+.?)+".r.findAllIn(str).toList.last).get.toDouble
       val coremarkPerMhz = 1e6 * coremarkIterations / coremarkTicks
       report ++= s"$name -> $dmips DMIPS/MHz $coremarkPerMhz Coremark/MHz\n"
+      for(m <- "DCACHE_STATS ((dhrystone|coremark)\\S*) .* mpki=(\\S+)".r.findAllMatchIn(str)) report ++= s"    ${m.group(1)} -> ${m.group(3)} data cache refills per 1000 instructions\n"
+
+      val tests = "BENCH_STATS (\\{\"test\": \"(dhrystone|coremark|bench|linux).*)".r.findAllMatchIn(str).map("    " + _.group(1)).mkString(",\n")
+      if(perfRecord) {
+        val cycles = "PERF_REF ((dhrystone|coremark|bench|linux)\\S*) (\\d+)".r.findAllMatchIn(str).map(m => m.group(1) -> m.group(3).toLong).toList
+        val bands = cycles.groupBy(_._1).toList.sortBy(_._1).map{case (test, values) => s"$test ${values.map(_._2).min} ${values.map(_._2).max}"}
+        FileUtils.writeStringToFile(perfRef, bands.mkString("", "\n", "\n"))
+      }
+      FileUtils.writeStringToFile(new File(resultsPath, name + ".json"), s"""{\n  "config": "$name",\n  "dmipsPerMhz": $dmips,\n  "coremarkPerMhz": $coremarkPerMhz,\n  "tests": [\n$tests\n  ]\n}\n""")
     }
 
   }
@@ -142,9 +165,23 @@ class DhrystoneBench extends AnyFunSuite {
   getDmips(
     name = "GenFullNoMmu",
     gen = GenFullNoMmu.main(null),
+    testCmd = "make clean run REDO=10 MMU=no CSR=no  COREMARK=yes DCACHE_STATS=yes"
+  )
+
+  //Same with the memory data stage and the fetch PC stage, to measure their DMIPS/MHz cost
+  getDmips(
+    name = "GenFullNoMmuDeep",
+    gen = GenFullNoMmuDeep.main(null),
     testCmd = "make clean run REDO=10 MMU=no CSR=no  COREMARK=yes"
   )
 
+  //Same direct mapped data cache with a 4 lines victim buffer, to compare their refills
+  getDmips(
+    name = "GenFullNoMmuVictim4",
+    gen = SpinalVerilog(GenFullNoMmu.cpu(victimLineCount = 4)),
+    testCmd = "make clean run REDO=10 MMU=no CSR=no  COREMARK=yes DCACHE_STATS=yes"
+  )
+
   getDmips(
     name = "GenFull",
     gen = GenFull.main(null),
@@ -154,7 +191,7 @@ class DhrystoneBench extends AnyFunSuite {
   getDmips(
     name = "GenLinuxBalenced",
     gen = LinuxGen.main(Array.fill[String](0)("")),
-    testCmd = "make clean run IBUS=CACHED DBUS=CACHED DEBUG_PLUGIN=STD DHRYSTONE=yes SUPERVISOR=yes MMU=no CSR=yes CSR_SKIP_TEST=yes  COMPRESSED=no MUL=yes DIV=yes LRSC=yes AMO=yes REDO=10 TRACE=no COREMARK=yes LINUX_REGRESSION=no"
+    testCmd = s"make clean run IBUS=CACHED DBUS=CACHED DEBUG_PLUGIN=STD DHRYSTONE=yes SUPERVISOR=yes MMU=no CSR=yes CSR_SKIP_TEST=yes  COMPRESSED=no MUL=yes DIV=yes LRSC=yes AMO=yes REDO=10 TRACE=no COREMARK=yes LINUX_REGRESSION=${if(linux) "yes" else "no"}"
   )
 
 
@@ -1,6 +1,6 @@
 package vexriscv
 
-import java.io.{File, OutputStream}
+import java.io.{ByteArrayOutputStream, File, OutputStream}
 import java.util.concurrent.{ForkJoinPool, TimeUnit}
 import org.apache.commons.io.FileUtils
 import org.scalatest.{BeforeAndAfterAll, ParallelTestExecution, Tag, Transformer}
@@ -57,6 +57,7 @@ object VexRiscvUniverse{
   val SUPERVISOR = new VexRiscvUniverse
   val NO_WRITEBACK = new VexRiscvUniverse
   val NO_MEMORY = new VexRiscvUniverse
+  val MEMORY_DATA = new VexRiscvUniverse
   val EXECUTE_RF = new VexRiscvUniverse
 }
 
@@ -382,9 +383,12 @@ class IBusDimension(rvcRate : Double) extends VexRiscvDimension("IBus") {
         cacheSize = 512 << r.nextInt(5)
         wayCount = 1 << r.nextInt(3)
       }while(cacheSize/wayCount < 512 || (catchAll && cacheSize/wayCount > 4096))
+      val wayPrediction = wayCount > 1 && !twoCycleRam && !reducedBankWidth && r.nextBoolean()
+      val criticalWordFirst = bytePerLine > memDataWidth/8 && r.nextBoolean()
+      val wayLocking = wayCount > 1 && r.nextBoolean()
 
-      new VexRiscvPosition(s"Cached${memDataWidth}d" + (if(twoCycleCache) "2cc" else "") + (if(injectorStage) "Injstage" else "") + (if(twoCycleRam) "2cr" else "")  + "S" + cacheSize + "W" + wayCount + "BPL" + bytePerLine + (if(relaxedPcCalculation) "Relax" else "") + (if(compressed) "Rvc" else "") + prediction.getClass.getTypeName().replace("$","")+ (if(tighlyCoupled)"Tc" else "") + (if(asyncTagMemory) "Atm" else "")) with InstructionAnticipatedPosition{
-        override def testParam = s"IBUS=CACHED IBUS_DATA_WIDTH=$memDataWidth" + (if(compressed) " COMPRESSED=yes" else "") + (if(tighlyCoupled)" IBUS_TC=yes" else "")
+      new VexRiscvPosition(s"Cached${memDataWidth}d" + (if(twoCycleCache) "2cc" else "") + (if(injectorStage) "Injstage" else "") + (if(twoCycleRam) "2cr" else "")  + "S" + cacheSize + "W" + wayCount + "BPL" + bytePerLine + (if(relaxedPcCalculation) "Relax" else "") + (if(compressed) "Rvc" else "") + prediction.getClass.getTypeName().replace("$","")+ (if(tighlyCoupled)"Tc" else "") + (if(asyncTagMemory) "Atm" else "") + (if(wayPrediction) "Wp" else "") + (if(criticalWordFirst) "Cwf" else "") + (if(wayLocking) "Wl" else "")) with InstructionAnticipatedPosition{
+        override def testParam = s"IBUS=CACHED IBUS_DATA_WIDTH=$memDataWidth" + (if(compressed) " COMPRESSED=yes" else "") + (if(tighlyCoupled)" IBUS_TC=yes" else "") + (if(wayLocking && !tighlyCoupled) " ICACHE_LOCK=yes" else "")
         override def applyOn(config: VexRiscvConfig): Unit = {
           val p = new IBusCachedPlugin(
             resetVector = 0x80000000l,
@@ -406,13 +410,18 @@ class IBusDimension(rvcRate : Double) extends VexRiscvDimension("IBus") {
               twoCycleRam = twoCycleRam,
               twoCycleCache = twoCycleCache,
               twoCycleRamInnerMux = twoCycleRamInnerMux,
-              reducedBankWidth = reducedBankWidth
+              reducedBankWidth = reducedBankWidth,
+              wayPrediction = wayPrediction,
+              criticalWordFirst = criticalWordFirst,
+              wayLocking = wayLocking
             )
           )
           if(tighlyCoupled) p.newTightlyCoupledPort(TightlyCoupledPortParameter("iBusTc", a => a(30 downto 28) === 0x0))
           config.plugins += p
         }
         override def instructionAnticipatedOk() = !twoCycleCache || ((!twoCycleRam || wayCount == 1) && !compressed)
+        //The lock CSRs are implemented through the CsrPlugin
+        override def isCompatibleWith(positions: Seq[ConfigPosition[VexRiscvConfig]]) = !wayLocking || positions.exists(_.isInstanceOf[CsrPluginPosition])
       }
     }
   }
@@ -467,8 +476,12 @@ class DBusDimension extends VexRiscvDimension("DBus") {
         cacheSize = 512 << r.nextInt(5)
         wayCount = 1 << r.nextInt(3)
       }while(cacheSize/wayCount < 512 || (catchAll && cacheSize/wayCount > 4096))
-      new VexRiscvPosition(s"Cached${memDataWidth}d${cpuDataWidth}c" + "S" + cacheSize + "W" + wayCount + "BPL" + bytePerLine + (if(dBusCmdMasterPipe) "Cmp " else "") + (if(dBusCmdSlavePipe) "Csp " else "") + (if(dBusRspSlavePipe) "Rsp " else "") + (if(relaxedMemoryTranslationRegister) "Rmtr " else "") + (if(earlyWaysHits) "Ewh " else "") + (if(withAmo) "Amo " else "") + (if(withSmp) "Smp " else "") + (if(directTlbHit) "Dtlb " else "") + (if(twoStageMmu) "Tsmmu " else "") + (if(asyncTagMemory) "Atm" else "")) {
-        override def testParam = s"DBUS=CACHED DBUS_LOAD_DATA_WIDTH=$memDataWidth DBUS_STORE_DATA_WIDTH=$cpuDataWidth " + (if(withLrSc) "LRSC=yes " else "")  + (if(withAmo) "AMO=yes " else "")  + (if(withSmp) "DBUS_EXCLUSIVE=yes DBUS_INVALIDATE=yes " else "")
+      val wayPrediction = wayCount > 1 && r.nextBoolean()
+      val victimLineCount = if(wayCount == 1 && r.nextBoolean()) List(2, 4, 8)(r.nextInt(3)) else 0
+      val criticalWordFirst = bytePerLine > memDataWidth/8 && victimLineCount == 0 && !withSmp && r.nextBoolean()
+      val withCacheBlockOps = r.nextBoolean()
+      new VexRiscvPosition(s"Cached${memDataWidth}d${cpuDataWidth}c" + "S" + cacheSize + "W" + wayCount + "BPL" + bytePerLine + (if(dBusCmdMasterPipe) "Cmp " else "") + (if(dBusCmdSlavePipe) "Csp " else "") + (if(dBusRspSlavePipe) "Rsp " else "") + (if(relaxedMemoryTranslationRegister) "Rmtr " else "") + (if(earlyWaysHits) "Ewh " else "") + (if(withAmo) "Amo " else "") + (if(withSmp) "Smp " else "") + (if(directTlbHit) "Dtlb " else "") + (if(twoStageMmu) "Tsmmu " else "") + (if(asyncTagMemory) "Atm" else "") + (if(wayPrediction) "Wp" else "") + (if(victimLineCount != 0) s"Vb$victimLineCount" else "") + (if(criticalWordFirst) "Cwf" else "") + (if(withCacheBlockOps) "Cbo" else "")) {
+        override def testParam = s"DBUS=CACHED DBUS_LOAD_DATA_WIDTH=$memDataWidth DBUS_STORE_DATA_WIDTH=$cpuDataWidth " + (if(withLrSc) "LRSC=yes " else "")  + (if(withAmo) "AMO=yes " else "")  + (if(withSmp) "DBUS_EXCLUSIVE=yes DBUS_INVALIDATE=yes " else "") + (if(withCacheBlockOps) "CBO=yes " else "")
 
         override def applyOn(config: VexRiscvConfig): Unit = {
           config.plugins += new DBusCachedPlugin(
@@ -488,7 +501,11 @@ class DBusDimension extends VexRiscvDimension("DBus") {
               withExclusive = withSmp,
               withInvalidate = withSmp,
               directTlbHit = directTlbHit,
-              asyncTagMemory = asyncTagMemory
+              asyncTagMemory = asyncTagMemory,
+              wayPrediction = wayPrediction,
+              victimLineCount = victimLineCount,
+              criticalWordFirst = criticalWordFirst,
+              withCacheBlockOps = withCacheBlockOps
             ),
             dBusCmdMasterPipe = dBusCmdMasterPipe,
             dBusCmdSlavePipe = dBusCmdSlavePipe,
@@ -517,25 +534,29 @@ class MmuPmpDimension extends VexRiscvDimension("DBus") {
         }
       }
     } else if (universes.contains(VexRiscvUniverse.PMP)) {
-      new VexRiscvPosition("WithPmp") {
+      val pipelined = r.nextBoolean() && !universes.contains(VexRiscvUniverse.NO_WRITEBACK)
+      new VexRiscvPosition("WithPmp" + (if(pipelined) "Pipelined" else "")) {
         override def testParam = "MMU=no PMP=yes"
 
         override def applyOn(config: VexRiscvConfig): Unit = {
           config.plugins += new PmpPlugin(
             regions = 16,
-            ioRange = _ (31 downto 28) === 0xF
+            ioRange = _ (31 downto 28) === 0xF,
+            pipelined = pipelined
           )
         }
       }
     } else if (universes.contains(VexRiscvUniverse.PMPNAPOT)) {
-      new VexRiscvPosition("WithPmpNapot") {
+      val pipelined = r.nextBoolean() && !universes.contains(VexRiscvUniverse.NO_WRITEBACK)
+      new VexRiscvPosition("WithPmpNapot" + (if(pipelined) "Pipelined" else "")) {
         override def testParam = "MMU=no PMP=yes"
 
         override def applyOn(config: VexRiscvConfig): Unit = {
           config.plugins += new PmpPluginNapot(
             regions = 16,
             granularity = 32,
-            ioRange = _ (31 downto 28) === 0xF
+            ioRange = _ (31 downto 28) === 0xF,
+            pipelined = pipelined
           )
         }
       }
@@ -556,6 +577,7 @@ class MmuPmpDimension extends VexRiscvDimension("DBus") {
 
 
 trait CatchAllPosition
+trait CsrPluginPosition
 
 
 class CsrDimension(freertos : String, zephyr : String, linux : String) extends VexRiscvDimension("Csr") {
@@ -564,22 +586,22 @@ class CsrDimension(freertos : String, zephyr : String, linux : String) extends V
     val catchAll = universes.contains(VexRiscvUniverse.CATCH_ALL)
     val supervisor = universes.contains(VexRiscvUniverse.SUPERVISOR)
     if(supervisor){
-      new VexRiscvPosition("Supervisor") with CatchAllPosition{
+      new VexRiscvPosition("Supervisor") with CatchAllPosition with CsrPluginPosition{
         override def applyOn(config: VexRiscvConfig): Unit = config.plugins += new CsrPlugin(CsrPluginConfig.linuxFull(0x80000020l))
         override def testParam = s"FREERTOS=$freertos ZEPHYR=$zephyr LINUX_REGRESSION=$linux SUPERVISOR=yes CSR=yes"
       }
     } else if(pmp){
-      new VexRiscvPosition("Secure") with CatchAllPosition{
+      new VexRiscvPosition("Secure") with CatchAllPosition with CsrPluginPosition{
         override def applyOn(config: VexRiscvConfig): Unit = config.plugins += new CsrPlugin(CsrPluginConfig.secure(0x80000020l))
         override def testParam = s"CSR=yes CSR_SKIP_TEST=yes FREERTOS=$freertos ZEPHYR=$zephyr"
       }
     } else if(catchAll){
-      new VexRiscvPosition("MachineOs") with CatchAllPosition{
+      new VexRiscvPosition("MachineOs") with CatchAllPosition with CsrPluginPosition{
         override def applyOn(config: VexRiscvConfig): Unit = config.plugins += new CsrPlugin(CsrPluginConfig.all(0x80000020l))
         override def testParam = s"CSR=yes CSR_SKIP_TEST=yes FREERTOS=$freertos ZEPHYR=$zephyr"
       }
     } else if(r.nextDouble() < 0.3){
-      new VexRiscvPosition("AllNoException") with CatchAllPosition{
+      new VexRiscvPosition("AllNoException") with CatchAllPosition with CsrPluginPosition{
         override def applyOn(config: VexRiscvConfig): Unit = config.plugins += new CsrPlugin(CsrPluginConfig.all(0x80000020l).noExceptionButEcall)
         override def testParam = s"CSR=yes CSR_SKIP_TEST=yes FREERTOS=$freertos ZEPHYR=$zephyr"
       }
@@ -602,6 +624,23 @@ class DebugDimension extends VexRiscvDimension("Debug") {
     new VexRiscvPosition("Enable") {
       override def applyOn(config: VexRiscvConfig): Unit = config.plugins += new DebugPlugin(ClockDomain.current.clone(reset = Bool().setName("debugReset")))
       override def testParam = "CONCURRENT_OS_EXECUTIONS=yes"
+    },
+    new VexRiscvPosition("EnableMemory") {
+      override def applyOn(config: VexRiscvConfig): Unit = config.plugins += new DebugPlugin(ClockDomain.current.clone(reset = Bool().setName("debugReset")), withMemoryAccess = true)
+      //Runs the DebugPluginTest and its memory accesses, on a free port as the configurations are tested concurrently
+      override def testParam = "DEBUG_PLUGIN=STD DEBUG_PLUGIN_PORT=0"
+    }
+  ))
+}
+
+class TraceDimension extends VexRiscvDimension("Trace") {
+
+  override def randomPositionImpl(universes: Seq[ConfigUniverse], r: Random) = random(r, List(
+    new VexRiscvPosition("None") {
+      override def applyOn(config: VexRiscvConfig): Unit = {}
+    },
+    new VexRiscvPosition("Enable") {
+      override def applyOn(config: VexRiscvConfig): Unit = config.plugins += new TracePlugin(fifoDepth = 4)
     }
   ))
 }
@@ -699,6 +738,117 @@ class FunTestPara extends MultithreadedFunSuite(3){
 //  (0 to 80).map(_.toString).foreach(createTest)
 //}
 
+//Random configuration sampling shared by the regression and the design space exploration
+object TestIndividualFeatures{
+  case class UniverseRates(linux : Double = 0.3,
+                           secure : Double = 0.2,
+                           machineOs : Double = 0.5,
+                           pmpNapot : Double = 0.5,
+                           demw : Double = 0.6,
+                           dem : Double = 0.5,
+                           memoryData : Double = 0.2)
+
+  def dimensions(rvcRate : Double, freertos : String, zephyr : String, linux : String) = List(
+    new IBusDimension(rvcRate),
+    new DBusDimension,
+    new MulDivDimension,
+    new ShiftDimension,
+    new BranchDimension,
+    new HazardDimension,
+    new RegFileDimension,
+    new SrcDimension,
+    new CsrDimension(freertos, zephyr, linux),
+    new DecoderDimension,
+    new DebugDimension,
+    new TraceDimension,
+    new MmuPmpDimension
+  )
+
+  def randomUniverse(rand : Random, rates : UniverseRates) : mutable.HashSet[VexRiscvUniverse] = {
+    import rates._
+    val universe = mutable.HashSet[VexRiscvUniverse]()
+    if(rand.nextDouble() < 0.5) universe += VexRiscvUniverse.EXECUTE_RF
+    if(linux > rand.nextDouble()) {
+      universe += VexRiscvUniverse.CATCH_ALL
+      universe += VexRiscvUniverse.MMU
+      universe += VexRiscvUniverse.FORCE_MULDIV
+      universe += VexRiscvUniverse.SUPERVISOR
+      if(demw < rand.nextDouble()){
+        universe += VexRiscvUniverse.NO_WRITEBACK
+      }
+    } else if (secure > rand.nextDouble()) {
+        universe += VexRiscvUniverse.CACHE_ALL
+        universe += VexRiscvUniverse.CATCH_ALL
+        if (pmpNapot > rand.nextDouble()) {
+          universe += VexRiscvUniverse.PMP
+        } else {
+          universe += VexRiscvUniverse.PMPNAPOT
+        }
+        if(demw < rand.nextDouble()){
+          universe += VexRiscvUniverse.NO_WRITEBACK
+        }
+    } else {
+      if(machineOs > rand.nextDouble()) {
+        universe += VexRiscvUniverse.CATCH_ALL
+        if(demw < rand.nextDouble()){
+          universe += VexRiscvUniverse.NO_WRITEBACK
+        }
+      }
+      if(demw > rand.nextDouble()){
+      }else if(dem > rand.nextDouble()){
+        universe += VexRiscvUniverse.NO_WRITEBACK
+      } else {
+        universe += VexRiscvUniverse.NO_WRITEBACK
+        universe += VexRiscvUniverse.NO_MEMORY
+      }
+    }
+
+    if(!universe.contains(VexRiscvUniverse.NO_WRITEBACK) && memoryData > rand.nextDouble()){
+      universe += VexRiscvUniverse.MEMORY_DATA
+    }
+    universe
+  }
+
+  def randomPositions(dimensions : Seq[VexRiscvDimension], universe : mutable.HashSet[VexRiscvUniverse], rand : Random) : List[VexRiscvPosition] = {
+    var positions : List[VexRiscvPosition] = null
+    do{
+      positions = dimensions.map(d => d.randomPosition(universe.toList, rand)).toList
+    }while(!positions.forall(_.isCompatibleWith(positions)))
+    positions
+  }
+
+  def configName(positions : Seq[VexRiscvPosition], universes : mutable.HashSet[VexRiscvUniverse]) : String = {
+    val noMemory = universes.contains(VexRiscvUniverse.NO_MEMORY)
+    val noWriteback = universes.contains(VexRiscvUniverse.NO_WRITEBACK)
+    val memoryData = universes.contains(VexRiscvUniverse.MEMORY_DATA)
+    (if(noMemory) "noMemoryStage_" else "") + (if(noWriteback) "noWritebackStage_" else "") + (if(memoryData) "memoryDataStage_" else "") + positions.map(d => d.dimension.name + "_" + d.name).mkString("_")
+  }
+
+  //Generate the VexRiscv.v and cpu0.yaml of the configuration in the given directory
+  def generateRtl(positions : Seq[VexRiscvPosition], universes : mutable.HashSet[VexRiscvUniverse], targetDirectory : String) : Unit = {
+    SpinalConfig(targetDirectory = targetDirectory).generateVerilog{
+      val config = VexRiscvConfig(
+        withMemoryStage = !universes.contains(VexRiscvUniverse.NO_MEMORY),
+        withWriteBackStage = !universes.contains(VexRiscvUniverse.NO_WRITEBACK),
+        plugins = List(
+          new IntAluPlugin,
+          new YamlPlugin("cpu0.yaml")
+        )
+      )
+      config.withMemoryDataStage = universes.contains(VexRiscvUniverse.MEMORY_DATA)
+      for (positionToApply <- positions) positionToApply.applyOn(config)
+      new VexRiscv(config)
+    }
+  }
+
+  //Copy the simulation sources in a project directory, which has to be two levels under the repository root
+  def setupRegressionWorkspace(project : String) : Unit = {
+    val files = List("main.cpp", "jtag.h", "dmi.h", "encoding.h" ,"makefile", "dhrystoneO3.logRef", "dhrystoneO3C.logRef","dhrystoneO3MC.logRef","dhrystoneO3M.logRef")
+    files.foreach(f => FileUtils.copyFileToDirectory(new File(s"src/test/cpp/regression/$f"), new File(project)))
+    synchronized(FileUtils.copyFileToDirectory(new File("src/test/cpp/common/trace.h"), new File(new File(project).getParentFile, "common")))
+  }
+}
+
 class TestIndividualFeatures extends MultithreadedFunSuite(sys.env.getOrElse("VEXRISCV_REGRESSION_THREAD_COUNT", "0").toInt) {
   val testCount = sys.env.getOrElse("VEXRISCV_REGRESSION_CONFIG_COUNT", "100").toInt
   val seed = sys.env.getOrElse("VEXRISCV_REGRESSION_SEED", Random.nextLong().toString).toLong
@@ -715,33 +865,37 @@ class TestIndividualFeatures extends MultithreadedFunSuite(sys.env.getOrElse("VE
   val zephyrCount = sys.env.getOrElse("VEXRISCV_REGRESSION_ZEPHYR_COUNT", "4")
   val demwRate = sys.env.getOrElse("VEXRISCV_REGRESSION_CONFIG_DEMW_RATE", "0.6").toDouble
   val demRate = sys.env.getOrElse("VEXRISCV_REGRESSION_CONFIG_DEM_RATE", "0.5").toDouble
+  val memoryDataRate = sys.env.getOrElse("VEXRISCV_REGRESSION_CONFIG_MEMORY_DATA_RATE", "0.2").toDouble
   val stopOnError = sys.env.getOrElse("VEXRISCV_REGRESSION_STOP_ON_ERROR", "no")
   val pmpNapotRate = sys.env.getOrElse("VEXRISCV_REGRESSION_CONFIG_PMP_NAPOT_RANGE", "0.5").toDouble
   val lock = new{}
 
 
 
-  val dimensions = List(
-    new IBusDimension(rvcRate),
-    new DBusDimension,
-    new MulDivDimension,
-    new ShiftDimension,
-    new BranchDimension,
-    new HazardDimension,
-    new RegFileDimension,
-    new SrcDimension,
-    new CsrDimension(/*sys.env.getOrElse("VEXRISCV_REGRESSION_FREERTOS_COUNT", "1")*/ "0", zephyrCount, linuxRegression), //Freertos old port software is broken
-    new DecoderDimension,
-    new DebugDimension,
-    new MmuPmpDimension
+  val rates = TestIndividualFeatures.UniverseRates(
+    linux = linuxRate,
+    secure = secureRate,
+    machineOs = machineOsRate,
+    pmpNapot = pmpNapotRate,
+    demw = demwRate,
+    dem = demRate,
+    memoryData = memoryDataRate
+  )
+
+  val dimensions = TestIndividualFeatures.dimensions(rvcRate, /*sys.env.getOrElse("VEXRISCV_REGRESSION_FREERTOS_COUNT", "1")*/ "0", zephyrCount, linuxRegression) //Freertos old port software is broken
+
+  val elaborationThreadCount = sys.env.getOrElse("VEXRISCV_REGRESSION_ELABORATION_THREAD_COUNT", "2").toInt
+  val buildCache = sys.env.getOrElse("VEXRISCV_REGRESSION_BUILD_CACHE", "no")
+
+  //The RTL generations run ahead in their own pool, overlapping the verilator builds and simulations of the previous tests
+  val elaborationEc = ExecutionContext.fromExecutorService(
+    new ForkJoinPool(elaborationThreadCount, ForkJoinPool.defaultForkJoinWorkerThreadFactory, null, true)
   )
 
   var clockCounter = 0l
   var startAt = System.currentTimeMillis()
   def doTest(positionsToApply : List[VexRiscvPosition], prefix : String = "", testSeed : Int, universes : mutable.HashSet[VexRiscvUniverse]): Unit ={
-    val noMemory = universes.contains(VexRiscvUniverse.NO_MEMORY)
-    val noWriteback = universes.contains(VexRiscvUniverse.NO_WRITEBACK)
-    val name = (if(noMemory) "noMemoryStage_" else "") + (if(noWriteback) "noWritebackStage_" else "") + positionsToApply.map(d => d.dimension.name + "_" + d.name).mkString("_")
+    val name = TestIndividualFeatures.configName(positionsToApply, universes)
     val workspace = "simWorkspace"
     val project = s"$workspace/$prefix"
     def doCmd(cmd: String): String = {
@@ -760,35 +914,33 @@ class TestIndividualFeatures extends MultithreadedFunSuite(sys.env.getOrElse("VE
       stdOut.toString()
     }
 
-    testMp(prefix + name) {
-      println("START TEST " + prefix + name)
+    val elaboration = Future {
+      val log = new ByteArrayOutputStream()
+      Console.withOut(log) {
+        Console.withErr(log) {
+          //Cleanup
+          FileUtils.deleteDirectory(new File(project))
+          FileUtils.forceMkdir(new File(project))
 
-      //Cleanup
-      FileUtils.deleteDirectory(new File(project))
-      FileUtils.forceMkdir(new File(project))
-
-      //Generate RTL
-      FileUtils.deleteQuietly(new File("VexRiscv.v"))
-      SpinalConfig(targetDirectory = project).generateVerilog{
-        val config = VexRiscvConfig(
-          withMemoryStage = !noMemory,
-          withWriteBackStage = !noWriteback,
-          plugins = List(
-            new IntAluPlugin,
-            new YamlPlugin("cpu0.yaml")
-          )
-        )
-        for (positionToApply <- positionsToApply) positionToApply.applyOn(config)
-        new VexRiscv(config)
+          //Generate RTL
+          FileUtils.deleteQuietly(new File("VexRiscv.v"))
+          TestIndividualFeatures.generateRtl(positionsToApply, universes, project)
+
+          //Setup test
+          TestIndividualFeatures.setupRegressionWorkspace(project)
+        }
       }
+      log.toString
+    }(elaborationEc)
 
-      //Setup test
-      val files = List("main.cpp", "jtag.h", "encoding.h" ,"makefile", "dhrystoneO3.logRef", "dhrystoneO3C.logRef","dhrystoneO3MC.logRef","dhrystoneO3M.logRef")
-      files.foreach(f => FileUtils.copyFileToDirectory(new File(s"src/test/cpp/regression/$f"), new File(project)))
+    testMp(prefix + name) {
+      println("START TEST " + prefix + name)
+      print(Await.result(elaboration, Duration.Inf))
 
       //Test RTL
       val debug = true
-      val stdCmd = (s"make run REGRESSION_PATH=../../src/test/cpp/regression VEXRISCV_FILE=VexRiscv.v WITH_USER_IO=no REDO=10 TRACE=${if(debug) "yes" else "no"} TRACE_START=100000000000ll FLOW_INFO=no STOP_ON_ERROR=$stopOnError DHRYSTONE=yes COREMARK=${coremarkRegression} THREAD_COUNT=1 ") + s" SEED=${testSeed} "
+      val cache = if(buildCache != "no") s" BUILD_CACHE=${new File(buildCache).getAbsolutePath}" else ""
+      val stdCmd = (s"make run REGRESSION_PATH=../../src/test/cpp/regression VEXRISCV_FILE=VexRiscv.v WITH_USER_IO=no REDO=10 TRACE=${if(debug) "yes" else "no"} TRACE_START=100000000000ll FLOW_INFO=no STOP_ON_ERROR=$stopOnError DHRYSTONE=yes COREMARK=${coremarkRegression} THREAD_COUNT=1 ") + s" SEED=${testSeed} " + cache
       val testCmd = stdCmd + (positionsToApply).map(_.testParam).mkString(" ")
       println(testCmd)
       val str = doCmd(testCmd)
@@ -807,47 +959,8 @@ class TestIndividualFeatures extends MultithreadedFunSuite(sys.env.getOrElse("VE
   }
   println(s"Seed=$seed")
   for(i <- 0 until testCount){
-    var positions : List[VexRiscvPosition] = null
-    var universe = mutable.HashSet[VexRiscvUniverse]()
-    if(rand.nextDouble() < 0.5) universe += VexRiscvUniverse.EXECUTE_RF
-    if(linuxRate > rand.nextDouble()) {
-      universe += VexRiscvUniverse.CATCH_ALL
-      universe += VexRiscvUniverse.MMU
-      universe += VexRiscvUniverse.FORCE_MULDIV
-      universe += VexRiscvUniverse.SUPERVISOR
-      if(demwRate < rand.nextDouble()){
-        universe += VexRiscvUniverse.NO_WRITEBACK
-      }
-    } else if (secureRate > rand.nextDouble()) {
-        universe += VexRiscvUniverse.CACHE_ALL
-        universe += VexRiscvUniverse.CATCH_ALL
-        if (pmpNapotRate > rand.nextDouble()) {
-          universe += VexRiscvUniverse.PMP
-        } else {
-          universe += VexRiscvUniverse.PMPNAPOT
-        }
-        if(demwRate < rand.nextDouble()){
-          universe += VexRiscvUniverse.NO_WRITEBACK
-        }
-    } else {
-      if(machineOsRate > rand.nextDouble()) {
-        universe += VexRiscvUniverse.CATCH_ALL
-        if(demwRate < rand.nextDouble()){
-          universe += VexRiscvUniverse.NO_WRITEBACK
-        }
-      }
-      if(demwRate > rand.nextDouble()){
-      }else if(demRate > rand.nextDouble()){
-        universe += VexRiscvUniverse.NO_WRITEBACK
-      } else {
-        universe += VexRiscvUniverse.NO_WRITEBACK
-        universe += VexRiscvUniverse.NO_MEMORY
-      }
-    }
-
-    do{
-      positions = dimensions.map(d => d.randomPosition(universe.toList, rand))
-    }while(!positions.forall(_.isCompatibleWith(positions)))
+    val universe = TestIndividualFeatures.randomUniverse(rand, rates)
+    val positions = TestIndividualFeatures.randomPositions(dimensions, universe, rand)
 
     val testSeed = rand.nextInt()
     if(testId.contains(i))